@@ -1616,6 +1616,61 @@ Future<REPLY_TYPE(Request)> loadBalance(
 }
 } // namespace
 
+ACTOR Future<GetValuesReply> sendGetValuesBatch(Database cx,
+                                                std::shared_ptr<GetValuesBatch> batch,
+                                                Reference<LocationInfo> locations,
+                                                Version version,
+                                                Optional<TagSet> tags,
+                                                Optional<ReadOptions> readOptions,
+                                                VersionVector ssLatestCommitVersions,
+                                                SpanContext spanContext,
+                                                TaskPriority taskID) {
+	// Give the reads issued along with the first one the chance to join the batch
+	wait(delay(0, taskID));
+	batch->sent = true;
+	GetValuesReply reply =
+	    wait(loadBalance(cx.getPtr(),
+	                     locations,
+	                     &StorageServerInterface::getValues,
+	                     GetValuesRequest(spanContext, batch->keys, version, tags, readOptions, ssLatestCommitVersions),
+	                     TaskPriority::DefaultPromiseEndpoint,
+	                     AtMostOnce::False,
+	                     cx->enableLocalityLoadBalance ? &cx->queueModel : nullptr));
+	return reply;
+}
+
+// Adds the read of key to the transaction's batch of reads to the storage servers of locations. A wrong_shard_server
+// for any key of a batch fails the reads of all its keys, which then refresh their locations and retry as usual.
+Future<GetValueReply> getValueInBatch(Reference<TransactionState> const& trState,
+                                      Reference<LocationInfo> const& locations,
+                                      Key const& key,
+                                      VersionVector const& ssLatestCommitVersions,
+                                      SpanContext const& spanContext) {
+	std::vector<UID> team;
+	team.reserve(locations->size());
+	for (int i = 0; i < locations->size(); i++) {
+		team.push_back(locations->getId(i));
+	}
+	std::sort(team.begin(), team.end());
+
+	auto& [batch, reply] = trState->getValuesBatches[team];
+	if (!batch || batch->sent || batch->keys.size() >= CLIENT_KNOBS->GET_VALUES_BATCH_MAX_KEYS) {
+		batch = std::make_shared<GetValuesBatch>();
+		reply = sendGetValuesBatch(trState->cx,
+		                           batch,
+		                           locations,
+		                           trState->readVersion(),
+		                           trState->cx->sampleReadTags() ? trState->options.readTags : Optional<TagSet>(),
+		                           trState->readOptions,
+		                           ssLatestCommitVersions,
+		                           spanContext,
+		                           trState->taskID);
+	}
+	int index = batch->keys.size();
+	batch->keys.push_back_deep(batch->keys.arena(), key);
+	return map(reply, [index](GetValuesReply const& r) { return GetValueReply(r.values[index], r.cached); });
+}
+
 ACTOR Future<Optional<Value>> getValue(Reference<TransactionState> trState,
                                        Key key,
                                        TransactionRecordLogInfo recordLogInfo) {
@@ -1652,6 +1707,10 @@ ACTOR Future<Optional<Value>> getValue(Reference<TransactionState> trState,
 				    .detail("Servers", describe(ssi.second->get()));*/
 			}
 
+			// Reads that are traced or checked against every replica are sent on their own
+			state bool batched = CLIENT_KNOBS->GET_VALUES_BATCH_MAX_KEYS > 1 && !getValueID.present() &&
+			                     !trState->options.enableReplicaConsistencyCheck;
+
 			++trState->cx->getValueSubmitted;
 			startTime = timer_int();
 			startTimeD = now();
@@ -1668,21 +1727,25 @@ ACTOR Future<Optional<Value>> getValue(Reference<TransactionState> trState,
 						throw transaction_too_old();
 					}
 					when(GetValueReply _reply = wait(
-					         loadBalance(trState->cx.getPtr(),
-					                     locationInfo.locations,
-					                     &StorageServerInterface::getValue,
-					                     GetValueRequest(span.context,
-					                                     key,
-					                                     trState->readVersion(),
-					                                     trState->cx->sampleReadTags() ? trState->options.readTags
-					                                                                   : Optional<TagSet>(),
-					                                     readOptions,
-					                                     ssLatestCommitVersions),
-					                     TaskPriority::DefaultPromiseEndpoint,
-					                     AtMostOnce::False,
-					                     trState->cx->enableLocalityLoadBalance ? &trState->cx->queueModel : nullptr,
-					                     trState->options.enableReplicaConsistencyCheck,
-					                     trState->options.requiredReplicas))) {
+					         batched ? getValueInBatch(
+					                       trState, locationInfo.locations, key, ssLatestCommitVersions, span.context)
+					                 : loadBalance(trState->cx.getPtr(),
+					                               locationInfo.locations,
+					                               &StorageServerInterface::getValue,
+					                               GetValueRequest(span.context,
+					                                               key,
+					                                               trState->readVersion(),
+					                                               trState->cx->sampleReadTags()
+					                                                   ? trState->options.readTags
+					                                                   : Optional<TagSet>(),
+					                                               readOptions,
+					                                               ssLatestCommitVersions),
+					                               TaskPriority::DefaultPromiseEndpoint,
+					                               AtMostOnce::False,
+					                               trState->cx->enableLocalityLoadBalance ? &trState->cx->queueModel
+					                                                                      : nullptr,
+					                               trState->options.enableReplicaConsistencyCheck,
+					                               trState->options.requiredReplicas))) {
 						reply = _reply;
 					}
 				}
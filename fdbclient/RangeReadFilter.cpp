@@ -0,0 +1,147 @@
+/*
+ * RangeReadFilter.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/RangeReadFilter.h"
+#include "fdbclient/Tuple.h"
+#include "flow/UnitTest.h"
+
+namespace {
+
+bool keyMatchesPattern(KeyRef key, StringRef pattern, StringRef mask) {
+	if (key.size() < pattern.size()) {
+		return false;
+	}
+	for (int i = 0; i < pattern.size(); i++) {
+		uint8_t m = i < mask.size() ? mask[i] : 0xff;
+		if ((key[i] & m) != pattern[i]) {
+			return false;
+		}
+	}
+	return true;
+}
+
+bool compareElement(StringRef element, uint8_t op, StringRef operand) {
+	int c = element.compare(operand);
+	switch (op) {
+	case TupleElementPredicateRef::EQ:
+		return c == 0;
+	case TupleElementPredicateRef::NE:
+		return c != 0;
+	case TupleElementPredicateRef::LT:
+		return c < 0;
+	case TupleElementPredicateRef::LE:
+		return c <= 0;
+	case TupleElementPredicateRef::GT:
+		return c > 0;
+	case TupleElementPredicateRef::GE:
+		return c >= 0;
+	default:
+		return false;
+	}
+}
+
+// Unpacks s into tuple once, on first use. Returns false if s is not a tuple.
+bool unpackOnce(StringRef s, Optional<Tuple>& tuple, bool& invalid) {
+	if (!tuple.present() && !invalid) {
+		try {
+			// Incomplete trailing elements are dropped rather than compared
+			tuple = Tuple::unpack(s, true);
+		} catch (Error&) {
+			invalid = true;
+		}
+	}
+	return tuple.present();
+}
+
+} // namespace
+
+bool RangeReadFilterRef::matches(KeyValueRef const& kv) const {
+	if (kv.value.size() < minValueLength || kv.value.size() > maxValueLength) {
+		return false;
+	}
+	if (!keyMatchesPattern(kv.key, keyPattern, keyMask)) {
+		return false;
+	}
+
+	Optional<Tuple> keyTuple, valueTuple;
+	bool keyInvalid = false, valueInvalid = false;
+	for (const auto& p : tuplePredicates) {
+		Optional<Tuple>& t = p.onValue ? valueTuple : keyTuple;
+		if (!unpackOnce(p.onValue ? kv.value : kv.key, t, p.onValue ? valueInvalid : keyInvalid)) {
+			return false;
+		}
+		if (p.index < 0 || (size_t)p.index >= t.get().size()) {
+			return false;
+		}
+		if (!compareElement(t.get().subTupleRawString(p.index), p.op, p.operand)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+TEST_CASE("/fdbclient/RangeReadFilter/matches") {
+	Arena a;
+	Key row1 = Tuple::makeTuple("idx"_sr, 10, "alice"_sr).pack();
+	Key row2 = Tuple::makeTuple("idx"_sr, 20, "bob"_sr).pack();
+	Key other = Tuple::makeTuple("other"_sr, 20).pack();
+	Value tupleValue = Tuple::makeTuple(5).pack();
+
+	RangeReadFilterRef f;
+	ASSERT(f.matches(KeyValueRef(row1, "v"_sr)));
+	ASSERT(f.matches(KeyValueRef("not a tuple \xff"_sr, ""_sr)));
+
+	// Key pattern as a plain prefix, then with a mask ignoring the second byte
+	f.keyPattern = StringRef(a, Tuple::makeTuple("idx"_sr).pack());
+	ASSERT(f.matches(KeyValueRef(row1, "v"_sr)));
+	ASSERT(!f.matches(KeyValueRef(other, "v"_sr)));
+	ASSERT(!f.matches(KeyValueRef("\x02"_sr, "v"_sr)));
+	f.keyPattern = "\x02\x00"_sr;
+	f.keyMask = "\xff\x00"_sr;
+	ASSERT(f.matches(KeyValueRef(row1, "v"_sr)));
+	ASSERT(f.matches(KeyValueRef(other, "v"_sr)));
+	f.keyPattern = StringRef();
+	f.keyMask = StringRef();
+
+	// Tuple element comparisons on the key and the value
+	f.tuplePredicates.push_back(
+	    a, TupleElementPredicateRef(a, false, 1, TupleElementPredicateRef::GT, Tuple::makeTuple(15).pack()));
+	ASSERT(!f.matches(KeyValueRef(row1, "v"_sr)));
+	ASSERT(f.matches(KeyValueRef(row2, "v"_sr)));
+	ASSERT(!f.matches(KeyValueRef("not a tuple \xff"_sr, "v"_sr)));
+	f.tuplePredicates.push_back(
+	    a, TupleElementPredicateRef(a, true, 0, TupleElementPredicateRef::LE, Tuple::makeTuple(5).pack()));
+	ASSERT(f.matches(KeyValueRef(row2, tupleValue)));
+	ASSERT(!f.matches(KeyValueRef(row2, Tuple::makeTuple(6).pack())));
+	ASSERT(!f.matches(KeyValueRef(row2, "v"_sr)));
+	f.tuplePredicates.push_back(
+	    a, TupleElementPredicateRef(a, false, 3, TupleElementPredicateRef::NE, Tuple::makeTuple(0).pack()));
+	ASSERT(!f.matches(KeyValueRef(row2, tupleValue)));
+	f.tuplePredicates = VectorRef<TupleElementPredicateRef>();
+
+	// Value length limits
+	f.minValueLength = 2;
+	f.maxValueLength = 3;
+	ASSERT(!f.matches(KeyValueRef(row1, "v"_sr)));
+	ASSERT(f.matches(KeyValueRef(row1, "vvv"_sr)));
+	ASSERT(!f.matches(KeyValueRef(row1, "vvvv"_sr)));
+
+	return Void();
+}
@@ -74,23 +74,33 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( TLOG_MESSAGE_BLOCK_OVERHEAD_FACTOR,      double(TLOG_MESSAGE_BLOCK_BYTES) / (TLOG_MESSAGE_BLOCK_BYTES - MAX_MESSAGE_SIZE) ); //1.0121466709838096006362758832473
 	init( PEEK_TRACKER_EXPIRATION_TIME,                          600 ); if( randomize && BUGGIFY ) PEEK_TRACKER_EXPIRATION_TIME = 120; // Cannot be buggified lower without changing the following assert in LogSystemPeekCursor.actor.cpp: ASSERT_WE_THINK(e.code() == error_code_operation_obsolete || SERVER_KNOBS->PEEK_TRACKER_EXPIRATION_TIME < 10);
 	init( PEEK_USING_STREAMING,                                false ); if( randomize && isSimulated && BUGGIFY ) PEEK_USING_STREAMING = true;
+	init( PEEK_STREAM_BUFFER_BYTES,               MAXIMUM_PEEK_BYTES ); if( randomize && BUGGIFY ) PEEK_STREAM_BUFFER_BYTES = deterministicRandom()->randomInt(1, 4) * DESIRED_TOTAL_BYTES;
+	init( TLOG_PEEK_STREAM_MEMORY_BYTES,                           0 ); if( randomize && BUGGIFY ) TLOG_PEEK_STREAM_MEMORY_BYTES = 1e6;
+	init( TLOG_PEEK_STREAM_PREFETCH,                           false ); if( randomize && BUGGIFY ) TLOG_PEEK_STREAM_PREFETCH = true;
 	init( PARALLEL_GET_MORE_REQUESTS,                             32 ); if( randomize && BUGGIFY ) PARALLEL_GET_MORE_REQUESTS = 2;
 	init( MULTI_CURSOR_PRE_FETCH_LIMIT,                           10 );
 	init( MAX_QUEUE_COMMIT_BYTES,                               15e6 ); if( randomize && BUGGIFY ) MAX_QUEUE_COMMIT_BYTES = 5000;
+	init( TLOG_QUEUE_COMMIT_COALESCE_DELAY,                      0.0 ); if( randomize && BUGGIFY ) TLOG_QUEUE_COMMIT_COALESCE_DELAY = deterministicRandom()->random01() * 0.002;
 	init( DESIRED_OUTSTANDING_MESSAGES,                         5000 ); if( randomize && BUGGIFY ) DESIRED_OUTSTANDING_MESSAGES = deterministicRandom()->randomInt(0,100);
 	init( DESIRED_GET_MORE_DELAY,                              0.005 );
 	init( CONCURRENT_LOG_ROUTER_READS,                             5 ); if( randomize && BUGGIFY ) CONCURRENT_LOG_ROUTER_READS = 1;
 	init( LOG_ROUTER_PEEK_FROM_SATELLITES_PREFERRED,               1 ); if( randomize && BUGGIFY ) LOG_ROUTER_PEEK_FROM_SATELLITES_PREFERRED = 0;
 	init( LOG_ROUTER_PEEK_SWITCH_DC_TIME,                       60.0 );
 	init( LOG_ROUTER_REPLACEMENT_GRACE_PERIOD,                  30.0 );
+	init( LOG_ROUTER_CACHE_BYTES,                                  0 ); if( randomize && BUGGIFY ) LOG_ROUTER_CACHE_BYTES = deterministicRandom()->randomInt(1, 100) * 1e6;
 	init( DISK_QUEUE_ADAPTER_MIN_SWITCH_TIME,                    1.0 );
 	init( DISK_QUEUE_ADAPTER_MAX_SWITCH_TIME,                    5.0 );
 	init( TLOG_SPILL_REFERENCE_MAX_PEEK_MEMORY_BYTES,            2e9 ); if ( randomize && BUGGIFY ) TLOG_SPILL_REFERENCE_MAX_PEEK_MEMORY_BYTES = 2e6;
 	init( TLOG_SPILL_REFERENCE_MAX_BATCHES_PER_PEEK,           100 ); if ( randomize && BUGGIFY ) TLOG_SPILL_REFERENCE_MAX_BATCHES_PER_PEEK = 1;
 	init( TLOG_SPILL_REFERENCE_MAX_BYTES_PER_BATCH,           16<<10 ); if ( randomize && BUGGIFY ) TLOG_SPILL_REFERENCE_MAX_BYTES_PER_BATCH = 500;
+	init( TLOG_PEEK_SPILLED_COMMIT_INDEXES,                        0 ); if ( randomize && BUGGIFY ) TLOG_PEEK_SPILLED_COMMIT_INDEXES = deterministicRandom()->randomInt(1, 100);
+	init( TLOG_QUEUE_COMPRESSION_FILTER,                      "NONE" ); //cannot buggify because downgrade restarting tests reopen the queue with binaries that cannot read compressed entries
+	init( TLOG_QUEUE_COMPRESSION_MIN_BYTES,                     4096 ); if ( randomize && BUGGIFY ) TLOG_QUEUE_COMPRESSION_MIN_BYTES = deterministicRandom()->randomInt(0, 1000);
 	init( DISK_QUEUE_FILE_EXTENSION_BYTES,                    10<<20 ); // BUGGIFYd per file within the DiskQueue
 	init( DISK_QUEUE_FILE_SHRINK_BYTES,                      100<<20 ); // BUGGIFYd per file within the DiskQueue
 	init( DISK_QUEUE_MAX_TRUNCATE_BYTES,                     2LL<<30 ); if ( randomize && BUGGIFY ) DISK_QUEUE_MAX_TRUNCATE_BYTES = 0;
+	init( DISK_QUEUE_BUFFER_POOL_BYTES,                            0 ); if ( randomize && BUGGIFY ) DISK_QUEUE_BUFFER_POOL_BYTES = deterministicRandom()->randomInt(1, 64) * 1e6;
+	init( DISK_QUEUE_BUFFER_POOL_HUGE_PAGES,                   false ); if ( randomize && BUGGIFY ) DISK_QUEUE_BUFFER_POOL_HUGE_PAGES = true;
 	init( TLOG_DEGRADED_DURATION,                                5.0 );
 	init( TLOG_IGNORE_POP_AUTO_ENABLE_DELAY,                   300.0 );
 	init( TXS_POPPED_MAX_DELAY,                                  1.0 ); if ( randomize && BUGGIFY ) TXS_POPPED_MAX_DELAY = deterministicRandom()->random01();
@@ -694,6 +704,9 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( TAG_THROTTLE_MAX_EMPTY_QUEUE_BUDGET,                1000.0 );
 	init( START_TRANSACTION_MAX_QUEUE_SIZE,                      1e6 ); if ( randomize && BUGGIFY ) START_TRANSACTION_MAX_QUEUE_SIZE = 1000;
 	init( KEY_LOCATION_MAX_QUEUE_SIZE,                           1e6 );
+	init( GRV_PROXY_COALESCE_MASTER_REQUESTS,                  false ); if ( randomize && BUGGIFY ) GRV_PROXY_COALESCE_MASTER_REQUESTS = true;
+	init( GRV_PROXY_MAX_OUTSTANDING_MASTER_REQUESTS,               4 ); if ( randomize && BUGGIFY ) GRV_PROXY_MAX_OUTSTANDING_MASTER_REQUESTS = deterministicRandom()->randomInt(1, 4);
+	init( GRV_PROXY_CAUSAL_READ_RISKY_MAX_STALENESS,             0.0 );
 
 	init( COMMIT_PROXY_LIVENESS_TIMEOUT,                        20.0 );
 	init( COMMIT_PROXY_MAX_LIVENESS_TIMEOUT,                   600.0 ); if ( randomize && BUGGIFY ) COMMIT_PROXY_MAX_LIVENESS_TIMEOUT = 20.0;
@@ -704,6 +717,14 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION,     0.1 );
 	init( COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA,       0.1 );
 	init( COMMIT_TRANSACTION_BATCH_COUNT_MAX,                   32768 ); if( randomize && BUGGIFY ) COMMIT_TRANSACTION_BATCH_COUNT_MAX = 1000; // Do NOT increase this number beyond 32768, as CommitIds only budget 2 bytes for storing transaction id within each batch
+	init( COMMIT_TRANSACTION_BATCH_COUNT_MIN,                     100 ); if( randomize && BUGGIFY ) COMMIT_TRANSACTION_BATCH_COUNT_MIN = 1;
+	init( COMMIT_BATCH_TARGET_P99_LATENCY,                        0.0 ); if( randomize && BUGGIFY ) COMMIT_BATCH_TARGET_P99_LATENCY = deterministicRandom()->random01() * 0.1; // When positive, batching intervals and sizes follow this target instead of COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION
+	init( COMMIT_BATCH_CONTROLLER_WINDOW,                         200 ); if( randomize && BUGGIFY ) COMMIT_BATCH_CONTROLLER_WINDOW = 10;
+	init( COMMIT_BATCH_CONTROLLER_GAIN,                           0.2 );
+	init( PROXY_SHARD_LOOKUP_THREADS,                               1 ); if( randomize && BUGGIFY ) PROXY_SHARD_LOOKUP_THREADS = deterministicRandom()->randomInt(2, 9);
+	init( PROXY_SHARD_LOOKUP_MIN_MUTATIONS,                     10000 ); if( randomize && BUGGIFY ) PROXY_SHARD_LOOKUP_MIN_MUTATIONS = deterministicRandom()->randomInt(1, 100);
+	init( PROXY_KEY_INFO_INDEX,                                 false ); if( randomize && BUGGIFY ) PROXY_KEY_INFO_INDEX = true;
+	init( PROXY_REFERENCE_VALUES_MIN_BYTES,                         0 ); if( randomize && BUGGIFY ) PROXY_REFERENCE_VALUES_MIN_BYTES = deterministicRandom()->randomInt(1, 1000);
 	init( COMMIT_BATCHES_MEM_BYTES_HARD_LIMIT,              8LL << 30 ); if (randomize && BUGGIFY) COMMIT_BATCHES_MEM_BYTES_HARD_LIMIT = deterministicRandom()->randomInt64(100LL << 20,  8LL << 30);
 	init( COMMIT_BATCHES_MEM_FRACTION_OF_TOTAL,                   0.5 );
 	init( COMMIT_BATCHES_MEM_TO_TOTAL_MEM_SCALE_FACTOR,           5.0 );
@@ -775,6 +796,12 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( SAMPLE_EXPIRATION_TIME,                                1.0 );
 	init( SAMPLE_POLL_TIME,                                      0.1 );
 	init( RESOLVER_STATE_MEMORY_LIMIT,                           1e6 );
+	init( RESOLVER_CONFLICT_SET_TYPE,                     "skiplist" ); if( randomize && BUGGIFY ) RESOLVER_CONFLICT_SET_TYPE = "btree";
+	init( RESOLVER_CONFLICT_CHECK_THREADS,                         1 ); if( randomize && BUGGIFY ) RESOLVER_CONFLICT_CHECK_THREADS = deterministicRandom()->randomInt(2, 9);
+	init( RESOLVER_CONFLICT_CHECK_MIN_RANGES,                   2000 ); if( randomize && BUGGIFY ) RESOLVER_CONFLICT_CHECK_MIN_RANGES = deterministicRandom()->randomInt(1, 100);
+	init( RESOLVER_PREPARE_BATCH_EARLY,                         true ); if( randomize && BUGGIFY ) RESOLVER_PREPARE_BATCH_EARLY = false;
+	init( RESOLVER_CONFLICT_FILTER_SLOTS,                          0 ); if( randomize && BUGGIFY ) RESOLVER_CONFLICT_FILTER_SLOTS = 1 << deterministicRandom()->randomInt(3, 17);
+	init( RESOLVER_CONFLICT_FILTER_PREFIX_LENGTH,                 16 ); if( randomize && BUGGIFY ) RESOLVER_CONFLICT_FILTER_PREFIX_LENGTH = deterministicRandom()->randomInt(1, 32);
 	init( LAST_LIMITED_RATIO,                                    2.0 );
 
 	// Backup Worker
@@ -1036,6 +1063,8 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( FETCH_BLOCK_BYTES,                                     2e6 );
 	init( FETCH_KEYS_PARALLELISM_BYTES,                          4e6 ); if( randomize && BUGGIFY ) FETCH_KEYS_PARALLELISM_BYTES = 3e6;
 	init( FETCH_KEYS_PARALLELISM,                                  2 );
+	init( FETCH_KEYS_PARALLEL_RANGES,                              4 ); if( randomize && BUGGIFY ) FETCH_KEYS_PARALLEL_RANGES = deterministicRandom()->randomInt(1, 9);
+	init( FETCH_KEYS_PARALLEL_RANGE_BYTES,                      20e6 ); if( randomize && BUGGIFY ) FETCH_KEYS_PARALLEL_RANGE_BYTES = deterministicRandom()->randomInt(1e4, 1e6);
 	init( FETCH_KEYS_LOWER_PRIORITY,                               0 );
 	init( SERVE_FETCH_CHECKPOINT_PARALLELISM,                      4 );
 	init( SERVE_AUDIT_STORAGE_PARALLELISM,                         1 );
@@ -1061,6 +1090,9 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( STORAGE_DURABILITY_LAG_REJECT_THRESHOLD,              0.25 );
 	init( STORAGE_DURABILITY_LAG_MIN_RATE,                       0.1 );
 	init( STORAGE_COMMIT_INTERVAL,                               0.5 ); if( randomize && BUGGIFY ) STORAGE_COMMIT_INTERVAL = 2.0;
+	init( STORAGE_VERSIONED_MAP_BTREE,                         false ); if( randomize && BUGGIFY ) STORAGE_VERSIONED_MAP_BTREE = true;
+	init( STORAGE_VALUE_CACHE_BYTES,                               0 ); if( randomize && BUGGIFY ) STORAGE_VALUE_CACHE_BYTES = deterministicRandom()->randomInt(1, 1e6);
+	init( STORAGE_COALESCE_WRITE_BYTES,                            0 ); if( randomize && BUGGIFY ) STORAGE_COALESCE_WRITE_BYTES = deterministicRandom()->randomInt(1, 1e6);
 
 	// Constants which affect the fraction of data which is sampled
 	// by storage severs to estimate key-range sizes and splits.
@@ -1107,6 +1139,7 @@ void ServerKnobs::initialize(Randomize randomize, ClientKnobs* clientKnobs, IsSi
 	init( STRICTLY_ENFORCE_BYTE_LIMIT,                          false); if( randomize && BUGGIFY ) STRICTLY_ENFORCE_BYTE_LIMIT = deterministicRandom()->coinflip();
 	init( FRACTION_INDEX_BYTELIMIT_PREFETCH,                      0.2); if( randomize && BUGGIFY ) FRACTION_INDEX_BYTELIMIT_PREFETCH = 0.01 + deterministicRandom()->random01();
 	init( MAX_PARALLEL_QUICK_GET_VALUE,                           10 ); if ( randomize && BUGGIFY ) MAX_PARALLEL_QUICK_GET_VALUE = deterministicRandom()->randomInt(1, 100);
+	init( QUICK_GET_VALUE_BATCH_LOCAL,                          true ); if ( randomize && BUGGIFY ) QUICK_GET_VALUE_BATCH_LOCAL = deterministicRandom()->coinflip();
 	init( QUICK_GET_KEY_VALUES_LIMIT,                           2000 );
 	init( QUICK_GET_KEY_VALUES_LIMIT_BYTES,                      1e7 );
 	// Read priority definitions in the form of a list of their relative concurrency share weights
@@ -60,6 +60,36 @@ void TSS_traceMismatch(TraceEvent& event,
 	            tss.value.present() ? traceChecksumValue(tss.value.get()) : "missing");
 }
 
+// batched point reads
+template <>
+bool TSS_doCompare(const GetValuesReply& src, const GetValuesReply& tss) {
+	return src.values == tss.values;
+}
+
+template <>
+const char* LB_mismatchTraceName(const GetValuesRequest& req, const ComparisonType& type) {
+	return type == TSS_COMPARISON ? "TSSMismatchGetValues" : "ReplicaMismatchGetValues";
+}
+
+template <>
+void TSS_traceMismatch(TraceEvent& event,
+                       const GetValuesRequest& req,
+                       const GetValuesReply& src,
+                       const GetValuesReply& tss,
+                       const ComparisonType& type) {
+	event.detail("Keys", req.keys.size()).detail("Version", req.version);
+	for (int i = 0; i < req.keys.size() && i < src.values.size() && i < tss.values.size(); i++) {
+		if (src.values[i] != tss.values[i]) {
+			event.detail("Key", req.keys[i])
+			    .detail(type == TSS_COMPARISON ? "SSReply" : "SourceSSReply",
+			            src.values[i].present() ? traceChecksumValue(src.values[i].get()) : "missing")
+			    .detail(type == TSS_COMPARISON ? "TSSReply" : "ReplicaSSReply",
+			            tss.values[i].present() ? traceChecksumValue(tss.values[i].get()) : "missing");
+			break;
+		}
+	}
+}
+
 // key selector reads
 template <>
 bool TSS_doCompare(const GetKeyReply& src, const GetKeyReply& tss) {
@@ -423,6 +453,12 @@ void TSSMetrics::recordLatency(const GetValueRequest& req, double ssLatency, dou
 	TSSgetValueLatency.addSample(tssLatency);
 }
 
+template <>
+void TSSMetrics::recordLatency(const GetValuesRequest& req, double ssLatency, double tssLatency) {
+	SSgetValueLatency.addSample(ssLatency);
+	TSSgetValueLatency.addSample(tssLatency);
+}
+
 template <>
 void TSSMetrics::recordLatency(const GetKeyRequest& req, double ssLatency, double tssLatency) {
 	SSgetKeyLatency.addSample(ssLatency);
@@ -486,6 +522,13 @@ TEST_CASE("/StorageServerInterface/TSSCompare/TestComparison") {
 	ASSERT(!TSS_doCompare(gvReplyMissing, gvReplyA));
 	ASSERT(!TSS_doCompare(gvReplyA, gvReplyB));
 
+	// test GetValues
+	GetValuesReply gvsReplyAB({ Optional<Value>(StringRef(s_a)), Optional<Value>(StringRef(s_b)) }, false);
+	GetValuesReply gvsReplyAMissing({ Optional<Value>(StringRef(s_a)), Optional<Value>() }, false);
+	ASSERT(TSS_doCompare(gvsReplyAB, gvsReplyAB));
+	ASSERT(TSS_doCompare(gvsReplyAMissing, gvsReplyAMissing));
+	ASSERT(!TSS_doCompare(gvsReplyAB, gvsReplyAMissing));
+
 	// test GetKeyValues
 	Arena a;
 	GetKeyValuesReply gkvReplyEmpty;
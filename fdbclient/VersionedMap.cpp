@@ -74,4 +74,122 @@ TEST_CASE("performance/map/StringRef/VersionedMap") {
 	return Void();
 }
 
+// Applies the same random inserts and erases to maps kept in a PTree and in a PBTree, and checks that they agree at every
+// version still kept
+TEST_CASE("/fdbclient/VersionedMap/PBTreeMatchesPTree") {
+	VersionedMap<int, int> ptree;
+	VersionedMap<int, int> pbtree(true);
+	const int keys = deterministicRandom()->randomInt(10, 10000);
+	std::vector<Future<Void>> cleanups;
+
+	for (Version v = 1; v <= 200; v++) {
+		ptree.createNewVersion(v);
+		pbtree.createNewVersion(v);
+		for (int i = deterministicRandom()->randomInt(0, 100); i > 0; i--) {
+			const int k = deterministicRandom()->randomInt(0, keys);
+			const int op = deterministicRandom()->randomInt(0, 10);
+			if (op < 6) {
+				ptree.insert(k, i);
+				pbtree.insert(k, i);
+			} else if (op < 9) {
+				const int end = k + deterministicRandom()->randomInt(1, keys / 10 + 2);
+				ptree.erase(k, end);
+				pbtree.erase(k, end);
+			} else {
+				auto it = pbtree.atLatest().lower_bound(k);
+				if (it) {
+					ptree.erase(it.key());
+					pbtree.erase(it);
+				}
+			}
+		}
+		if (v % 10 == 0) {
+			cleanups.push_back(ptree.forgetVersionsBeforeAsync(v - 30));
+			cleanups.push_back(pbtree.forgetVersionsBeforeAsync(v - 30));
+		}
+
+		pbtree.atLatest().validate();
+		for (Version at = std::max<Version>(1, v - 30); at <= v; at += deterministicRandom()->randomInt(1, 10)) {
+			auto p = ptree.at(at);
+			auto b = pbtree.at(at);
+			auto pi = p.begin();
+			auto bi = b.begin();
+			for (; pi != p.end(); ++pi, ++bi) {
+				ASSERT(bi != b.end());
+				ASSERT_EQ(pi.key(), bi.key());
+				ASSERT_EQ(*pi, *bi);
+				ASSERT_EQ(pi.insertVersion(), bi.insertVersion());
+			}
+			ASSERT(bi == b.end());
+
+			const int k = deterministicRandom()->randomInt(-1, keys + 1);
+			for (auto [pr, br] : { std::make_pair(p.lower_bound(k), b.lower_bound(k)),
+			                       std::make_pair(p.upper_bound(k), b.upper_bound(k)),
+			                       std::make_pair(p.lastLess(k), b.lastLess(k)),
+			                       std::make_pair(p.lastLessOrEqual(k), b.lastLessOrEqual(k)) }) {
+				ASSERT_EQ(bool(pr), bool(br));
+				if (pr) {
+					ASSERT_EQ(pr.key(), br.key());
+					--pr;
+					--br;
+					ASSERT_EQ(bool(pr), bool(br));
+					ASSERT(!pr || pr.key() == br.key());
+				}
+			}
+		}
+	}
+	return waitForAll(cleanups);
+}
+
+// A range erase that leaves an internal node with a single, underfull child, which is then merged into its neighbor
+TEST_CASE("/fdbclient/VersionedMap/PBTreeRangeEraseUnderfull") {
+	using Node = PBTreeImpl::Node<int, int>;
+	auto firstKey = [](Node const* n) {
+		while (!n->leaf) {
+			n = n->asInternal()->children[0].getPtr();
+		}
+		return n->keys[0];
+	};
+	Reference<Node> root;
+	for (int i = 0; i < 20000; i++) {
+		PBTreeImpl::insert(root, 1, i, i);
+	}
+	const int begin = firstKey(root->asInternal()->children[1].getPtr()) + 3;
+	const int end = firstKey(root->asInternal()->children[2]->asInternal()->children[0].getPtr()) + 2;
+	PBTreeImpl::remove(root, 2, begin, end);
+
+	int count = 0;
+	PBTreeImpl::validate(root.getPtr(), (int const*)nullptr, (int const*)nullptr, true, count);
+	ASSERT_EQ(count, 20000 - (end - begin));
+	return Void();
+}
+
+// A PBTree copies the path to a leaf the first time it is written at a version, and reports only the nodes it copied
+TEST_CASE("/fdbclient/VersionedMap/PBTreeNodeBytes") {
+	VersionedMap<int, int> ptree;
+	VersionedMap<int, int> pbtree(true);
+	ptree.createNewVersion(1);
+	pbtree.createNewVersion(1);
+	for (int i = 0; i < 10000; i++) {
+		ptree.insert(i, i);
+		pbtree.insert(i, i);
+	}
+	ASSERT_EQ(ptree.takeNodeBytesAllocated(), 0);
+	ASSERT(pbtree.takeNodeBytesAllocated() > 0);
+
+	pbtree.createNewVersion(2);
+	pbtree.insert(5000, 0);
+	const int64_t pathBytes = pbtree.takeNodeBytesAllocated();
+	ASSERT(pathBytes > 0);
+	// The nodes on the path were already copied at this version
+	pbtree.insert(5001, 0);
+	pbtree.erase(5000);
+	ASSERT_EQ(pbtree.takeNodeBytesAllocated(), 0);
+
+	pbtree.createNewVersion(3);
+	pbtree.insert(5001, 1);
+	ASSERT_EQ(pbtree.takeNodeBytesAllocated(), pathBytes);
+	return Void();
+}
+
 void forceLinkVersionedMapTests() {}
@@ -93,6 +93,8 @@ public:
 	double GRV_BATCH_TIMEOUT;
 	int BROADCAST_BATCH_SIZE;
 	double TRANSACTION_TIMEOUT_DELAY_INTERVAL;
+	int GET_VALUES_BATCH_MAX_KEYS; // Concurrent point reads of a transaction to the same storage servers are sent as
+	                               // one request of up to this many keys, 0 or 1 disables it
 
 	// When locationCache in DatabaseContext gets to be this size, items will be evicted
 	int LOCATION_CACHE_EVICTION_SIZE;
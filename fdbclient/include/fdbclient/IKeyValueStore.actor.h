@@ -53,6 +53,9 @@ struct CheckpointRequest {
 ACTOR static Future<Void> replaceRange_impl(class IKeyValueStore* self,
                                             KeyRange range,
                                             Standalone<VectorRef<KeyValueRef>> data);
+ACTOR static Future<std::vector<Optional<Value>>> readValues_impl(class IKeyValueStore* self,
+                                                                  Standalone<VectorRef<KeyRef>> keys,
+                                                                  Optional<ReadOptions> options);
 
 class IKeyValueStore : public IClosable {
 public:
@@ -71,6 +74,13 @@ public:
 
 	virtual Future<Optional<Value>> readValue(KeyRef key, Optional<ReadOptions> options = Optional<ReadOptions>()) = 0;
 
+	// Reads the values of keys, which are sorted in ascending order, and returns them in the same order. The default
+	// implementation issues a readValue() per key.
+	virtual Future<std::vector<Optional<Value>>> readValues(Standalone<VectorRef<KeyRef>> keys,
+	                                                        Optional<ReadOptions> options = Optional<ReadOptions>()) {
+		return readValues_impl(this, keys, options);
+	}
+
 	// Like readValue(), but returns only the first maxLength bytes of the value if it is longer
 	virtual Future<Optional<Value>> readValuePrefix(KeyRef key,
 	                                                int maxLength,
@@ -189,5 +199,17 @@ ACTOR static Future<Void> replaceRange_impl(IKeyValueStore* self,
 	return Void();
 }
 
+ACTOR static Future<std::vector<Optional<Value>>> readValues_impl(IKeyValueStore* self,
+                                                                  Standalone<VectorRef<KeyRef>> keys,
+                                                                  Optional<ReadOptions> options) {
+	state std::vector<Future<Optional<Value>>> reads;
+	reads.reserve(keys.size());
+	for (const auto& key : keys) {
+		reads.push_back(self->readValue(key, options));
+	}
+	std::vector<Optional<Value>> values = wait(getAll(reads));
+	return values;
+}
+
 #include "flow/unactorcompiler.h"
 #endif
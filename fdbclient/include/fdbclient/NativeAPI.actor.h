@@ -252,6 +252,13 @@ struct Watch : public ReferenceCounted<Watch>, NonCopyable {
 	void setWatch(Future<Void> watchFuture);
 };
 
+// Point reads of a transaction to one storage server team that are sent together in a GetValuesRequest
+struct GetValuesBatch {
+	Standalone<VectorRef<KeyRef>> keys;
+	// Set once the request is sent, after which reads to the team start a new batch
+	bool sent = false;
+};
+
 struct TransactionState : ReferenceCounted<TransactionState> {
 	Database cx;
 	Future<Version> readVersionFuture;
@@ -286,6 +293,9 @@ struct TransactionState : ReferenceCounted<TransactionState> {
 
 	Future<Void> startFuture;
 
+	// The latest batch of point reads to each storage server team, by the sorted ids of the team, and its reply
+	std::map<std::vector<UID>, std::pair<std::shared_ptr<GetValuesBatch>, Future<GetValuesReply>>> getValuesBatches;
+
 	// Only available so that Transaction can have a default constructor, for use in state variables
 	TransactionState(TaskPriority taskID, SpanContext spanContext) : taskID(taskID), spanContext(spanContext) {}
 
@@ -0,0 +1,611 @@
+/*
+ * PBTree.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBCLIENT_PBTREE_H
+#define FDBCLIENT_PBTREE_H
+#pragma once
+
+#include <algorithm>
+#include <new>
+#include <utility>
+#include <vector>
+
+#include "flow/flow.h"
+
+// PBTree is a persistent B+tree with wide nodes, an alternative to PTree for VersionedMap. Writes copy the nodes on the
+// path to the changed leaf, unless they were already copied at the same version, so each version shares all the nodes
+// it did not change with the older ones. Keys are kept in arrays, so seeks and scans touch a few cache lines per node
+// instead of a node per key, and the per key overhead is a fraction of a PTree node's.
+//
+// Leaves hold the keys with their values. Internal nodes hold their children with separator keys: keys[i] is no greater
+// than any key under children[i] and greater than any key under children[i - 1], and keys[0] is unused. Nodes other
+// than the root are never empty and are kept at least a quarter full by erases.
+namespace PBTreeImpl {
+
+// Entries per node
+constexpr int nodeEntries = 32;
+constexpr int minNodeEntries = nodeEntries / 4;
+// Deep enough for more keys than fit in memory with every node at its minimum
+constexpr int maxDepth = 16;
+
+template <class K, class V>
+struct Leaf;
+template <class K, class V>
+struct Internal;
+
+template <class K, class V>
+struct Node : NonCopyable {
+	mutable int32_t referenceCount;
+	const bool leaf;
+	int count;
+	// Nodes created at the latest version are changed in place, older ones are copied first
+	Version version;
+	K keys[nodeEntries];
+
+	Node(bool leaf, Version version) : referenceCount(1), leaf(leaf), count(0), version(version) {}
+
+	void addref() const { ++referenceCount; }
+	void delref() const {
+		if (!--referenceCount) {
+			if (leaf) {
+				delete static_cast<Leaf<K, V> const*>(this);
+			} else {
+				delete static_cast<Internal<K, V> const*>(this);
+			}
+		}
+	}
+	bool isSoleOwner() const { return referenceCount == 1; }
+
+	Leaf<K, V>* asLeaf() { return static_cast<Leaf<K, V>*>(this); }
+	Leaf<K, V> const* asLeaf() const { return static_cast<Leaf<K, V> const*>(this); }
+	Internal<K, V>* asInternal() { return static_cast<Internal<K, V>*>(this); }
+	Internal<K, V> const* asInternal() const { return static_cast<Internal<K, V> const*>(this); }
+
+	// Index of the first key not less than x
+	template <class X>
+	int lowerBound(const X& x) const {
+		return std::lower_bound(keys, keys + count, x, [](const K& k, const X& x) { return k < x; }) - keys;
+	}
+	// Index of the first key greater than x
+	template <class X>
+	int upperBound(const X& x) const {
+		return std::upper_bound(keys, keys + count, x, [](const X& x, const K& k) { return x < k; }) - keys;
+	}
+	// Index of the child of an internal node whose keys x falls among
+	template <class X>
+	int childIndex(const X& x) const {
+		return std::upper_bound(keys + 1, keys + count, x, [](const X& x, const K& k) { return x < k; }) - (keys + 1);
+	}
+};
+
+template <class K, class V>
+struct Leaf : Node<K, V>, FastAllocated<Leaf<K, V>> {
+	// Values are constructed only for the first count entries
+	alignas(V) uint8_t values[nodeEntries * sizeof(V)];
+
+	explicit Leaf(Version version) : Node<K, V>(true, version) {}
+	Leaf(Leaf const& from, Version version) : Node<K, V>(true, version) {
+		for (int i = 0; i < from.count; i++) {
+			this->keys[i] = from.keys[i];
+			new (&value(i)) V(from.value(i));
+		}
+		this->count = from.count;
+	}
+	~Leaf() {
+		for (int i = 0; i < this->count; i++) {
+			value(i).~V();
+		}
+	}
+
+	V& value(int i) { return reinterpret_cast<V*>(values)[i]; }
+	V const& value(int i) const { return reinterpret_cast<V const*>(values)[i]; }
+
+	void insert(int at, const K& k, const V& v) {
+		ASSERT(this->count < nodeEntries);
+		for (int i = this->count; i > at; i--) {
+			this->keys[i] = std::move(this->keys[i - 1]);
+			new (&value(i)) V(std::move(value(i - 1)));
+			value(i - 1).~V();
+		}
+		this->keys[at] = k;
+		new (&value(at)) V(v);
+		this->count++;
+	}
+	// Removes the entries in [begin, end)
+	void remove(int begin, int end) {
+		for (int i = begin; i < end; i++) {
+			value(i).~V();
+		}
+		for (int i = end; i < this->count; i++) {
+			this->keys[i - (end - begin)] = std::move(this->keys[i]);
+			new (&value(i - (end - begin))) V(std::move(value(i)));
+			value(i).~V();
+		}
+		this->count -= end - begin;
+	}
+	// Moves the entries from index from on to the end of to
+	void moveTail(int from, Leaf& to) {
+		for (int i = from; i < this->count; i++) {
+			to.keys[to.count] = std::move(this->keys[i]);
+			new (&to.value(to.count++)) V(std::move(value(i)));
+			value(i).~V();
+		}
+		this->count = from;
+	}
+};
+
+template <class K, class V>
+struct Internal : Node<K, V>, FastAllocated<Internal<K, V>> {
+	Reference<Node<K, V>> children[nodeEntries];
+
+	explicit Internal(Version version) : Node<K, V>(false, version) {}
+	Internal(Internal const& from, Version version) : Node<K, V>(false, version) {
+		for (int i = 0; i < from.count; i++) {
+			this->keys[i] = from.keys[i];
+			children[i] = from.children[i];
+		}
+		this->count = from.count;
+	}
+
+	void insert(int at, const K& k, Reference<Node<K, V>> child) {
+		ASSERT(this->count < nodeEntries);
+		for (int i = this->count; i > at; i--) {
+			this->keys[i] = std::move(this->keys[i - 1]);
+			children[i] = std::move(children[i - 1]);
+		}
+		this->keys[at] = k;
+		children[at] = std::move(child);
+		this->count++;
+	}
+	void remove(int begin, int end) {
+		for (int i = end; i < this->count; i++) {
+			this->keys[i - (end - begin)] = std::move(this->keys[i]);
+			children[i - (end - begin)] = std::move(children[i]);
+		}
+		for (int i = this->count - (end - begin); i < this->count; i++) {
+			children[i].clear();
+		}
+		this->count -= end - begin;
+	}
+	void moveTail(int from, Internal& to) {
+		for (int i = from; i < this->count; i++) {
+			to.keys[to.count] = std::move(this->keys[i]);
+			to.children[to.count++] = std::move(children[i]);
+		}
+		this->count = from;
+	}
+};
+
+// The bytes of the nodes that writes on this thread allocated, which VersionedMap reads around each write to charge it for
+// the nodes it copied or split
+inline int64_t& allocatedNodeBytes() {
+	static thread_local int64_t bytes = 0;
+	return bytes;
+}
+
+// Allocates a node of type N for a write, counting it in allocatedNodeBytes()
+template <class N, class... Args>
+N* newNode(Args&&... args) {
+	allocatedNodeBytes() += nextFastAllocatedSize(sizeof(N));
+	return new N(std::forward<Args>(args)...);
+}
+
+// Moves the children of a that are only referenced by a into toFree, so that deferredCleanupActor frees the tree a node
+// at a time.
+template <class K, class V>
+void releaseSoleOwnedChildren(Reference<Node<K, V>>& a, std::vector<Reference<Node<K, V>>>& toFree) {
+	if (a->leaf) {
+		return;
+	}
+	for (int c = 0; c < a->count; c++) {
+		auto& child = a->asInternal()->children[c];
+		if (child->isSoleOwner()) {
+			toFree.push_back(std::move(child));
+		}
+	}
+}
+
+// Returns node if it was created at version at, or a copy of it created at at otherwise
+template <class K, class V>
+Reference<Node<K, V>> writable(Reference<Node<K, V>> const& node, Version at) {
+	ASSERT_LE(node->version, at);
+	if (node->version == at) {
+		return node;
+	}
+	if (node->leaf) {
+		return Reference<Node<K, V>>(newNode<Leaf<K, V>>(*node->asLeaf(), at));
+	}
+	return Reference<Node<K, V>>(newNode<Internal<K, V>>(*node->asInternal(), at));
+}
+
+template <class K, class V>
+Node<K, V>* writableChild(Internal<K, V>* node, int c, Version at) {
+	node->children[c] = writable(node->children[c], at);
+	return node->children[c].getPtr();
+}
+
+// A position in a tree: the node and index at each level, from the root to a leaf. An empty finger is the end.
+template <class K, class V>
+class PBTreeFinger {
+public:
+	PBTreeFinger() : depth(0) {}
+
+	int size() const { return depth; }
+	void clear() { depth = 0; }
+	Leaf<K, V> const* leaf() const { return nodes[depth - 1]->asLeaf(); }
+	int index() const { return indices[depth - 1]; }
+	K const& key() const { return leaf()->keys[index()]; }
+	V const& value() const { return leaf()->value(index()); }
+
+	void push(Node<K, V> const* node, int index) {
+		ASSERT(depth < maxDepth);
+		nodes[depth] = node;
+		indices[depth++] = index;
+	}
+
+	// Descends to the first or last key under the child at the current position
+	template <bool last>
+	void descend() {
+		for (Node<K, V> const* n = nodes[depth - 1]; !n->leaf;) {
+			n = n->asInternal()->children[indices[depth - 1]].getPtr();
+			push(n, last ? n->count - 1 : 0);
+		}
+	}
+
+	// Moves to the next or previous key, or to the end
+	template <bool forward>
+	void move() {
+		ASSERT(depth);
+		int level = depth - 1;
+		while (forward ? indices[level] + 1 == nodes[level]->count : indices[level] == 0) {
+			if (level-- == 0) {
+				clear();
+				return;
+			}
+		}
+		indices[level] += forward ? 1 : -1;
+		depth = level + 1;
+		descend<!forward>();
+	}
+
+	// Moves from a leaf index one past the last key to the next key, or to the end
+	void skipLeafEnd() {
+		if (index() == leaf()->count) {
+			indices[depth - 1]--;
+			move<true>();
+		}
+	}
+
+private:
+	Node<K, V> const* nodes[maxDepth];
+	int indices[maxDepth];
+	int depth;
+};
+
+template <class K, class V>
+void first(Reference<Node<K, V>> const& root, PBTreeFinger<K, V>& f) {
+	f.clear();
+	if (root) {
+		f.push(root.getPtr(), 0);
+		f.template descend<false>();
+	}
+}
+
+template <class K, class V>
+void last(Reference<Node<K, V>> const& root, PBTreeFinger<K, V>& f) {
+	f.clear();
+	if (root) {
+		f.push(root.getPtr(), root->count - 1);
+		f.template descend<true>();
+	}
+}
+
+// Positions f at the first key not less than x, or greater than x if upper
+template <class K, class V, class X, bool upper>
+void bound(Reference<Node<K, V>> const& root, const X& x, PBTreeFinger<K, V>& f) {
+	f.clear();
+	if (!root) {
+		return;
+	}
+	Node<K, V> const* n = root.getPtr();
+	while (!n->leaf) {
+		const int c = n->childIndex(x);
+		f.push(n, c);
+		n = n->asInternal()->children[c].getPtr();
+	}
+	f.push(n, upper ? n->upperBound(x) : n->lowerBound(x));
+	f.skipLeafEnd();
+}
+
+template <class K, class V, class X>
+void lower_bound(Reference<Node<K, V>> const& root, const X& x, PBTreeFinger<K, V>& f) {
+	bound<K, V, X, false>(root, x, f);
+}
+
+template <class K, class V, class X>
+void upper_bound(Reference<Node<K, V>> const& root, const X& x, PBTreeFinger<K, V>& f) {
+	bound<K, V, X, true>(root, x, f);
+}
+
+// Returns the first key not less than x under node, or nullptr
+template <class K, class V, class X>
+K const* firstAtLeast(Node<K, V> const* node, const X& x) {
+	if (node->leaf) {
+		const int i = node->lowerBound(x);
+		return i < node->count ? &node->keys[i] : nullptr;
+	}
+	const int c = node->childIndex(x);
+	K const* k = firstAtLeast(node->asInternal()->children[c].getPtr(), x);
+	if (!k && c + 1 < node->count) {
+		Node<K, V> const* n = node->asInternal()->children[c + 1].getPtr();
+		while (!n->leaf) {
+			n = n->asInternal()->children[0].getPtr();
+		}
+		k = &n->keys[0];
+	}
+	return k;
+}
+
+// Inserts k or replaces its value under the writable node. If the node was full, it is split and the node holding its
+// upper half is returned with the separator key for it.
+template <class K, class V>
+Reference<Node<K, V>> insert(Node<K, V>* node, Version at, const K& k, const V& v, K& separator) {
+	Reference<Node<K, V>> right;
+	if (node->leaf) {
+		Leaf<K, V>* leaf = node->asLeaf();
+		int i = leaf->lowerBound(k);
+		if (i < leaf->count && !(k < leaf->keys[i])) {
+			leaf->value(i) = v;
+			return right;
+		}
+		if (leaf->count == nodeEntries) {
+			right = Reference<Node<K, V>>(newNode<Leaf<K, V>>(at));
+			leaf->moveTail(nodeEntries / 2, *right->asLeaf());
+			separator = right->keys[0];
+			if (i > nodeEntries / 2) {
+				leaf = right->asLeaf();
+				i -= nodeEntries / 2;
+			}
+		}
+		leaf->insert(i, k, v);
+		return right;
+	}
+
+	Internal<K, V>* internal = node->asInternal();
+	int c = internal->childIndex(k);
+	K childSeparator;
+	Reference<Node<K, V>> childRight = insert(writableChild(internal, c, at), at, k, v, childSeparator);
+	if (!childRight) {
+		return right;
+	}
+	c++;
+	if (internal->count == nodeEntries) {
+		right = Reference<Node<K, V>>(newNode<Internal<K, V>>(at));
+		internal->moveTail(nodeEntries / 2, *right->asInternal());
+		separator = right->keys[0];
+		if (c > nodeEntries / 2) {
+			internal = right->asInternal();
+			c -= nodeEntries / 2;
+		}
+	}
+	internal->insert(c, childSeparator, std::move(childRight));
+	return right;
+}
+
+template <class K, class V>
+void insert(Reference<Node<K, V>>& root, Version at, const K& k, const V& v) {
+	if (!root) {
+		root = Reference<Node<K, V>>(newNode<Leaf<K, V>>(at));
+		root->asLeaf()->insert(0, k, v);
+		return;
+	}
+	root = writable(root, at);
+	K separator;
+	Reference<Node<K, V>> right = insert(root.getPtr(), at, k, v, separator);
+	if (right) {
+		Reference<Node<K, V>> left = std::move(root);
+		root = Reference<Node<K, V>>(newNode<Internal<K, V>>(at));
+		root->asInternal()->insert(0, K(), left);
+		root->asInternal()->insert(1, separator, std::move(right));
+	}
+}
+
+// Merges each child of the writable node that is empty or less than a quarter full with a neighbor, or evens them out
+// if they do not fit in one node.
+template <class K, class V>
+void fixChildren(Internal<K, V>* node, Version at) {
+	for (int c = 0; c < node->count;) {
+		Node<K, V> const* child = node->children[c].getPtr();
+		if (child->count == 0) {
+			node->remove(c, c + 1);
+			continue;
+		}
+		if (child->count >= minNodeEntries || node->count == 1) {
+			c++;
+			continue;
+		}
+
+		const int l = c > 0 ? c - 1 : c;
+		Node<K, V>* left = writableChild(node, l, at);
+		Node<K, V>* right = writableChild(node, l + 1, at);
+		if (!left->leaf) {
+			// The separator of the first child of right is in node
+			right->keys[0] = node->keys[l + 1];
+		}
+		const int total = left->count + right->count;
+		const int leftCount = total <= nodeEntries ? total : total / 2;
+		if (left->count < leftCount) {
+			// Move the first entries of right to the end of left
+			const int n = leftCount - left->count;
+			if (left->leaf) {
+				Leaf<K, V> head(at);
+				right->asLeaf()->moveTail(0, head);
+				head.moveTail(n, *right->asLeaf());
+				head.moveTail(0, *left->asLeaf());
+			} else {
+				Internal<K, V> head(at);
+				right->asInternal()->moveTail(0, head);
+				head.moveTail(n, *right->asInternal());
+				head.moveTail(0, *left->asInternal());
+			}
+		} else if (left->count > leftCount) {
+			// Move the last entries of left to the start of right
+			if (left->leaf) {
+				Leaf<K, V> tail(at);
+				left->asLeaf()->moveTail(leftCount, tail);
+				right->asLeaf()->moveTail(0, tail);
+				tail.moveTail(0, *right->asLeaf());
+			} else {
+				Internal<K, V> tail(at);
+				left->asInternal()->moveTail(leftCount, tail);
+				right->asInternal()->moveTail(0, tail);
+				tail.moveTail(0, *right->asInternal());
+			}
+		}
+		if (!left->leaf) {
+			// A child with a single child does not fix it, so either of them may now hold an underfull child
+			fixChildren(left->asInternal(), at);
+			fixChildren(right->asInternal(), at);
+		}
+		if (right->count == 0) {
+			node->remove(l + 1, l + 2);
+		} else {
+			node->keys[l + 1] = right->keys[0];
+		}
+		// Fixing the children of left may have left it underfull again
+		c = l;
+	}
+}
+
+// Removes the keys in [begin, end) under the writable node
+template <class K, class V, class X>
+void remove(Node<K, V>* node, Version at, const X& begin, const X& end) {
+	if (node->leaf) {
+		node->asLeaf()->remove(node->lowerBound(begin), node->lowerBound(end));
+		return;
+	}
+	Internal<K, V>* internal = node->asInternal();
+	const int first = internal->childIndex(begin);
+	const int last = internal->childIndex(end);
+	// Children only partly in the range are copied only if they have keys in it
+	for (int c : { first, last }) {
+		K const* k = firstAtLeast(internal->children[c].getPtr(), begin);
+		if (k && *k < end) {
+			remove(writableChild(internal, c, at), at, begin, end);
+		}
+		if (last == first) {
+			break;
+		}
+	}
+	if (last - first > 1) {
+		internal->remove(first + 1, last);
+	}
+	fixChildren(internal, at);
+}
+
+template <class K, class V, class X>
+void remove(Reference<Node<K, V>>& root, Version at, const X& begin, const X& end) {
+	if (!root || !(begin < end)) {
+		return;
+	}
+	K const* k = firstAtLeast(root.getPtr(), begin);
+	if (!k || !(*k < end)) {
+		return;
+	}
+	root = writable(root, at);
+	remove(root.getPtr(), at, begin, end);
+	while (root->count == 1 && !root->leaf) {
+		Reference<Node<K, V>> child = root->asInternal()->children[0];
+		root = std::move(child);
+	}
+	if (root->count == 0) {
+		root.clear();
+	}
+}
+
+// Removes x, which must be present, under the writable node
+template <class K, class V, class X>
+void remove(Node<K, V>* node, Version at, const X& x) {
+	if (node->leaf) {
+		const int i = node->lowerBound(x);
+		ASSERT(i < node->count && !(x < node->keys[i]));
+		node->asLeaf()->remove(i, i + 1);
+		return;
+	}
+	remove(writableChild(node->asInternal(), node->childIndex(x), at), at, x);
+	fixChildren(node->asInternal(), at);
+}
+
+template <class K, class V, class X>
+void remove(Reference<Node<K, V>>& root, Version at, const X& x) {
+	ASSERT(root);
+	root = writable(root, at);
+	remove(root.getPtr(), at, x);
+	while (root->count == 1 && !root->leaf) {
+		Reference<Node<K, V>> child = root->asInternal()->children[0];
+		root = std::move(child);
+	}
+	if (root->count == 0) {
+		root.clear();
+	}
+}
+
+// Checks the order of the keys under node and the occupancy of the nodes, and returns the height of the tree under it
+template <class K, class V>
+int validate(Node<K, V> const* node, K const* min, K const* max, bool isRoot, int& count) {
+	ASSERT(node->count > 0 && node->count <= nodeEntries);
+	ASSERT(isRoot || node->count >= minNodeEntries);
+	if (node->leaf) {
+		for (int i = 0; i < node->count; i++) {
+			ASSERT(!min || !(node->keys[i] < *min));
+			ASSERT(!max || node->keys[i] < *max);
+			ASSERT(i == 0 || node->keys[i - 1] < node->keys[i]);
+		}
+		count += node->count;
+		return 1;
+	}
+	int height = 0;
+	for (int c = 0; c < node->count; c++) {
+		K const* childMin = c == 0 ? min : &node->keys[c];
+		K const* childMax = c + 1 == node->count ? max : &node->keys[c + 1];
+		const int h = validate(node->asInternal()->children[c].getPtr(), childMin, childMax, false, count);
+		ASSERT(c == 0 || h == height);
+		height = h;
+	}
+	return height + 1;
+}
+
+template <class K, class V>
+void printTree(Node<K, V> const* node, int depth = 0) {
+	for (int i = 0; i < node->count; i++) {
+		if (!node->leaf) {
+			printTree(node->asInternal()->children[i].getPtr(), depth + 1);
+			continue;
+		}
+		for (int d = 0; d < depth; d++) {
+			printf("  ");
+		}
+		printf(":%s\n", describe(node->keys[i]).c_str());
+	}
+}
+
+} // namespace PBTreeImpl
+
+#endif
@@ -0,0 +1,89 @@
+/*
+ * RangeReadFilter.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBCLIENT_RANGEREADFILTER_H
+#define FDBCLIENT_RANGEREADFILTER_H
+#pragma once
+
+#include "fdbclient/FDBTypes.h"
+
+// Compares one element of a row's key (or value), unpacked as a tuple, against an operand. The operand is a packed
+// single element tuple, e.g. Tuple::makeTuple(42).pack(). Tuple encoding preserves order, so elements are compared by
+// their packed bytes and elements of different types order by their type codes.
+struct TupleElementPredicateRef {
+	constexpr static FileIdentifier file_identifier = 8410387;
+
+	enum Op : uint8_t { EQ = 0, NE, LT, LE, GT, GE };
+
+	bool onValue = false; // compare an element of the value instead of the key
+	int index = 0; // index of the element in the tuple
+	uint8_t op = EQ;
+	StringRef operand;
+
+	TupleElementPredicateRef() {}
+	TupleElementPredicateRef(Arena& a, bool onValue, int index, Op op, StringRef operand)
+	  : onValue(onValue), index(index), op(op), operand(a, operand) {}
+	TupleElementPredicateRef(Arena& a, const TupleElementPredicateRef& copyFrom)
+	  : onValue(copyFrom.onValue), index(copyFrom.index), op(copyFrom.op), operand(a, copyFrom.operand) {}
+
+	int expectedSize() const { return operand.expectedSize(); }
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, onValue, index, op, operand);
+	}
+};
+
+// A declarative predicate and projection a storage server applies to the rows of a range read, so that rows a client
+// would discard are never sent to it. Evaluating a filter never fails the read: a row whose key or value does not
+// unpack as a tuple, or has no element at a predicate's index, just does not match.
+struct RangeReadFilterRef {
+	constexpr static FileIdentifier file_identifier = 8410388;
+
+	// A row's key matches if (key[i] & keyMask[i]) == keyPattern[i] for every i < keyPattern.size(). Mask bytes past
+	// the end of keyMask are 0xff, so an empty keyMask makes keyPattern a plain key prefix.
+	StringRef keyPattern;
+	StringRef keyMask;
+	// Every predicate must hold for a row to match.
+	VectorRef<TupleElementPredicateRef> tuplePredicates;
+	int minValueLength = 0;
+	int maxValueLength = std::numeric_limits<int>::max();
+	// Matching rows are returned with empty values
+	bool keysOnly = false;
+
+	RangeReadFilterRef() {}
+	RangeReadFilterRef(Arena& a, const RangeReadFilterRef& copyFrom)
+	  : keyPattern(a, copyFrom.keyPattern), keyMask(a, copyFrom.keyMask),
+	    tuplePredicates(a, copyFrom.tuplePredicates), minValueLength(copyFrom.minValueLength),
+	    maxValueLength(copyFrom.maxValueLength), keysOnly(copyFrom.keysOnly) {}
+
+	bool matches(KeyValueRef const& kv) const;
+
+	int expectedSize() const {
+		return keyPattern.expectedSize() + keyMask.expectedSize() + tuplePredicates.expectedSize();
+	}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, keyPattern, keyMask, tuplePredicates, minValueLength, maxValueLength, keysOnly);
+	}
+};
+
+#endif
@@ -61,6 +61,10 @@ public:
 
 	// TLogs
 	bool PEEK_USING_STREAMING;
+	int PEEK_STREAM_BUFFER_BYTES; // Bytes of peek stream replies a cursor asks the TLog to send ahead of its reads
+	int64_t TLOG_PEEK_STREAM_MEMORY_BYTES; // If > 0, the unacknowledged peek stream bytes of a TLog are split among
+	                                       // its active streams
+	bool TLOG_PEEK_STREAM_PREFETCH; // Read as much spilled data for a peek stream reply as the stream's window allows
 	double TLOG_TIMEOUT; // tlog OR commit proxy failure - master's reaction time
 	double TLOG_SLOW_REJOIN_WARN_TIMEOUT_SECS; // Warns if a tlog takes too long to rejoin
 	double TLOG_STORAGE_MIN_UPDATE_INTERVAL;
@@ -90,20 +94,28 @@ public:
 	int PARALLEL_GET_MORE_REQUESTS;
 	int MULTI_CURSOR_PRE_FETCH_LIMIT;
 	int64_t MAX_QUEUE_COMMIT_BYTES;
+	double TLOG_QUEUE_COMMIT_COALESCE_DELAY; // How long a TLog waits for more pushes before committing its queue
 	int DESIRED_OUTSTANDING_MESSAGES;
 	double DESIRED_GET_MORE_DELAY;
 	int CONCURRENT_LOG_ROUTER_READS;
 	int LOG_ROUTER_PEEK_FROM_SATELLITES_PREFERRED; // 0==peek from primary, non-zero==peek from satellites
 	double LOG_ROUTER_PEEK_SWITCH_DC_TIME;
 	double LOG_ROUTER_REPLACEMENT_GRACE_PERIOD; // Grace period for replacement log routers to appear in ServerDBInfo
+	int64_t LOG_ROUTER_CACHE_BYTES; // Size of the per process cache of messages pulled by log routers, 0 to disable
 	double DISK_QUEUE_ADAPTER_MIN_SWITCH_TIME;
 	double DISK_QUEUE_ADAPTER_MAX_SWITCH_TIME;
 	int64_t TLOG_SPILL_REFERENCE_MAX_PEEK_MEMORY_BYTES;
 	int64_t TLOG_SPILL_REFERENCE_MAX_BATCHES_PER_PEEK;
 	int64_t TLOG_SPILL_REFERENCE_MAX_BYTES_PER_BATCH;
+	int TLOG_PEEK_SPILLED_COMMIT_INDEXES; // Spilled commits whose messages stay indexed by tag for peeks, 0 disables
+	std::string TLOG_QUEUE_COMPRESSION_FILTER; // Compression of TLogQueue entries, "NONE" or "ZSTD". Compressed
+	                                           // queues cannot be read by versions without this option.
+	int TLOG_QUEUE_COMPRESSION_MIN_BYTES; // TLogQueue entries smaller than this are not compressed
 	int64_t DISK_QUEUE_FILE_EXTENSION_BYTES; // When we grow the disk queue, by how many bytes should it grow?
 	int64_t DISK_QUEUE_FILE_SHRINK_BYTES; // When we shrink the disk queue, by how many bytes should it shrink?
 	int64_t DISK_QUEUE_MAX_TRUNCATE_BYTES; // A truncate larger than this will cause the file to be replaced instead.
+	int64_t DISK_QUEUE_BUFFER_POOL_BYTES; // If > 0, up to this many bytes of page buffers are kept for reuse by commits
+	bool DISK_QUEUE_BUFFER_POOL_HUGE_PAGES; // Advise transparent huge pages for pooled buffers of 2MB or more
 	double TLOG_DEGRADED_DURATION;
 	double TXS_POPPED_MAX_DELAY;
 	double TLOG_MAX_CREATE_DURATION;
@@ -682,6 +694,9 @@ public:
 	double TAG_THROTTLE_MAX_EMPTY_QUEUE_BUDGET;
 	int START_TRANSACTION_MAX_QUEUE_SIZE;
 	int KEY_LOCATION_MAX_QUEUE_SIZE;
+	bool GRV_PROXY_COALESCE_MASTER_REQUESTS; // Batches of GRV requests share master round trips when allowed
+	int GRV_PROXY_MAX_OUTSTANDING_MASTER_REQUESTS; // With coalescing, later batches wait for and share the next one
+	double GRV_PROXY_CAUSAL_READ_RISKY_MAX_STALENESS; // CAUSAL_READ_RISKY GRVs may get a version this old, 0 disables
 
 	double COMMIT_PROXY_LIVENESS_TIMEOUT;
 	double COMMIT_PROXY_MAX_LIVENESS_TIMEOUT;
@@ -692,6 +707,14 @@ public:
 	double COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION;
 	double COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA;
 	int COMMIT_TRANSACTION_BATCH_COUNT_MAX;
+	int COMMIT_TRANSACTION_BATCH_COUNT_MIN; // Smallest count limit the batching controller shrinks commit batches to
+	double COMMIT_BATCH_TARGET_P99_LATENCY; // Seconds, 0 keeps the latency fraction based batching interval
+	int COMMIT_BATCH_CONTROLLER_WINDOW; // Commit batches per p99 sample of the batching controller
+	double COMMIT_BATCH_CONTROLLER_GAIN;
+	int PROXY_SHARD_LOOKUP_THREADS; // Threads looking up the shards of a commit batch's mutations, 1 looks them up inline
+	int PROXY_SHARD_LOOKUP_MIN_MUTATIONS; // Mutations each of those threads must get
+	bool PROXY_KEY_INFO_INDEX; // Look up the shards of mutations in a flat copy of the keyInfo boundaries
+	int PROXY_REFERENCE_VALUES_MIN_BYTES; // Values this large are sent to TLogs without copying them first, 0 disables
 	int COMMIT_TRANSACTION_BATCH_BYTES_MIN;
 	int COMMIT_TRANSACTION_BATCH_BYTES_MAX;
 	double COMMIT_TRANSACTION_BATCH_BYTES_SCALE_BASE;
@@ -755,6 +778,12 @@ public:
 	double SAMPLE_EXPIRATION_TIME;
 	double SAMPLE_POLL_TIME;
 	int64_t RESOLVER_STATE_MEMORY_LIMIT;
+	std::string RESOLVER_CONFLICT_SET_TYPE; // "skiplist" or "btree"
+	int RESOLVER_CONFLICT_CHECK_THREADS; // Threads checking the read conflict ranges of a batch, 1 checks them inline
+	int RESOLVER_CONFLICT_CHECK_MIN_RANGES; // Read conflict ranges each of those threads must get
+	bool RESOLVER_PREPARE_BATCH_EARLY; // Sort a batch's conflict ranges while it waits for the previous version
+	int RESOLVER_CONFLICT_FILTER_SLOTS; // Versioned bloom filter in front of the conflict set, 0 disables it
+	int RESOLVER_CONFLICT_FILTER_PREFIX_LENGTH; // Key bytes hashed by that filter
 
 	// Backup Worker
 	double BACKUP_TIMEOUT; // master's reaction time for backup failure
@@ -1108,6 +1137,8 @@ public:
 	int FETCH_BLOCK_BYTES;
 	int FETCH_KEYS_PARALLELISM_BYTES;
 	int FETCH_KEYS_PARALLELISM;
+	int FETCH_KEYS_PARALLEL_RANGES; // Sub-ranges of a shard fetchKeys reads at once
+	int64_t FETCH_KEYS_PARALLEL_RANGE_BYTES; // Approximate size of the sub-ranges fetchKeys splits a shard into
 	int FETCH_KEYS_LOWER_PRIORITY;
 	int SERVE_FETCH_CHECKPOINT_PARALLELISM;
 	int SERVE_AUDIT_STORAGE_PARALLELISM;
@@ -1133,6 +1164,10 @@ public:
 	int STORAGE_FETCH_BYTES;
 	int STORAGE_ROCKSDB_FETCH_BYTES;
 	double STORAGE_COMMIT_INTERVAL;
+	bool STORAGE_VERSIONED_MAP_BTREE; // Keep the versioned data of storage servers in a PBTree instead of a PTree
+	int64_t STORAGE_VALUE_CACHE_BYTES; // Size of the cache of values storage servers read from their engine, 0 disables it
+	int64_t STORAGE_COALESCE_WRITE_BYTES; // Mutation bytes of consecutive versions storage servers coalesce into one set of
+	                                      // engine writes, 0 disables it
 	int BYTE_SAMPLING_FACTOR;
 	int BYTE_SAMPLING_OVERHEAD;
 	double MIN_BYTE_SAMPLING_PROBABILITY; // Adjustable only for test of PhysicalShardMove. Should always be 0 for other
@@ -1169,6 +1204,7 @@ public:
 	bool STRICTLY_ENFORCE_BYTE_LIMIT;
 	double FRACTION_INDEX_BYTELIMIT_PREFETCH;
 	int MAX_PARALLEL_QUICK_GET_VALUE;
+	bool QUICK_GET_VALUE_BATCH_LOCAL; // Read the local keys of a batch of mapped point lookups with one GetValuesRequest
 	int CHECKPOINT_TRANSFER_BLOCK_BYTES;
 	int QUICK_GET_KEY_VALUES_LIMIT;
 	int QUICK_GET_KEY_VALUES_LIMIT_BYTES;
@@ -25,6 +25,7 @@
 #include "fdbclient/Audit.h"
 #include "fdbclient/BulkDumping.h"
 #include "fdbclient/FDBTypes.h"
+#include "fdbclient/RangeReadFilter.h"
 #include "fdbclient/StorageCheckpoint.h"
 #include "fdbclient/StorageServerShard.h"
 #include "fdbclient/VersionedMap.h"
@@ -97,6 +98,8 @@ struct StorageServerInterface {
 
 	PublicRequestStream<struct GetValueRequest> getValue;
 	PublicRequestStream<struct GetKeyRequest> getKey;
+	// Reads several keys at one version, throwing wrong_shard_server if any of them is not readable on this server
+	PublicRequestStream<struct GetValuesRequest> getValues;
 
 	// Throws a wrong_shard_server if the keys in the request or result depend on data outside this server OR if a large
 	// selector offset prevents all data from being read in one range read
@@ -197,6 +200,7 @@ public:
 			getCheckSum =
 			    RequestStream<struct GetStorageCheckSumRequest>(getValue.getEndpoint().getAdjustedEndpoint(25));
 			bulkdump = RequestStream<struct BulkDumpRequest>(getValue.getEndpoint().getAdjustedEndpoint(26));
+			getValues = PublicRequestStream<struct GetValuesRequest>(getValue.getEndpoint().getAdjustedEndpoint(27));
 		}
 	}
 	bool operator==(StorageServerInterface const& s) const { return uniqueID == s.uniqueID; }
@@ -230,6 +234,7 @@ public:
 		streams.push_back(getHotShards.getReceiver());
 		streams.push_back(getCheckSum.getReceiver());
 		streams.push_back(bulkdump.getReceiver());
+		streams.push_back(getValues.getReceiver(TaskPriority::LoadBalancedEndpoint));
 		FlowTransport::transport().addEndpoints(streams);
 	}
 };
@@ -311,6 +316,52 @@ struct GetValueRequest : TimedRequest {
 	}
 };
 
+struct GetValuesReply : public LoadBalancedReply {
+	constexpr static FileIdentifier file_identifier = 7914206;
+	// The values of the keys of the request, in the same order
+	std::vector<Optional<Value>> values;
+	bool cached;
+
+	GetValuesReply() : cached(false) {}
+	GetValuesReply(std::vector<Optional<Value>> values, bool cached) : values(std::move(values)), cached(cached) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, LoadBalancedReply::penalty, LoadBalancedReply::error, values, cached);
+	}
+};
+
+struct GetValuesRequest : TimedRequest {
+	constexpr static FileIdentifier file_identifier = 3315128;
+	SpanContext spanContext;
+	Arena arena;
+	VectorRef<KeyRef> keys;
+	Version version;
+	Optional<TagSet> tags;
+	ReplyPromise<GetValuesReply> reply;
+	Optional<ReadOptions> options;
+	VersionVector ssLatestCommitVersions; // includes the latest commit versions, as known
+	                                      // to this client, of all storage replicas that
+	                                      // serve the given keys
+	GetValuesRequest() {}
+
+	bool verify() const { return true; }
+
+	GetValuesRequest(SpanContext spanContext,
+	                 const Standalone<VectorRef<KeyRef>>& keys,
+	                 Version ver,
+	                 Optional<TagSet> tags,
+	                 Optional<ReadOptions> options,
+	                 VersionVector latestCommitVersions)
+	  : spanContext(spanContext), arena(keys.arena()), keys(keys), version(ver), tags(tags), options(options),
+	    ssLatestCommitVersions(latestCommitVersions) {}
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		serializer(ar, keys, version, tags, reply, spanContext, options, ssLatestCommitVersions, arena);
+	}
+};
+
 struct WatchValueReply {
 	constexpr static FileIdentifier file_identifier = 3;
 
@@ -360,12 +411,16 @@ struct GetKeyValuesReply : public LoadBalancedReply {
 	Version version; // useful when latestVersion was requested
 	bool more;
 	bool cached = false;
+	// Set when the request had a filter and more is true. Every row up to and including this key (down to it, for a
+	// reverse read) was examined, so the next read should resume past it even if data is empty.
+	Optional<KeyRef> lastScannedKey;
 
 	GetKeyValuesReply() : version(invalidVersion), more(false), cached(false) {}
 
 	template <class Ar>
 	void serialize(Ar& ar) {
-		serializer(ar, LoadBalancedReply::penalty, LoadBalancedReply::error, data, version, more, cached, arena);
+		serializer(
+		    ar, LoadBalancedReply::penalty, LoadBalancedReply::error, data, version, more, cached, lastScannedKey, arena);
 	}
 };
 
@@ -386,6 +441,9 @@ struct GetKeyValuesRequest : TimedRequest {
 	                                      // to this client, of all storage replicas that
 	                                      // serve the given key
 	Optional<TaskPriority> taskID; // includes the information about read purpose
+	// If present, only rows matching the filter are returned. limit and limitBytes still bound the rows examined, so a
+	// reply may hold fewer rows than they allow and yet have more set.
+	Optional<RangeReadFilterRef> filter;
 
 	GetKeyValuesRequest() {}
 
@@ -405,6 +463,7 @@ struct GetKeyValuesRequest : TimedRequest {
 		           options,
 		           ssLatestCommitVersions,
 		           taskID,
+		           filter,
 		           arena);
 	}
 };
@@ -1327,7 +1386,8 @@ struct BulkDumpRequest {
 	}
 };
 
-// Memory size for storing mutation in the mutation log and the versioned map.
+// Memory size for storing mutation in the mutation log and the versioned map. The nodes a PBTree versioned map copies
+// are not included; the storage server charges them as they are allocated.
 inline int mvccStorageBytes(int mutationBytes) {
 	// Why * 2:
 	// - 1 insertion into version map costs 2 nodes in avg;
@@ -38,10 +38,7 @@ Future<Void> deferredCleanupActor(std::vector<Tree> toFree, TaskPriority taskID
 		Tree a = std::move(toFree.back());
 		toFree.pop_back();
 
-		for (int c = 0; c < 3; c++) {
-			if (a->pointer[c] && a->pointer[c]->isSoleOwner())
-				toFree.push_back(std::move(a->pointer[c]));
-		}
+		releaseSoleOwnedChildren(a, toFree);
 
 		if (++freeCount % 100 == 0)
 			wait(yield(taskID));
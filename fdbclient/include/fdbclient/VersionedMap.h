@@ -25,6 +25,7 @@
 #include "flow/flow.h"
 #include "flow/IndexedSet.h"
 #include "fdbclient/FDBTypes.h"
+#include "fdbclient/PBTree.h"
 #include "flow/IRandom.h"
 #include "fdbclient/VersionedMap.actor.h"
 
@@ -130,6 +131,15 @@ public:
 	void trim_to_bound() { size_ = bound_sz_; }
 };
 
+// Moves the children of a that are only referenced by a into toFree, for deferredCleanupActor
+template <class T>
+void releaseSoleOwnedChildren(Reference<PTree<T>>& a, std::vector<Reference<PTree<T>>>& toFree) {
+	for (int c = 0; c < 3; c++) {
+		if (a->pointer[c] && a->pointer[c]->isSoleOwner())
+			toFree.push_back(std::move(a->pointer[c]));
+	}
+}
+
 template <class T>
 static Reference<PTree<T>> update(Reference<PTree<T>> const& node,
                                   bool which,
@@ -660,7 +670,7 @@ private:
 
 // VersionedMap provides an interface to a partially persistent tree, allowing you to read the values at a particular
 // version, create new versions, modify the current version of the tree, and forget versions prior to a specific
-// version.
+// version. The tree is a PTree, or a PBTree if the map is constructed with btree set.
 template <class K, class T>
 class VersionedMap : NonCopyable {
 	// private:
@@ -668,36 +678,61 @@ public:
 	typedef PTreeImpl::PTree<MapPair<K, std::pair<T, Version>>> PTreeT;
 	typedef PTreeImpl::PTreeFinger<MapPair<K, std::pair<T, Version>>> PTreeFingerT;
 	typedef Reference<PTreeT> Tree;
+	typedef PBTreeImpl::Node<K, std::pair<T, Version>> PBTreeT;
+	typedef PBTreeImpl::PBTreeFinger<K, std::pair<T, Version>> PBTreeFingerT;
+	typedef Reference<PBTreeT> BTree;
 
 	Version oldestVersion, latestVersion;
+	bool btree;
 
 	// This deque keeps track of PTree root nodes at various versions. Since the
 	// versions increase monotonically, the deque is implicitly sorted and hence
 	// binary-searchable.
 	std::deque<std::pair<Version, Tree>> roots;
+	// The PBTree root nodes at various versions, kept instead of roots if btree is set
+	std::deque<std::pair<Version, BTree>> btreeRoots;
 
 	struct rootsComparator {
-		bool operator()(const std::pair<Version, Tree>& value, const Version& key) { return (value.first < key); }
-		bool operator()(const Version& key, const std::pair<Version, Tree>& value) { return (key < value.first); }
+		template <class Root>
+		bool operator()(const std::pair<Version, Root>& value, const Version& key) {
+			return (value.first < key);
+		}
+		template <class Root>
+		bool operator()(const Version& key, const std::pair<Version, Root>& value) {
+			return (key < value.first);
+		}
 	};
 
-	Tree const& getRoot(Version v) const {
+	template <class Roots>
+	static typename Roots::value_type::second_type const& rootAt(Roots const& roots, Version v) {
 		auto r = upper_bound(roots.begin(), roots.end(), v, rootsComparator());
 		--r;
 		return r->second;
 	}
+	Tree const& getRoot(Version v) const { return rootAt(roots, v); }
+	BTree const& getBTreeRoot(Version v) const { return rootAt(btreeRoots, v); }
 
 	// For each item in the versioned map, 4 PTree nodes are potentially allocated:
 	static const int overheadPerItem = nextFastAllocatedSize(sizeof(PTreeT)) * 4;
 	struct iterator;
 
-	VersionedMap() : oldestVersion(0), latestVersion(0) { roots.emplace_back(0, Tree()); }
+	explicit VersionedMap(bool btree = false) : oldestVersion(0), latestVersion(0), btree(btree) {
+		if (btree) {
+			btreeRoots.emplace_back(0, BTree());
+		} else {
+			roots.emplace_back(0, Tree());
+		}
+	}
 	VersionedMap(VersionedMap&& v) noexcept
-	  : oldestVersion(v.oldestVersion), latestVersion(v.latestVersion), roots(std::move(v.roots)) {}
+	  : oldestVersion(v.oldestVersion), latestVersion(v.latestVersion), btree(v.btree), roots(std::move(v.roots)),
+	    btreeRoots(std::move(v.btreeRoots)), nodeBytesAllocated(std::exchange(v.nodeBytesAllocated, 0)) {}
 	void operator=(VersionedMap&& v) noexcept {
 		oldestVersion = v.oldestVersion;
 		latestVersion = v.latestVersion;
+		btree = v.btree;
 		roots = std::move(v.roots);
+		btreeRoots = std::move(v.btreeRoots);
+		nodeBytesAllocated = std::exchange(v.nodeBytesAllocated, 0);
 	}
 
 	Version getLatestVersion() const { return latestVersion; }
@@ -707,6 +742,23 @@ public:
 	Version getNextOldestVersion() const { return roots[1]->first; }
 
 	void forgetVersionsBefore(Version newOldestVersion) {
+		if (btree) {
+			forgetRootsBefore(btreeRoots, newOldestVersion);
+		} else {
+			forgetRootsBefore(roots, newOldestVersion);
+		}
+	}
+
+	Future<Void> forgetVersionsBeforeAsync(Version newOldestVersion, TaskPriority taskID = TaskPriority::DefaultYield) {
+		if (btree) {
+			return forgetRootsBeforeAsync(btreeRoots, newOldestVersion, taskID);
+		}
+		return forgetRootsBeforeAsync(roots, newOldestVersion, taskID);
+	}
+
+private:
+	template <class Roots>
+	void forgetRootsBefore(Roots& roots, Version newOldestVersion) {
 		ASSERT(newOldestVersion <= latestVersion);
 		auto r = upper_bound(roots.begin(), roots.end(), newOldestVersion, rootsComparator());
 		auto upper = r;
@@ -714,7 +766,7 @@ public:
 		// if the specified newOldestVersion does not exist, insert a new
 		// entry-pair with newOldestVersion and the root from next lower version
 		if (r->first != newOldestVersion) {
-			r = roots.emplace(upper, newOldestVersion, getRoot(newOldestVersion));
+			r = roots.emplace(upper, newOldestVersion, rootAt(roots, newOldestVersion));
 		}
 
 		UNSTOPPABLE_ASSERT(r->first == newOldestVersion);
@@ -722,7 +774,9 @@ public:
 		oldestVersion = newOldestVersion;
 	}
 
-	Future<Void> forgetVersionsBeforeAsync(Version newOldestVersion, TaskPriority taskID = TaskPriority::DefaultYield) {
+	template <class Roots>
+	Future<Void> forgetRootsBeforeAsync(Roots& roots, Version newOldestVersion, TaskPriority taskID) {
+		typedef typename Roots::value_type::second_type Root;
 		ASSERT_LE(newOldestVersion, latestVersion);
 		auto r = upper_bound(roots.begin(), roots.end(), newOldestVersion, rootsComparator());
 		auto upper = r;
@@ -730,15 +784,15 @@ public:
 		// if the specified newOldestVersion does not exist, insert a new
 		// entry-pair with newOldestVersion and the root from next lower version
 		if (r->first != newOldestVersion) {
-			r = roots.emplace(upper, newOldestVersion, getRoot(newOldestVersion));
+			r = roots.emplace(upper, newOldestVersion, rootAt(roots, newOldestVersion));
 		}
 
 		UNSTOPPABLE_ASSERT(r->first == newOldestVersion);
 
-		std::vector<Tree> toFree;
+		std::vector<Root> toFree;
 		toFree.reserve(10000);
 		auto newBegin = r;
-		Tree* lastRoot = nullptr;
+		Root* lastRoot = nullptr;
 		for (auto root = roots.begin(); root != newBegin; ++root) {
 			if (root->second) {
 				if (lastRoot != nullptr && root->second == *lastRoot) {
@@ -756,37 +810,93 @@ public:
 		return deferredCleanupActor(toFree, taskID);
 	}
 
+	int64_t nodeBytesAllocated = 0;
+
+	// Applies write to the latest PBTree root, counting the nodes it allocated in nodeBytesAllocated
+	template <class Write>
+	void writeBTree(Write&& write) {
+		const int64_t before = PBTreeImpl::allocatedNodeBytes();
+		write(btreeRoots.back().second);
+		nodeBytesAllocated += PBTreeImpl::allocatedNodeBytes() - before;
+	}
+
 public:
 	void createNewVersion(Version version) { // following sets and erases are into the given version, which may now be
 		                                     // passed to at().  Must be called in monotonically increasing order.
 		if (version > latestVersion) {
 			latestVersion = version;
-			Tree r = getRoot(version);
-			roots.emplace_back(version, r);
+			if (btree) {
+				BTree r = getBTreeRoot(version);
+				btreeRoots.emplace_back(version, r);
+			} else {
+				Tree r = getRoot(version);
+				roots.emplace_back(version, r);
+			}
 		} else
 			ASSERT(version == latestVersion);
 	}
 
+	// Returns the bytes of the PBTree nodes that inserts and erases copied or split since the last call. A PBTree node
+	// is copied at most once per version, so this is far less than a node per write. Always 0 for a PTree, whose nodes
+	// are estimated by overheadPerItem instead.
+	int64_t takeNodeBytesAllocated() { return std::exchange(nodeBytesAllocated, 0); }
+
 	// insert() and erase() invalidate atLatest() and all iterators into it
 	void insert(const K& k, const T& t) { insert(k, t, latestVersion); }
 	void insert(const K& k, const T& t, Version insertAt) {
+		if (btree) {
+			writeBTree([&](BTree& root) { PBTreeImpl::insert(root, latestVersion, k, std::make_pair(t, insertAt)); });
+			return;
+		}
 		PTreeImpl::insert(
 		    roots.back().second, latestVersion, MapPair<K, std::pair<T, Version>>(k, std::make_pair(t, insertAt)));
 	}
-	void erase(const K& begin, const K& end) { PTreeImpl::remove(roots.back().second, latestVersion, begin, end); }
+	void erase(const K& begin, const K& end) {
+		if (btree) {
+			writeBTree([&](BTree& root) { PBTreeImpl::remove(root, latestVersion, begin, end); });
+		} else {
+			PTreeImpl::remove(roots.back().second, latestVersion, begin, end);
+		}
+	}
 	void erase(const K& key) { // key must be present
-		PTreeImpl::remove(roots.back().second, latestVersion, key);
+		if (btree) {
+			writeBTree([&](BTree& root) { PBTreeImpl::remove(root, latestVersion, key); });
+		} else {
+			PTreeImpl::remove(roots.back().second, latestVersion, key);
+		}
 	}
 	void erase(iterator const& item) { // iterator must be in latest version!
 		ASSERT_EQ(item.at, latestVersion);
-		PTreeImpl::removeFinger(roots.back().second, latestVersion, item.finger);
+		if (btree) {
+			writeBTree([&](BTree& root) { PBTreeImpl::remove(root, latestVersion, item.key()); });
+		} else {
+			PTreeImpl::removeFinger(roots.back().second, latestVersion, item.finger);
+		}
 	}
 
-	void printDetail() { PTreeImpl::printTreeDetails(roots.back().second, 0); }
+	void printDetail() {
+		if (btree) {
+			printTree(latestVersion);
+		} else {
+			PTreeImpl::printTreeDetails(roots.back().second, 0);
+		}
+	}
 
-	void printTree(Version at) { PTreeImpl::printTree(roots.back().second, at, 0); }
+	void printTree(Version at) {
+		if (btree) {
+			if (getBTreeRoot(at)) {
+				PBTreeImpl::printTree(getBTreeRoot(at).getPtr());
+			}
+		} else {
+			PTreeImpl::printTree(roots.back().second, at, 0);
+		}
+	}
 
+	// PBTree nodes are copied instead of updated in place, so there is nothing to compact
 	void compact(Version newOldestVersion) {
+		if (btree) {
+			return;
+		}
 		ASSERT(newOldestVersion <= latestVersion);
 		// auto newBegin = roots.lower_bound(newOldestVersion);
 		auto newBegin = lower_bound(roots.begin(), roots.end(), newOldestVersion, rootsComparator());
@@ -800,65 +910,83 @@ public:
 
 	// for(auto i = vm.at(version).lower_bound(range.begin); i < range.end; ++i)
 	struct iterator {
-		explicit iterator(Tree const& root, Version at) : root(root), at(at) {}
+		explicit iterator(Tree const& root, Version at) : root(root), at(at), btree(false) {}
+		explicit iterator(BTree const& broot, Version at) : at(at), btree(true), broot(broot) {}
 
-		K const& key() const { return finger.back()->data.key; }
+		K const& key() const { return btree ? bfinger.key() : finger.back()->data.key; }
 		Version insertVersion() const {
-			return finger.back()->data.value.second;
+			return btree ? bfinger.value().second : finger.back()->data.value.second;
 		} // Returns the version at which the current item was inserted
-		operator bool() const { return finger.size() != 0; }
+		operator bool() const { return btree ? bfinger.size() != 0 : finger.size() != 0; }
 		bool operator<(const K& key) const { return this->key() < key; }
 
-		T const& operator*() { return finger.back()->data.value.first; }
-		T const* operator->() { return &finger.back()->data.value.first; }
+		T const& operator*() { return btree ? bfinger.value().first : finger.back()->data.value.first; }
+		T const* operator->() { return btree ? &bfinger.value().first : &finger.back()->data.value.first; }
 		void operator++() {
-			if (finger.size())
+			if (btree) {
+				if (bfinger.size())
+					bfinger.template move<true>();
+				else
+					PBTreeImpl::first(broot, bfinger);
+			} else if (finger.size())
 				PTreeImpl::next(at, finger);
 			else
 				PTreeImpl::first(root, at, finger);
 		}
 		void operator--() {
-			if (finger.size())
+			if (btree) {
+				if (bfinger.size())
+					bfinger.template move<false>();
+				else
+					PBTreeImpl::last(broot, bfinger);
+			} else if (finger.size())
 				PTreeImpl::previous(at, finger);
 			else
 				PTreeImpl::last(root, at, finger);
 		}
 		bool operator==(const iterator& r) const {
+			if (btree) {
+				if (bfinger.size() && r.bfinger.size())
+					return bfinger.leaf() == r.bfinger.leaf() && bfinger.index() == r.bfinger.index();
+				else
+					return bfinger.size() == r.bfinger.size();
+			}
 			if (finger.size() && r.finger.size())
 				return finger.back() == r.finger.back();
 			else
 				return finger.size() == r.finger.size();
 		}
-		bool operator!=(const iterator& r) const {
-			if (finger.size() && r.finger.size())
-				return finger.back() != r.finger.back();
-			else
-				return finger.size() != r.finger.size();
-		}
+		bool operator!=(const iterator& r) const { return !(*this == r); }
 
 	private:
 		friend class VersionedMap<K, T>;
 		Tree root;
 		Version at;
 		PTreeFingerT finger;
+		bool btree;
+		BTree broot;
+		PBTreeFingerT bfinger;
 	};
 
 	class ViewAtVersion {
 	public:
-		ViewAtVersion(Tree const& root, Version at) : root(root), at(at) {}
+		ViewAtVersion(Tree const& root, Version at) : root(root), at(at), btree(false) {}
+		ViewAtVersion(BTree const& broot, Version at) : at(at), btree(true), broot(broot) {}
 
 		iterator begin() const {
-			iterator i(root, at);
-			PTreeImpl::first(root, at, i.finger);
+			iterator i = end();
+			if (btree)
+				PBTreeImpl::first(broot, i.bfinger);
+			else
+				PTreeImpl::first(root, at, i.finger);
 			return i;
 		}
-		iterator end() const { return iterator(root, at); }
+		iterator end() const { return btree ? iterator(broot, at) : iterator(root, at); }
 
 		// Returns x such that key==*x, or end()
 		template <class X>
 		iterator find(const X& key) const {
-			iterator i(root, at);
-			PTreeImpl::lower_bound(root, at, key, i.finger);
+			iterator i = lower_bound(key);
 			if (i && i.key() == key)
 				return i;
 			else
@@ -868,24 +996,29 @@ public:
 		// Returns the smallest x such that *x>=key, or end()
 		template <class X>
 		iterator lower_bound(const X& key) const {
-			iterator i(root, at);
-			PTreeImpl::lower_bound(root, at, key, i.finger);
+			iterator i = end();
+			if (btree)
+				PBTreeImpl::lower_bound(broot, key, i.bfinger);
+			else
+				PTreeImpl::lower_bound(root, at, key, i.finger);
 			return i;
 		}
 
 		// Returns the smallest x such that *x>key, or end()
 		template <class X>
 		iterator upper_bound(const X& key) const {
-			iterator i(root, at);
-			PTreeImpl::upper_bound(root, at, key, i.finger);
+			iterator i = end();
+			if (btree)
+				PBTreeImpl::upper_bound(broot, key, i.bfinger);
+			else
+				PTreeImpl::upper_bound(root, at, key, i.finger);
 			return i;
 		}
 
 		// Returns the largest x such that *x<=key, or end()
 		template <class X>
 		iterator lastLessOrEqual(const X& key) const {
-			iterator i(root, at);
-			PTreeImpl::upper_bound(root, at, key, i.finger);
+			iterator i = upper_bound(key);
 			--i;
 			return i;
 		}
@@ -893,14 +1026,18 @@ public:
 		// Returns the largest x such that *x<key, or end()
 		template <class X>
 		iterator lastLess(const X& key) const {
-			iterator i(root, at);
-			PTreeImpl::lower_bound(root, at, key, i.finger);
+			iterator i = lower_bound(key);
 			--i;
 			return i;
 		}
 
 		void validate() {
 			int count = 0, height = 0;
+			if (btree) {
+				if (broot)
+					PBTreeImpl::validate<K, std::pair<T, Version>>(broot.getPtr(), nullptr, nullptr, true, count);
+				return;
+			}
 			PTreeImpl::validate<MapPair<K, std::pair<T, Version>>>(root, at, nullptr, nullptr, count, height);
 			if (height > 100)
 				TraceEvent(SevWarnAlways, "DiabolicalPTreeSize").detail("Size", count).detail("Height", height);
@@ -909,6 +1046,8 @@ public:
 	private:
 		Tree root;
 		Version at;
+		bool btree;
+		BTree broot;
 	};
 
 	ViewAtVersion at(Version v) const {
@@ -916,9 +1055,17 @@ public:
 			return atLatest();
 		}
 
+		if (btree) {
+			return ViewAtVersion(getBTreeRoot(v), v);
+		}
 		return ViewAtVersion(getRoot(v), v);
 	}
-	ViewAtVersion atLatest() const { return ViewAtVersion(roots.back().second, latestVersion); }
+	ViewAtVersion atLatest() const {
+		if (btree) {
+			return ViewAtVersion(btreeRoots.back().second, latestVersion);
+		}
+		return ViewAtVersion(roots.back().second, latestVersion);
+	}
 
 	bool isClearContaining(ViewAtVersion const& view, KeyRef key) {
 		auto i = view.lastLessOrEqual(key);
@@ -0,0 +1,819 @@
+/*
+ * AsyncFileIOUring.actor.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+#ifdef __linux__
+
+// IORING_OP_READ, IORING_OP_WRITE and the opcode probe need the headers of Linux 5.6 or later. With older headers
+// AsyncFileIOUring is left out, and Net2FileSystem uses AsyncFileKAIO.
+#if defined __has_include
+#if __has_include(<linux/io_uring.h>)
+#include <linux/io_uring.h>
+#ifdef IORING_FEAT_RW_CUR_POS
+#define HAVE_LINUX_IO_URING
+#endif
+#endif
+#endif
+
+#ifdef HAVE_LINUX_IO_URING
+
+// When actually compiled (NO_INTELLISENSE), include the generated version of this file.  In intellisense use the source
+// version.
+#if defined(NO_INTELLISENSE) && !defined(FLOW_ASYNCFILEIOURING_ACTOR_G_H)
+#define FLOW_ASYNCFILEIOURING_ACTOR_G_H
+#include "fdbrpc/AsyncFileIOUring.actor.g.h"
+#elif !defined(FLOW_ASYNCFILEIOURING_ACTOR_H)
+#define FLOW_ASYNCFILEIOURING_ACTOR_H
+
+#include "flow/IAsyncFile.h"
+
+#include <fcntl.h>
+#include <set>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include "fdbrpc/AsyncFileEIO.actor.h"
+#include "fdbrpc/Stats.h"
+#include "flow/Knobs.h"
+#include "flow/UnitTest.h"
+#include "flow/genericactors.actor.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// An IAsyncFile for unbuffered files using io_uring, used instead of AsyncFileKAIO when the USE_IO_URING knob is set.
+//
+// Operations issued while running flow tasks are queued, and submitted together with a single io_uring_enter() at the
+// end of the run loop iteration. fdatasync goes through the ring too, instead of a thread of AsyncFileEIO. A sync()
+// also makes durable the writes to the file which were issued but not completed when it was called. If its fdatasync
+// is submitted together with the only such write, the two are linked so that the kernel starts the fdatasync as soon
+// as the write completes, otherwise it is submitted once the writes complete.
+class AsyncFileIOUring final : public IAsyncFile, public ReferenceCounted<AsyncFileIOUring> {
+public:
+	StringRef getClassName() override { return "AsyncFileIOUring"_sr; }
+
+	struct AsyncFileIOUringMetrics {
+		LatencySample readLatencySample = { "AsyncFileIOUringReadLatency",
+			                                UID(),
+			                                FLOW_KNOBS->KAIO_LATENCY_LOGGING_INTERVAL,
+			                                FLOW_KNOBS->KAIO_LATENCY_SKETCH_ACCURACY };
+		LatencySample writeLatencySample = { "AsyncFileIOUringWriteLatency",
+			                                 UID(),
+			                                 FLOW_KNOBS->KAIO_LATENCY_LOGGING_INTERVAL,
+			                                 FLOW_KNOBS->KAIO_LATENCY_SKETCH_ACCURACY };
+		LatencySample syncLatencySample = { "AsyncFileIOUringSyncLatency",
+			                                UID(),
+			                                FLOW_KNOBS->KAIO_LATENCY_LOGGING_INTERVAL,
+			                                FLOW_KNOBS->KAIO_LATENCY_SKETCH_ACCURACY };
+	};
+
+	static AsyncFileIOUringMetrics& getMetrics() {
+		static AsyncFileIOUringMetrics metrics;
+		return metrics;
+	}
+
+	static Future<Reference<IAsyncFile>> open(std::string filename, int flags, int mode, void* ignore) {
+		ASSERT(isInitialized());
+		ASSERT(flags & OPEN_UNBUFFERED);
+
+		if (flags & OPEN_LOCK)
+			mode |= 02000; // Enable mandatory locking for this file if it is supported by the filesystem
+
+		std::string open_filename = filename;
+		if (flags & OPEN_ATOMIC_WRITE_AND_CREATE) {
+			ASSERT((flags & OPEN_CREATE) && (flags & OPEN_READWRITE) && !(flags & OPEN_EXCLUSIVE));
+			open_filename = filename + ".part";
+		}
+
+		int fd = ::open(open_filename.c_str(), openFlags(flags), mode);
+		if (fd < 0) {
+			Error e = errno == ENOENT ? file_not_found() : io_error();
+			TraceEvent("AsyncFileIOUringOpenFailed")
+			    .error(e)
+			    .detail("Filename", filename)
+			    .detailf("Flags", "%x", flags)
+			    .detailf("OSFlags", "%x", openFlags(flags))
+			    .detailf("Mode", "0%o", mode)
+			    .GetLastError();
+			return e;
+		} else {
+			TraceEvent("AsyncFileIOUringOpen")
+			    .detail("Filename", filename)
+			    .detail("Flags", flags)
+			    .detail("Mode", mode)
+			    .detail("Fd", fd);
+		}
+
+		Reference<AsyncFileIOUring> r(new AsyncFileIOUring(fd, flags, filename));
+
+		if (flags & OPEN_LOCK) {
+			// Acquire a "write" lock for the entire file
+			flock lockDesc;
+			lockDesc.l_type = F_WRLCK;
+			lockDesc.l_whence = SEEK_SET;
+			lockDesc.l_start = 0;
+			lockDesc.l_len = 0; // Lock all bytes, no matter how large the file grows
+			lockDesc.l_pid = 0;
+			if (fcntl(fd, F_SETLK, &lockDesc) == -1) {
+				TraceEvent(SevWarn, "UnableToLockFile").detail("Filename", filename).GetLastError();
+				return lock_file_failure();
+			}
+		}
+
+		struct stat buf;
+		if (fstat(fd, &buf)) {
+			TraceEvent("AsyncFileIOUringFStatError").detail("Fd", fd).detail("Filename", filename).GetLastError();
+			return io_error();
+		}
+
+		r->lastFileSize = r->nextFileSize = buf.st_size;
+		return Reference<IAsyncFile>(std::move(r));
+	}
+
+	// Creates the ring, returning false if io_uring or the operations used are not supported by the kernel
+	static bool setup() {
+		ASSERT(!isInitialized());
+		io_uring_params params;
+		memset(&params, 0, sizeof(params));
+		int ringFd = syscall(__NR_io_uring_setup, FLOW_KNOBS->MAX_OUTSTANDING, &params);
+		if (ringFd < 0) {
+			TraceEvent(SevWarnAlways, "IOUringSetupError").GetLastError();
+			return false;
+		}
+
+		// IORING_OP_READ and IORING_OP_WRITE need Linux 5.6
+		const int probeOps = 256;
+		std::vector<uint8_t> probeBuffer(sizeof(io_uring_probe) + probeOps * sizeof(io_uring_probe_op));
+		io_uring_probe* probe = (io_uring_probe*)probeBuffer.data();
+		if (syscall(__NR_io_uring_register, ringFd, IORING_REGISTER_PROBE, probe, probeOps) < 0 ||
+		    probe->last_op < IORING_OP_WRITE || !(probe->ops[IORING_OP_READ].flags & IO_URING_OP_SUPPORTED) ||
+		    !(probe->ops[IORING_OP_WRITE].flags & IO_URING_OP_SUPPORTED) ||
+		    !(probe->ops[IORING_OP_FSYNC].flags & IO_URING_OP_SUPPORTED)) {
+			TraceEvent(SevWarnAlways, "IOUringOperationsNotSupported").GetLastError();
+			close(ringFd);
+			return false;
+		}
+
+		size_t sqRingSize = params.sq_off.array + params.sq_entries * sizeof(uint32_t);
+		size_t cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+		if (params.features & IORING_FEAT_SINGLE_MMAP) {
+			sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+		}
+		uint8_t* sqRing = (uint8_t*)mmap(
+		    nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_SQ_RING);
+		uint8_t* cqRing = sqRing;
+		if (sqRing != MAP_FAILED && !(params.features & IORING_FEAT_SINGLE_MMAP)) {
+			cqRing = (uint8_t*)mmap(
+			    nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ringFd, IORING_OFF_CQ_RING);
+		}
+		io_uring_sqe* sqes = (io_uring_sqe*)mmap(nullptr,
+		                                         params.sq_entries * sizeof(io_uring_sqe),
+		                                         PROT_READ | PROT_WRITE,
+		                                         MAP_SHARED | MAP_POPULATE,
+		                                         ringFd,
+		                                         IORING_OFF_SQES);
+		if (sqRing == MAP_FAILED || cqRing == MAP_FAILED || sqes == MAP_FAILED) {
+			TraceEvent(SevWarnAlways, "IOUringMmapError").GetLastError();
+			if (sqes != MAP_FAILED) {
+				munmap(sqes, params.sq_entries * sizeof(io_uring_sqe));
+			}
+			if (cqRing != MAP_FAILED && cqRing != sqRing) {
+				munmap(cqRing, cqRingSize);
+			}
+			if (sqRing != MAP_FAILED) {
+				munmap(sqRing, sqRingSize);
+			}
+			close(ringFd);
+			return false;
+		}
+
+		ctx.ringFd = ringFd;
+		ctx.sqTail = (uint32_t*)(sqRing + params.sq_off.tail);
+		ctx.sqMask = *(uint32_t*)(sqRing + params.sq_off.ring_mask);
+		ctx.sqArray = (uint32_t*)(sqRing + params.sq_off.array);
+		ctx.sqes = sqes;
+		ctx.cqHead = (uint32_t*)(cqRing + params.cq_off.head);
+		ctx.cqTail = (uint32_t*)(cqRing + params.cq_off.tail);
+		ctx.cqMask = *(uint32_t*)(cqRing + params.cq_off.ring_mask);
+		ctx.cqes = (io_uring_cqe*)(cqRing + params.cq_off.cqes);
+		return true;
+	}
+
+	static void init(Reference<IEventFD> ev, double ioTimeout) {
+		ASSERT(isInitialized());
+		if (!g_network->isSimulated()) {
+			ctx.countSubmit.init("AsyncFile.CountIOUringSubmit"_sr);
+			ctx.countCollect.init("AsyncFile.CountIOUringCollect"_sr);
+			ctx.countLinkedSyncs.init("AsyncFile.CountIOUringLinkedSyncs"_sr);
+			ctx.submitMetric.init("AsyncFile.Submit"_sr);
+		}
+
+		int evfd = ev->getFD();
+		if (syscall(__NR_io_uring_register, ctx.ringFd, IORING_REGISTER_EVENTFD, &evfd, 1) < 0) {
+			TraceEvent("IOUringRegisterEventFDError").GetLastError();
+			throw io_error();
+		}
+		setTimeout(ioTimeout);
+		poll(ev);
+
+		g_network->setGlobal(INetwork::enRunCycleFunc, (flowGlobalType)&AsyncFileIOUring::launch);
+	}
+
+	static bool isInitialized() { return ctx.ringFd >= 0; }
+	static void setTimeout(double ioTimeout) { ctx.setIOTimeout(ioTimeout); }
+
+	void addref() override { ReferenceCounted<AsyncFileIOUring>::addref(); }
+	void delref() override { ReferenceCounted<AsyncFileIOUring>::delref(); }
+
+	Future<int> read(void* data, int length, int64_t offset) override {
+		++countFileLogicalReads;
+		++countLogicalReads;
+
+		if (failed) {
+			return io_timeout();
+		}
+
+		IOBlock* io = new IOBlock(IORING_OP_READ, fd);
+		io->buf = data;
+		io->nbytes = length;
+		io->offset = offset;
+
+		enqueue(io, this);
+		return io->result.getFuture();
+	}
+
+	Future<Void> write(void const* data, int length, int64_t offset) override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if (failed) {
+			return io_timeout();
+		}
+
+		IOBlock* io = new IOBlock(IORING_OP_WRITE, fd);
+		io->buf = (void*)data;
+		io->nbytes = length;
+		io->offset = offset;
+		io->writeSeq = ++writesIssued;
+		incompleteWrites.insert(io->writeSeq);
+		lastQueuedWrite = io;
+
+		nextFileSize = std::max(nextFileSize, offset + length);
+
+		enqueue(io, this);
+		return success(io->result.getFuture());
+	}
+
+#ifndef FALLOC_FL_ZERO_RANGE
+#define FALLOC_FL_ZERO_RANGE 0x10
+#endif
+	Future<Void> zeroRange(int64_t offset, int64_t length) override {
+		if (ctx.fallocateZeroSupported) {
+			int rc = fallocate(fd, FALLOC_FL_ZERO_RANGE, offset, length);
+			if (rc == 0) {
+				return Void();
+			}
+			if (errno == EOPNOTSUPP) {
+				ctx.fallocateZeroSupported = false;
+			}
+		}
+		return IAsyncFile::zeroRange(offset, length);
+	}
+
+	Future<Void> truncate(int64_t size) override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if (failed) {
+			return io_timeout();
+		}
+
+		int result = -1;
+		bool completed = false;
+		double begin = timer_monotonic();
+
+		if (ctx.fallocateSupported && size >= lastFileSize) {
+			result = fallocate(fd, 0, 0, size);
+			if (result != 0) {
+				int fallocateErrCode = errno;
+				TraceEvent("AsyncFileIOUringAllocateError")
+				    .detail("Fd", fd)
+				    .detail("Filename", filename)
+				    .detail("Size", size)
+				    .GetLastError();
+				if (fallocateErrCode == EOPNOTSUPP) {
+					// Mark fallocate as unsupported. Try again with truncate.
+					ctx.fallocateSupported = false;
+				} else {
+					return io_error();
+				}
+			} else {
+				completed = true;
+			}
+		}
+		if (!completed)
+			result = ftruncate(fd, size);
+
+		double end = timer_monotonic();
+		if (nondeterministicRandom()->random01() < end - begin) {
+			TraceEvent("SlowIOUringTruncate")
+			    .detail("TruncateTime", end - begin)
+			    .detail("TruncateBytes", size - lastFileSize);
+		}
+
+		if (result != 0) {
+			TraceEvent("AsyncFileIOUringTruncateError").detail("Fd", fd).detail("Filename", filename).GetLastError();
+			return io_error();
+		}
+
+		lastFileSize = nextFileSize = size;
+
+		return Void();
+	}
+
+	ACTOR static Future<Void> throwErrorIfFailed(Reference<AsyncFileIOUring> self, Future<int> sync, double startTime) {
+		wait(success(sync));
+		if (self->failed) {
+			throw io_timeout();
+		}
+		getMetrics().syncLatencySample.addMeasurement(timer() - startTime);
+		return Void();
+	}
+
+	Future<Void> sync() override {
+		++countFileLogicalWrites;
+		++countLogicalWrites;
+
+		if (failed) {
+			return io_timeout();
+		}
+
+		IOBlock* io = new IOBlock(IORING_OP_FSYNC, fd);
+		io->writeSeq = writesIssued;
+		Future<Void> fsync =
+		    throwErrorIfFailed(Reference<AsyncFileIOUring>::addRef(this), io->result.getFuture(), timer());
+
+		assign(io, this);
+		if (incompleteWrites.empty()) {
+			ctx.queue.push(io);
+		} else if (incompleteWrites.size() == 1 && lastQueuedWrite && !lastQueuedWrite->linkedSync) {
+			lastQueuedWrite->linkedSync = io;
+		} else {
+			waitingSyncs.push_back(io);
+		}
+
+		if (flags & OPEN_ATOMIC_WRITE_AND_CREATE) {
+			flags &= ~OPEN_ATOMIC_WRITE_AND_CREATE;
+
+			return AsyncFileEIO::waitAndAtomicRename(fsync, filename + ".part", filename);
+		}
+
+		return fsync;
+	}
+
+	bool syncCoversPendingWrites() const override { return true; }
+	Future<int64_t> size() const override { return nextFileSize; }
+	int64_t debugFD() const override { return fd; }
+	std::string getFilename() const override { return filename; }
+	~AsyncFileIOUring() override { close(fd); }
+
+	static void launch() {
+		const bool launchQueued =
+		    ctx.queue.size() && ctx.outstanding < FLOW_KNOBS->MAX_OUTSTANDING - FLOW_KNOBS->MIN_SUBMIT;
+		// Entries a previous io_uring_enter() did not consume are entered again even if nothing new was queued, since
+		// nothing else would submit them
+		if (!launchQueued && !ctx.unsubmitted) {
+			return;
+		}
+		ctx.submitMetric = true;
+
+		double begin = timer_monotonic();
+		if (launchQueued) {
+			if (!ctx.outstanding)
+				ctx.ioStallBegin = begin;
+
+			double start = timer();
+			uint32_t tail = *ctx.sqTail;
+			int n = 0;
+			while (ctx.queue.size() && ctx.outstanding + n + 2 <= FLOW_KNOBS->MAX_OUTSTANDING) {
+				IOBlock* io = ctx.queue.top();
+				ctx.queue.pop();
+
+				if (io->owner->lastQueuedWrite == io) {
+					io->owner->lastQueuedWrite = nullptr;
+				}
+				if (io->owner->lastFileSize != io->owner->nextFileSize) {
+					io->owner->truncate(io->owner->nextFileSize);
+				}
+
+				io->prepare(ctx.sqes[tail & ctx.sqMask], start);
+				ctx.sqArray[tail & ctx.sqMask] = tail & ctx.sqMask;
+				++tail;
+				++n;
+				if (io->linkedSync) {
+					ctx.sqes[(tail - 1) & ctx.sqMask].flags |= IOSQE_IO_LINK;
+					io->linkedSync->prepare(ctx.sqes[tail & ctx.sqMask], start);
+					ctx.sqArray[tail & ctx.sqMask] = tail & ctx.sqMask;
+					++tail;
+					++n;
+					++ctx.countLinkedSyncs;
+					io->linkedSync = nullptr;
+				}
+			}
+			__atomic_store_n(ctx.sqTail, tail, __ATOMIC_RELEASE);
+			ctx.outstanding += n;
+			ctx.unsubmitted += n;
+		}
+
+		int rc = syscall(__NR_io_uring_enter, ctx.ringFd, ctx.unsubmitted, 0, 0, nullptr, 0);
+		if (rc >= 0) {
+			ctx.unsubmitted -= rc;
+		} else if (errno != EAGAIN && errno != EBUSY && errno != EINTR) {
+			TraceEvent(SevWarnAlways, "IOUringEnterError").suppressFor(1.0).GetLastError();
+		}
+		// Entries the kernel did not consume stay in the submission queue, and are entered again by the next launch(),
+		// which runs every run loop iteration. If no completion is coming to wake the run loop, a retry does.
+		if (ctx.unsubmitted && ctx.outstanding == ctx.unsubmitted && !ctx.submitRetryScheduled) {
+			retryLaunch();
+		}
+
+		ctx.submitMetric = false;
+		++ctx.countSubmit;
+
+		double elapsed = timer_monotonic() - begin;
+		g_network->networkInfo.metrics.secSquaredSubmit += elapsed * elapsed / 2;
+	}
+
+	bool failed;
+
+private:
+	int fd, flags;
+	int64_t lastFileSize, nextFileSize;
+	std::string filename;
+	Int64MetricHandle countFileLogicalWrites;
+	Int64MetricHandle countFileLogicalReads;
+
+	Int64MetricHandle countLogicalWrites;
+	Int64MetricHandle countLogicalReads;
+
+	struct IOBlock;
+
+	uint64_t writesIssued; // Sequence number of the last write issued
+	std::set<uint64_t> incompleteWrites; // Sequence numbers of the writes issued and not completed
+	IOBlock* lastQueuedWrite; // The last write issued if it has not been submitted yet
+	std::vector<IOBlock*> waitingSyncs; // Syncs waiting for the writes issued before them to complete
+
+	struct IOBlock : FastAllocated<IOBlock> {
+		uint8_t opcode;
+		int fd;
+		void* buf;
+		uint32_t nbytes;
+		int64_t offset;
+		// For a write its sequence number within the file, for a sync the sequence number of the last write before it
+		uint64_t writeSeq;
+		IOBlock* linkedSync; // A sync to submit linked to this write
+		Promise<int> result;
+		Reference<AsyncFileIOUring> owner;
+		int64_t prio;
+		IOBlock* prev;
+		IOBlock* next;
+		double startTime;
+
+		struct indirect_order_by_priority {
+			bool operator()(IOBlock* a, IOBlock* b) { return a->prio < b->prio; }
+		};
+
+		IOBlock(uint8_t opcode, int fd)
+		  : opcode(opcode), fd(fd), buf(nullptr), nbytes(0), offset(0), writeSeq(0), linkedSync(nullptr), prio(0),
+		    prev(nullptr), next(nullptr), startTime(0) {}
+
+		TaskPriority getTask() const { return static_cast<TaskPriority>((prio >> 32) + 1); }
+
+		void prepare(io_uring_sqe& sqe, double start) {
+			memset(&sqe, 0, sizeof(sqe));
+			sqe.opcode = opcode;
+			sqe.fd = fd;
+			sqe.addr = (uint64_t)buf;
+			sqe.len = nbytes;
+			sqe.off = offset;
+			if (opcode == IORING_OP_FSYNC) {
+				sqe.fsync_flags = IORING_FSYNC_DATASYNC;
+			}
+			sqe.user_data = (uint64_t)this;
+			startTime = start;
+			if (ctx.ioTimeout > 0) {
+				ctx.appendToRequestList(this);
+			}
+		}
+
+		ACTOR static void deliver(Promise<int> result, bool failed, int r, TaskPriority task) {
+			wait(delay(0, task));
+			if (failed)
+				result.sendError(io_timeout());
+			else if (r < 0)
+				result.sendError(io_error());
+			else
+				result.send(r);
+		}
+
+		void setResult(int r) {
+			if (r < 0) {
+				errno = -r;
+				TraceEvent("AsyncFileIOUringIOError")
+				    .GetLastError()
+				    .detail("Fd", fd)
+				    .detail("Op", opcode)
+				    .detail("Nbytes", nbytes)
+				    .detail("Offset", offset)
+				    .detail("Ptr", int64_t(buf))
+				    .detail("Filename", owner->filename);
+			}
+			if (opcode == IORING_OP_WRITE) {
+				owner->writeCompleted(writeSeq);
+			}
+			deliver(result, owner->failed, r, getTask());
+			delete this;
+		}
+
+		void timeout(bool warnOnly) {
+			TraceEvent(SevWarnAlways, "AsyncFileIOUringTimeout")
+			    .detail("Fd", fd)
+			    .detail("Op", opcode)
+			    .detail("Nbytes", nbytes)
+			    .detail("Offset", offset)
+			    .detail("Ptr", int64_t(buf))
+			    .detail("Filename", owner->filename);
+			g_network->setGlobal(INetwork::enASIOTimedOut, (flowGlobalType) true);
+
+			if (!warnOnly)
+				owner->failed = true;
+		}
+	};
+
+	struct Context {
+		int ringFd;
+		uint32_t* sqTail;
+		uint32_t sqMask;
+		uint32_t* sqArray;
+		io_uring_sqe* sqes;
+		uint32_t* cqHead;
+		uint32_t* cqTail;
+		uint32_t cqMask;
+		io_uring_cqe* cqes;
+
+		int outstanding; // Entries submitted or in the submission queue, and not completed
+		int unsubmitted; // Entries in the submission queue which io_uring_enter() has not consumed yet
+		bool submitRetryScheduled; // Whether retryLaunch() is waiting to run launch() again
+		double ioStallBegin;
+		bool fallocateSupported;
+		bool fallocateZeroSupported;
+		std::priority_queue<IOBlock*, std::vector<IOBlock*>, IOBlock::indirect_order_by_priority> queue;
+		Int64MetricHandle countSubmit;
+		Int64MetricHandle countCollect;
+		Int64MetricHandle countLinkedSyncs;
+		Int64MetricHandle submitMetric;
+
+		double ioTimeout;
+		bool timeoutWarnOnly;
+		IOBlock* submittedRequestList;
+
+		uint32_t opsIssued;
+		Context()
+		  : ringFd(-1), sqTail(nullptr), sqMask(0), sqArray(nullptr), sqes(nullptr),
+		    cqHead(nullptr), cqTail(nullptr), cqMask(0), cqes(nullptr), outstanding(0), unsubmitted(0),
+		    submitRetryScheduled(false), ioStallBegin(0), fallocateSupported(true), fallocateZeroSupported(true),
+		    submittedRequestList(nullptr), opsIssued(0) {
+			setIOTimeout(0);
+		}
+
+		void setIOTimeout(double timeout) {
+			ioTimeout = fabs(timeout);
+			timeoutWarnOnly = timeout < 0;
+		}
+
+		void appendToRequestList(IOBlock* io) {
+			ASSERT(!io->next && !io->prev);
+
+			if (submittedRequestList) {
+				io->prev = submittedRequestList->prev;
+				io->prev->next = io;
+
+				submittedRequestList->prev = io;
+				io->next = submittedRequestList;
+			} else {
+				submittedRequestList = io;
+				io->next = io->prev = io;
+			}
+		}
+
+		void removeFromRequestList(IOBlock* io) {
+			if (io->next == nullptr) {
+				ASSERT(io->prev == nullptr);
+				return;
+			}
+
+			ASSERT(io->prev != nullptr);
+
+			if (io == io->next) {
+				ASSERT(io == submittedRequestList && io == io->prev);
+				submittedRequestList = nullptr;
+			} else {
+				io->next->prev = io->prev;
+				io->prev->next = io->next;
+
+				if (submittedRequestList == io) {
+					submittedRequestList = io->next;
+				}
+			}
+
+			io->next = io->prev = nullptr;
+		}
+	};
+	static Context ctx;
+
+	explicit AsyncFileIOUring(int fd, int flags, std::string const& filename)
+	  : failed(false), fd(fd), flags(flags), filename(filename), writesIssued(0), lastQueuedWrite(nullptr) {
+		if (!g_network->isSimulated()) {
+			countFileLogicalWrites.init("AsyncFile.CountFileLogicalWrites"_sr, filename);
+			countFileLogicalReads.init("AsyncFile.CountFileLogicalReads"_sr, filename);
+			countLogicalWrites.init("AsyncFile.CountLogicalWrites"_sr);
+			countLogicalReads.init("AsyncFile.CountLogicalReads"_sr);
+		}
+	}
+
+	static void assign(IOBlock* io, AsyncFileIOUring* owner) {
+		ASSERT(int64_t(io->buf) % 4096 == 0 && io->offset % 4096 == 0 && io->nbytes % 4096 == 0);
+
+		io->prio = (int64_t(g_network->getCurrentTask()) << 32) - (++ctx.opsIssued);
+		io->owner = Reference<AsyncFileIOUring>::addRef(owner);
+	}
+
+	static void enqueue(IOBlock* io, AsyncFileIOUring* owner) {
+		assign(io, owner);
+		ctx.queue.push(io);
+	}
+
+	// Queues the syncs which were waiting for the writes before them, once those have completed
+	void writeCompleted(uint64_t writeSeq) {
+		incompleteWrites.erase(writeSeq);
+		const uint64_t firstIncomplete = incompleteWrites.empty() ? writesIssued + 1 : *incompleteWrites.begin();
+		for (int i = 0; i < waitingSyncs.size();) {
+			if (waitingSyncs[i]->writeSeq < firstIncomplete) {
+				IOBlock* io = waitingSyncs[i];
+				waitingSyncs[i] = waitingSyncs.back();
+				waitingSyncs.pop_back();
+				ctx.queue.push(io);
+			} else {
+				++i;
+			}
+		}
+	}
+
+	static int openFlags(int flags) {
+		int oflags = O_DIRECT | O_CLOEXEC;
+		ASSERT(bool(flags & OPEN_READONLY) != bool(flags & OPEN_READWRITE)); // readonly xor readwrite
+		if (flags & OPEN_EXCLUSIVE)
+			oflags |= O_EXCL;
+		if (flags & OPEN_CREATE)
+			oflags |= O_CREAT;
+		if (flags & OPEN_READONLY)
+			oflags |= O_RDONLY;
+		if (flags & OPEN_READWRITE)
+			oflags |= O_RDWR;
+		if (flags & OPEN_ATOMIC_WRITE_AND_CREATE)
+			oflags |= O_TRUNC;
+		return oflags;
+	}
+
+	ACTOR static void retryLaunch() {
+		ctx.submitRetryScheduled = true;
+		wait(delay(0.001, TaskPriority::DiskIOComplete));
+		ctx.submitRetryScheduled = false;
+	}
+
+	ACTOR static void poll(Reference<IEventFD> ev) {
+		loop {
+			wait(success(ev->read()));
+
+			wait(delay(0, TaskPriority::DiskIOComplete));
+
+			double currentTime = timer();
+			++ctx.countCollect;
+
+			std::vector<std::pair<IOBlock*, int>> completed;
+			uint32_t head = *ctx.cqHead;
+			const uint32_t tail = __atomic_load_n(ctx.cqTail, __ATOMIC_ACQUIRE);
+			for (; head != tail; ++head) {
+				const io_uring_cqe& cqe = ctx.cqes[head & ctx.cqMask];
+				completed.emplace_back((IOBlock*)cqe.user_data, cqe.res);
+			}
+			__atomic_store_n(ctx.cqHead, head, __ATOMIC_RELEASE);
+
+			if (completed.size()) {
+				double t = timer_monotonic();
+				double elapsed = t - ctx.ioStallBegin;
+				ctx.ioStallBegin = t;
+				g_network->networkInfo.metrics.secSquaredDiskStall += elapsed * elapsed / 2;
+			}
+
+			ctx.outstanding -= completed.size();
+
+			if (ctx.ioTimeout > 0) {
+				while (ctx.submittedRequestList && currentTime - ctx.submittedRequestList->startTime > ctx.ioTimeout) {
+					ctx.submittedRequestList->timeout(ctx.timeoutWarnOnly);
+					ctx.removeFromRequestList(ctx.submittedRequestList);
+				}
+			}
+
+			for (auto& [iob, result] : completed) {
+				if (ctx.ioTimeout > 0) {
+					ctx.removeFromRequestList(iob);
+				}
+
+				switch (iob->opcode) {
+				case IORING_OP_READ:
+					getMetrics().readLatencySample.addMeasurement(currentTime - iob->startTime);
+					break;
+				case IORING_OP_WRITE:
+					getMetrics().writeLatencySample.addMeasurement(currentTime - iob->startTime);
+					break;
+				}
+
+				iob->setResult(result);
+			}
+		}
+	}
+};
+
+TEST_CASE("/fdbrpc/AsyncFileIOUring/SyncPendingWrites") {
+	// This test does nothing in simulation, or unless the process uses AsyncFileIOUring
+	if (!g_network->isSimulated() && AsyncFileIOUring::isInitialized()) {
+		state Reference<IAsyncFile> f;
+		state uint8_t* buf = (uint8_t*)aligned_alloc(4096, 4 * 4096);
+		state uint8_t* readBuf = (uint8_t*)aligned_alloc(4096, 4096);
+		try {
+			Reference<IAsyncFile> f_ = wait(AsyncFileIOUring::open(
+			    "/tmp/__IOURING_TEST_FILE__",
+			    IAsyncFile::OPEN_UNBUFFERED | IAsyncFile::OPEN_READWRITE | IAsyncFile::OPEN_CREATE,
+			    0666,
+			    nullptr));
+			f = f_;
+			ASSERT(f->syncCoversPendingWrites());
+
+			state int iteration = 0;
+			for (; iteration < 100; iteration++) {
+				state int writes = deterministicRandom()->randomInt(1, 4);
+				state std::vector<Future<Void>> futures;
+				state int i = 0;
+				for (i = 0; i < writes; i++) {
+					memset(buf + i * 4096, iteration * 4 + i, 4096);
+					futures.push_back(f->write(buf + i * 4096, 4096, (iteration * 4 + i) * 4096));
+				}
+				// Not waiting for the writes, which a linked or waiting sync covers
+				wait(f->sync());
+				wait(waitForAll(futures));
+				for (i = 0; i < writes; i++) {
+					int length = wait(f->read(readBuf, 4096, (iteration * 4 + i) * 4096));
+					ASSERT_EQ(length, 4096);
+					ASSERT_EQ(readBuf[0], uint8_t(iteration * 4 + i));
+				}
+			}
+		} catch (Error& e) {
+			state Error err = e;
+			free(buf);
+			free(readBuf);
+			if (f) {
+				wait(AsyncFileEIO::deleteFile(f->getFilename(), true));
+			}
+			throw err;
+		}
+
+		free(buf);
+		free(readBuf);
+		wait(AsyncFileEIO::deleteFile(f->getFilename(), true));
+	}
+
+	return Void();
+}
+
+AsyncFileIOUring::Context AsyncFileIOUring::ctx;
+
+#include "flow/unactorcompiler.h"
+#endif
+#endif
+#endif
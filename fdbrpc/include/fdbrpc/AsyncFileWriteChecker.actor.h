@@ -92,6 +92,8 @@ public:
 		});
 	}
 
+	bool syncCoversPendingWrites() const override { return m_f->syncCoversPendingWrites(); }
+
 	Future<Void> flush() override { return m_f->flush(); }
 	Future<int64_t> size() const override { return m_f->size(); }
 	std::string getFilename() const override { return m_f->getFilename(); }
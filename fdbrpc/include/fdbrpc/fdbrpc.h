@@ -606,6 +606,13 @@ public:
 	// client
 	void setByteLimit(int64_t byteLimit) const { queue->acknowledgements.bytesLimit = byteLimit; }
 
+	// The number of bytes that can still be sent before the byte limit is reached, which is negative if the
+	// unacknowledged replies already exceed it
+	int64_t availableBytes() const {
+		return queue->acknowledgements.bytesLimit -
+		       (queue->acknowledgements.bytesSent - queue->acknowledgements.bytesAcknowledged);
+	}
+
 	void operator=(const ReplyPromiseStream& rhs) {
 		rhs.queue->addPromiseRef();
 		if (queue)
@@ -935,6 +942,9 @@ public:
 		queue->makeWellKnownEndpoint(Endpoint::Token(-1, wlTokenID), taskID);
 	}
 
+	// True if requests are serialized to be sent, rather than handed to a stream of this process as they are
+	bool isRemoteEndpoint() const { return queue->isRemoteEndpoint(); }
+
 	bool operator==(const RequestStream<T, IsPublic>& rhs) const { return queue == rhs.queue; }
 	bool operator!=(const RequestStream<T, IsPublic>& rhs) const { return !(*this == rhs); }
 	bool isEmpty() const { return !queue->isReady(); }
@@ -61,8 +61,11 @@
 #include "flow/EncryptUtils.h"
 #include "flow/Error.h"
 #include "flow/IRandom.h"
+#include "flow/IThreadPool.h"
 #include "flow/Knobs.h"
+#include "flow/ThreadPrimitives.h"
 #include "flow/Trace.h"
+#include "flow/UnitTest.h"
 #include "flow/network.h"
 
 #include "flow/actorcompiler.h" // This must be the last #include.
@@ -292,7 +295,7 @@ ACTOR Future<Void> commitBatcher(ProxyCommitData* commitData,
 		}
 
 		while (!timeout.isReady() &&
-		       !(batch.size() == SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX || batchBytes >= desiredBytes)) {
+		       !(batch.size() >= commitData->commitBatchCountLimit || batchBytes >= desiredBytes)) {
 			choose {
 				when(CommitTransactionRequest req = waitNext(in)) {
 					// WARNING: this code is run at a high priority, so it needs to do as little work as possible
@@ -583,6 +586,12 @@ struct CommitBatchContext {
 	int transactionNum = 0;
 	int yieldBytes = 0;
 
+	// The keyInfo shards containing param1 of the mutations assigned to storage servers, at
+	// mutationShardOffsets[transactionNum] + mutationNum. Only filled in when looked up in parallel.
+	std::vector<KeyRef> mutationKeys;
+	std::vector<KeyRangeMap<ServerCacheInfo>::iterator> mutationShards;
+	std::vector<int> mutationShardOffsets;
+
 	LogSystemDiskQueueAdapter::CommitMessage msg;
 
 	Future<Version> loggingComplete;
@@ -605,6 +614,11 @@ struct CommitBatchContext {
 
 	bool rangeLockEnabled();
 
+	// True if the mutations of the transaction are to be sent to storage servers
+	bool shouldAssignMutations(int transactionNum) const;
+
+	KeyRangeMap<ServerCacheInfo>::iterator shardContaining(int transactionNum, int mutationNum, const KeyRef& key);
+
 	Version lastShardMove;
 
 private:
@@ -615,6 +629,23 @@ bool CommitBatchContext::rangeLockEnabled() {
 	return pProxyCommitData->rangeLockEnabled();
 }
 
+bool CommitBatchContext::shouldAssignMutations(int transactionNum) const {
+	return committed[transactionNum] == ConflictBatch::TransactionCommitted &&
+	       (!locked || trs[transactionNum].isLockAware());
+}
+
+KeyRangeMap<ServerCacheInfo>::iterator CommitBatchContext::shardContaining(int transactionNum,
+                                                                           int mutationNum,
+                                                                           const KeyRef& key) {
+	if (!mutationShards.empty()) {
+		return mutationShards[mutationShardOffsets[transactionNum] + mutationNum];
+	}
+	if (SERVER_KNOBS->PROXY_KEY_INFO_INDEX) {
+		return pProxyCommitData->keyInfoIndex.rangeContaining(key);
+	}
+	return pProxyCommitData->keyInfo.rangeContaining(key);
+}
+
 void CommitBatchContext::checkHotShards() {
 	// removed expired hot shards
 	for (auto it = pProxyCommitData->hotShards.begin(); it != pProxyCommitData->hotShards.end();) {
@@ -1222,8 +1253,16 @@ ACTOR Future<Void> applyMetadataToCommittedTransactions(CommitBatchContext* self
 	return Void();
 }
 
-WriteMutationRefVar writeMutation(CommitBatchContext* self, const MutationRef* mutation) {
-	self->toCommit.writeTypedMessage(*mutation);
+// valueArena, if given, holds the value of the mutation as long as the commit batch, so that large values can be sent
+// to the TLogs without copying them into the messages first, see PROXY_REFERENCE_VALUES_MIN_BYTES
+WriteMutationRefVar writeMutation(CommitBatchContext* self,
+                                  const MutationRef* mutation,
+                                  const Arena* valueArena = nullptr) {
+	if (valueArena) {
+		self->toCommit.writeMutation(*mutation, *valueArena, SERVER_KNOBS->PROXY_REFERENCE_VALUES_MIN_BYTES);
+	} else {
+		self->toCommit.writeTypedMessage(*mutation);
+	}
 	return std::variant<MutationRef, VectorRef<MutationRef>>{ *mutation };
 }
 
@@ -1324,15 +1363,102 @@ void rejectMutationsForReadLockOnRange(CommitBatchContext* self) {
 	}
 }
 
+// A slice of CommitBatchContext::mutationKeys whose shards are looked up on one thread
+struct ShardLookupChunk {
+	int begin = 0;
+	int end = 0;
+	Event done;
+};
+
+void lookupShards(CommitBatchContext* self, ShardLookupChunk* chunk) {
+	if (SERVER_KNOBS->PROXY_KEY_INFO_INDEX) {
+		const auto& keyInfoIndex = self->pProxyCommitData->keyInfoIndex;
+		for (int i = chunk->begin; i < chunk->end; i++) {
+			self->mutationShards[i] = keyInfoIndex.rangeContaining(self->mutationKeys[i]);
+		}
+	} else {
+		auto& keyInfo = self->pProxyCommitData->keyInfo;
+		for (int i = chunk->begin; i < chunk->end; i++) {
+			self->mutationShards[i] = keyInfo.rangeContaining(self->mutationKeys[i]);
+		}
+	}
+	chunk->done.set();
+}
+
+struct ShardLookupThread final : IThreadPoolReceiver {
+	void init() override {}
+
+	struct LookupAction final : TypedAction<ShardLookupThread, LookupAction> {
+		CommitBatchContext* self;
+		ShardLookupChunk* chunk;
+		LookupAction(CommitBatchContext* self, ShardLookupChunk* chunk) : self(self), chunk(chunk) {}
+		double getTimeEstimate() const override { return 0; }
+	};
+	void action(LookupAction& a) { lookupShards(a.self, a.chunk); }
+};
+
+// Looks up the keyInfo shards of all mutations to be assigned to storage servers in parallel, ahead of
+// assignMutationsToStorageServers(). Each slice only reads keyInfo, which does not change until the batch is done
+// with it, and writes its own part of mutationShards, so the assignment that follows is the same as if it had done
+// the lookups itself.
+void lookupMutationShards(CommitBatchContext* self) {
+	ProxyCommitData* const pProxyCommitData = self->pProxyCommitData;
+	if (pProxyCommitData->shardLookupParallelism <= 1) {
+		return;
+	}
+
+	self->mutationShardOffsets.assign(self->trs.size(), -1);
+	for (int t = 0; t < self->trs.size(); t++) {
+		if (!self->shouldAssignMutations(t)) {
+			continue;
+		}
+		self->mutationShardOffsets[t] = self->mutationKeys.size();
+		for (const auto& m : self->trs[t].transaction.mutations) {
+			self->mutationKeys.push_back(m.param1);
+		}
+	}
+
+	const int count = self->mutationKeys.size();
+	const int chunkCount = std::min<int>(pProxyCommitData->shardLookupParallelism,
+	                                     count / std::max(SERVER_KNOBS->PROXY_SHARD_LOOKUP_MIN_MUTATIONS, 1));
+	if (chunkCount <= 1) {
+		self->mutationKeys.clear();
+		return;
+	}
+
+	self->mutationShards.resize(count);
+	std::vector<ShardLookupChunk> chunks(chunkCount);
+	for (int c = 0; c < chunkCount; c++) {
+		chunks[c].begin = int64_t(count) * c / chunkCount;
+		chunks[c].end = int64_t(count) * (c + 1) / chunkCount;
+	}
+	for (int c = 1; c < chunkCount; c++) {
+		if (pProxyCommitData->shardLookupThreads) {
+			pProxyCommitData->shardLookupThreads->post(new ShardLookupThread::LookupAction(self, &chunks[c]));
+		} else {
+			lookupShards(self, &chunks[c]);
+		}
+	}
+	lookupShards(self, &chunks[0]);
+	for (auto& chunk : chunks) {
+		chunk.done.block();
+	}
+}
+
 /// This second pass through committed transactions assigns the actual mutations to the appropriate storage servers'
 /// tags
 ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 	state ProxyCommitData* const pProxyCommitData = self->pProxyCommitData;
 	state std::vector<CommitTransactionRequest>& trs = self->trs;
 
+	if (SERVER_KNOBS->PROXY_KEY_INFO_INDEX) {
+		// Catch up with the keyInfo changes of the metadata mutations applied since the last batch
+		pProxyCommitData->keyInfoIndex.update(pProxyCommitData->keyInfo);
+	}
+	lookupMutationShards(self);
+
 	for (; self->transactionNum < trs.size(); self->transactionNum++) {
-		if (!(self->committed[self->transactionNum] == ConflictBatch::TransactionCommitted &&
-		      (!self->locked || trs[self->transactionNum].isLockAware()))) {
+		if (!self->shouldAssignMutations(self->transactionNum)) {
 			continue;
 		}
 
@@ -1363,7 +1489,9 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 			// Determine the set of tags (responsible storage servers) for the mutation, splitting it
 			// if necessary.  Serialize (splits of) the mutation into the message buffer and add the tags.
 			if (isSingleKeyMutation((MutationRef::Type)m.type)) {
-				auto& tags = pProxyCommitData->tagsForKey(m.param1);
+				auto shard = self->shardContaining(self->transactionNum, mutationNum, m.param1);
+				shard.value().populateTags();
+				auto& tags = shard.value().tags;
 
 				// sample single key mutation based on cost
 				// the expectation of sampling is every COMMIT_SAMPLE_COST sample once
@@ -1375,7 +1503,7 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 					double prob = mul * cost / totalCosts;
 
 					if (deterministicRandom()->random01() < prob) {
-						const auto& storageServers = pProxyCommitData->keyInfo[m.param1].src_info;
+						const auto& storageServers = shard.value().src_info;
 						for (const auto& ssInfo : storageServers) {
 							auto id = ssInfo->interf.id();
 							// scale cost
@@ -1400,12 +1528,12 @@ ACTOR Future<Void> assignMutationsToStorageServers(CommitBatchContext* self) {
 					    pProxyCommitData->dbgid);
 				}
 
-				WriteMutationRefVar var = writeMutation(self, &m);
+				WriteMutationRefVar var = writeMutation(self, &m, &trs[self->transactionNum].arena);
 				// FIXME: Remove assert once ClearRange RAW_ACCESS usecase handling is done
 				ASSERT(std::holds_alternative<MutationRef>(var));
 				writtenMutation = std::get<MutationRef>(var);
 			} else if (m.type == MutationRef::ClearRange) {
-				auto range = pProxyCommitData->keyInfo.rangeContaining(m.param1);
+				auto range = self->shardContaining(self->transactionNum, mutationNum, m.param1);
 				if (range.end() >= m.param2) {
 					// Fast path
 					DEBUG_MUTATION("ProxyCommit", self->commitVersion, m, pProxyCommitData->dbgid)
@@ -2022,14 +2150,27 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 	}
 
 	// Dynamic batching for commits
-	double target_latency =
-	    (now() - self->startTime) * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION;
-	pProxyCommitData->commitBatchInterval =
-	    std::max(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
-	             std::min(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX,
-	                      target_latency * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA +
-	                          pProxyCommitData->commitBatchInterval *
-	                              (1 - SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA)));
+	CommitBatchController& controller = pProxyCommitData->commitBatchController;
+	if (controller.enabled()) {
+		if (controller.addBatch(now() - self->startTime)) {
+			pProxyCommitData->commitBatchInterval = controller.getInterval();
+			pProxyCommitData->commitBatchCountLimit = controller.getCountLimit();
+			TraceEvent("CommitBatchControllerUpdate", pProxyCommitData->dbgid)
+			    .suppressFor(1.0)
+			    .detail("P99Latency", controller.getLastP99())
+			    .detail("Interval", controller.getInterval())
+			    .detail("CountLimit", controller.getCountLimit());
+		}
+	} else {
+		double target_latency =
+		    (now() - self->startTime) * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_LATENCY_FRACTION;
+		pProxyCommitData->commitBatchInterval =
+		    std::max(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
+		             std::min(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX,
+		                      target_latency * SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA +
+		                          pProxyCommitData->commitBatchInterval *
+		                              (1 - SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_SMOOTHER_ALPHA)));
+	}
 	pProxyCommitData->stats.commitBatchingWindowSize.addMeasurement(pProxyCommitData->commitBatchInterval);
 	pProxyCommitData->commitBatchesMemBytesCount -= self->currentBatchMemBytesCount;
 	ASSERT_ABORT(pProxyCommitData->commitBatchesMemBytesCount >= 0);
@@ -2038,6 +2179,13 @@ ACTOR Future<Void> reply(CommitBatchContext* self) {
 	return Void();
 }
 
+// Records the time since stageStart in dist, and returns the current time as the start of the next stage
+static double sampleStage(const Reference<Histogram>& dist, double stageStart) {
+	double t = g_network->timer_monotonic();
+	dist->sampleSeconds(t - stageStart);
+	return t;
+}
+
 // Commit one batch of transactions trs
 ACTOR Future<Void> commitBatchImpl(CommitBatchContext* pContext) {
 	// WARNING: this code is run at a high priority (until the first delay(0)), so it needs to do as little work as
@@ -2057,29 +2205,36 @@ ACTOR Future<Void> commitBatchImpl(CommitBatchContext* pContext) {
 	/////// Phase 1: Pre-resolution processing (CPU bound except waiting for a version # which is separately pipelined
 	/// and *should* be available by now (unless empty commit); ordered; currently atomic but could yield)
 	pContext->stage = PRE_RESOLUTION;
+	state ProxyStats* stats = &pContext->pProxyCommitData->stats;
+	state double stageStart = g_network->timer_monotonic();
 	wait(CommitBatch::preresolutionProcessing(pContext));
 	if (pContext->rejected) {
 		pContext->pProxyCommitData->commitBatchesMemBytesCount -= pContext->currentBatchMemBytesCount;
 		return Void();
 	}
+	stageStart = sampleStage(stats->preResolutionStageDist, stageStart);
 
 	/////// Phase 2: Resolution (waiting on the network; pipelined)
 	pContext->stage = RESOLUTION;
 	wait(CommitBatch::getResolution(pContext));
+	stageStart = sampleStage(stats->resolutionStageDist, stageStart);
 
 	////// Phase 3: Post-resolution processing (CPU bound except for very rare situations; ordered; currently atomic but
 	/// doesn't need to be)
 	pContext->stage = POST_RESOLUTION;
 	wait(CommitBatch::postResolution(pContext));
+	stageStart = sampleStage(stats->postResolutionStageDist, stageStart);
 
 	/////// Phase 4: Logging (network bound; pipelined up to MAX_READ_TRANSACTION_LIFE_VERSIONS (limited by loop above))
 	pContext->stage = TRANSACTION_LOGGING;
 	wait(CommitBatch::transactionLogging(pContext));
+	stageStart = sampleStage(stats->transactionLoggingStageDist, stageStart);
 
 	/////// Phase 5: Replies (CPU bound; no particular order required, though ordered execution would be best for
 	/// latency)
 	pContext->stage = REPLY;
 	wait(CommitBatch::reply(pContext));
+	sampleStage(stats->replyStageDist, stageStart);
 
 	pContext->stage = COMPLETE;
 	return Void();
@@ -2700,6 +2855,7 @@ ACTOR Future<Void> processCompleteTransactionStateRequest(TransactionStateResolv
 		// insert keyTag data separately from metadata mutations so that we can do one bulk insert which
 		// avoids a lot of map lookups.
 		pContext->pCommitData->keyInfo.rawInsert(keyInfoData);
+		pContext->pCommitData->keyInfoIndex.invalidateAll();
 
 		Arena arena;
 		bool confChanges;
@@ -2909,6 +3065,15 @@ ACTOR Future<Void> commitProxyServerCore(CommitProxyInterface proxy,
 	}
 	TraceEvent(SevInfo, "CommitBatchesMemoryLimit").detail("BytesLimit", commitBatchesMemoryLimit);
 
+	commitData.shardLookupParallelism = std::max(SERVER_KNOBS->PROXY_SHARD_LOOKUP_THREADS, 1);
+	// In simulation the slices are looked up one after another on the network thread
+	if (commitData.shardLookupParallelism > 1 && !g_network->isSimulated()) {
+		commitData.shardLookupThreads = createGenericThreadPool();
+		for (int i = 1; i < commitData.shardLookupParallelism; i++) {
+			commitData.shardLookupThreads->addThread(new CommitBatch::ShardLookupThread, "fdb-proxy-shards");
+		}
+	}
+
 	// Initialize RangeLock
 	if (commitData.rangeLockEnabled()) {
 		commitData.rangeLock = std::make_shared<RangeLock>(&commitData);
@@ -3092,4 +3257,23 @@ ACTOR Future<Void> commitProxyServer(CommitProxyInterface proxy,
 	return Void();
 }
 
+TEST_CASE("/CommitProxy/CommitBatchController/ConvergesToTarget") {
+	// A pipeline that always takes 3ms should end up batching for the remaining 7ms of a 10ms target
+	CommitBatchController controller(0.010);
+	for (int i = 0; i < 100 * SERVER_KNOBS->COMMIT_BATCH_CONTROLLER_WINDOW; i++) {
+		controller.addBatch(0.003);
+	}
+	ASSERT(std::abs(controller.getInterval() - std::clamp(0.007,
+	                                                      SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
+	                                                      SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX)) < 0.0005);
+
+	// A pipeline slower than the target should shrink batches down to their floor
+	for (int i = 0; i < 100 * SERVER_KNOBS->COMMIT_BATCH_CONTROLLER_WINDOW; i++) {
+		controller.addBatch(0.050);
+	}
+	ASSERT(controller.getInterval() == SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN);
+	ASSERT(controller.getCountLimit() == CommitBatchController::minCountLimit());
+	return Void();
+}
+
 void forceLinkCommitProxyTests() {}
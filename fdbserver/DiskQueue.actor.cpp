@@ -25,6 +25,11 @@
 #include "crc32/crc32c.h"
 #include "flow/genericactors.actor.h"
 #include "flow/xxhash.h"
+#include "flow/UnitTest.h"
+
+#ifdef __linux__
+#include <sys/mman.h>
+#endif
 
 #include "flow/actorcompiler.h" // This must be the last #include.
 
@@ -45,20 +50,93 @@ int64_t pageFloor(int64_t loc) {
 	return loc / _PAGE_SIZE * _PAGE_SIZE;
 }
 
-struct StringBuffer {
+// Page aligned buffers for the pages pushed by a DiskQueue, which are written to the queue files without being copied.
+// Up to maxBytes of released buffers are kept for the following commits, so that the commit path does not allocate,
+// fault in and free its pages every time.
+struct PageBufferPool : ReferenceCounted<PageBufferPool>, NonCopyable {
+	static constexpr int64_t hugePageSize = 2 << 20;
+
+	struct Buffer {
+		uint8_t* data = nullptr;
+		int64_t capacity = 0;
+	};
+
+	PageBufferPool(int64_t maxBytes, bool hugePages) : maxBytes(maxBytes), hugePages(hugePages) {}
+	~PageBufferPool() {
+		for (const auto& b : buffers) {
+			aligned_free(b.data);
+		}
+	}
+
+	int64_t getIdleBytes() const { return idleBytes; }
+
+	// Returns a buffer of at least size bytes: the largest released one if it is large enough, otherwise a new one
+	Buffer acquire(int64_t size) {
+		if (!buffers.empty() && buffers.back().capacity >= size) {
+			Buffer b = buffers.back();
+			buffers.pop_back();
+			idleBytes -= b.capacity;
+			return b;
+		}
+
+		Buffer b;
+		const int64_t alignment = hugePages && size >= hugePageSize ? hugePageSize : _PAGE_SIZE;
+		b.capacity = (size + alignment - 1) / alignment * alignment;
+		b.data = (uint8_t*)aligned_alloc(alignment, b.capacity);
+		if (!b.data) {
+			platform::outOfMemory();
+		}
+#ifdef __linux__
+		if (alignment == hugePageSize) {
+			madvise(b.data, b.capacity, MADV_HUGEPAGE);
+		}
+#endif
+		// Fault the pages in now instead of while the buffer is filled
+		for (int64_t i = 0; i < b.capacity; i += _PAGE_SIZE) {
+			b.data[i] = 0;
+		}
+		return b;
+	}
+
+	void release(Buffer b) {
+		if (idleBytes + b.capacity > maxBytes) {
+			aligned_free(b.data);
+			return;
+		}
+		auto it = std::upper_bound(buffers.begin(), buffers.end(), b.capacity, [](int64_t c, const Buffer& r) {
+			return c < r.capacity;
+		});
+		buffers.insert(it, b);
+		idleBytes += b.capacity;
+	}
+
+private:
+	const int64_t maxBytes;
+	const bool hugePages;
+	int64_t idleBytes = 0;
+	std::vector<Buffer> buffers; // Released buffers, by capacity
+};
+
+struct StringBuffer : NonCopyable {
 	Standalone<StringRef> str;
 	int reserved;
 	UID id;
+	Reference<PageBufferPool> pool; // If set, alignReserve() takes the memory of str from pool instead of its arena
+	PageBufferPool::Buffer pooled;
 
-	StringBuffer(UID fromFileID) : reserved(0), id(fromFileID) {}
+	StringBuffer(UID fromFileID, Reference<PageBufferPool> pool = Reference<PageBufferPool>())
+	  : reserved(0), id(fromFileID), pool(pool) {}
+	~StringBuffer() { releasePooled(); }
 
 	int size() const { return str.size(); }
 	Standalone<StringRef> get() { return str; }
 	void clear() {
+		releasePooled();
 		str = Standalone<StringRef>();
 		reserved = 0;
 	}
 	void clearReserve(int size) {
+		ASSERT(!pool);
 		str = Standalone<StringRef>();
 		reserved = size;
 		str.contents() = StringRef(new (str.arena()) uint8_t[size], 0);
@@ -89,6 +167,18 @@ struct StringBuffer {
 				    .detail("Reserved", reserved)
 				    .backtrace();
 			}
+			if (pool) {
+				ASSERT(_PAGE_SIZE % alignment == 0);
+				PageBufferPool::Buffer b = pool->acquire(reserved);
+				if (str.size() > 0) {
+					memcpy(b.data, str.begin(), str.size());
+				}
+				releasePooled();
+				pooled = b;
+				reserved = b.capacity;
+				str.contents() = StringRef(b.data, str.size());
+				return;
+			}
 			uint8_t* b = new (str.arena()) uint8_t[reserved + alignment - 1];
 			uint8_t* e = b + (reserved + alignment - 1);
 
@@ -102,6 +192,14 @@ struct StringBuffer {
 			str.contents() = StringRef(p, str.size());
 		}
 	}
+
+private:
+	void releasePooled() {
+		if (pooled.data) {
+			pool->release(pooled);
+			pooled = PageBufferPool::Buffer();
+		}
+	}
 };
 
 struct SyncQueue : ReferenceCounted<SyncQueue> {
@@ -116,6 +214,9 @@ struct SyncQueue : ReferenceCounted<SyncQueue> {
 		return outstanding.back();
 	}
 
+	// If true, onSync() also covers the writes issued but not completed before the call
+	bool syncCoversPendingWrites() const { return file->syncCoversPendingWrites(); }
+
 private:
 	int outstandingLimit;
 	Deque<Future<Void>> outstanding;
@@ -432,6 +533,13 @@ public:
 		return waitForAllReadyThenThrow(waitfor);
 	}
 
+	static Future<Void> onSync(const std::vector<Reference<SyncQueue>>& syncFiles) {
+		Future<Void> sync = syncFiles[0]->onSync();
+		for (int i = 1; i < syncFiles.size(); i++)
+			sync = sync && syncFiles[i]->onSync();
+		return sync;
+	}
+
 	// Write the given data (pageData) to the queue files of self, sync data to disk, and delete the memory (pageMem)
 	// that hold the pageData
 	ACTOR static UNCANCELLABLE Future<Void> pushAndCommit(RawDiskQueue_TwoFiles* self,
@@ -466,14 +574,23 @@ public:
 			pushing.send(Void());
 			ASSERT(syncFiles.size() >= 1 && syncFiles.size() <= 2);
 			CODE_PROBE(2 == syncFiles.size(), "push spans both files");
+
+			// If the files can sync the writes before they complete, the syncs are issued with the writes so that e.g.
+			// AsyncFileIOUring can submit them together
+			state Future<Void> sync;
+			if (std::all_of(syncFiles.begin(), syncFiles.end(), [](const Reference<SyncQueue>& syncFile) {
+				    return syncFile->syncCoversPendingWrites();
+			    })) {
+				sync = onSync(syncFiles);
+			}
 			wait(pushed);
 
 			delete pageMem;
 			pageMem = 0;
 
-			Future<Void> sync = syncFiles[0]->onSync();
-			for (int i = 1; i < syncFiles.size(); i++)
-				sync = sync && syncFiles[i]->onSync();
+			if (!sync.isValid()) {
+				sync = onSync(syncFiles);
+			}
 			wait(sync);
 			wait(lastCommit);
 
@@ -886,7 +1003,12 @@ public:
 	  : rawQueue(new RawDiskQueue_TwoFiles(basename, fileExtension, dbgid, fileSizeWarningLimit)), dbgid(dbgid),
 	    diskQueueVersion(diskQueueVersion), anyPopped(false), warnAlwaysForMemory(true), nextPageSeq(0), poppedSeq(0),
 	    lastPoppedSeq(0), lastCommittedSeq(0), pushed_page_buffer(nullptr), recovered(false), initialized(false),
-	    nextReadLocation(-1), readBufPage(nullptr), readBufPos(0) {}
+	    nextReadLocation(-1), readBufPage(nullptr), readBufPos(0) {
+		if (SERVER_KNOBS->DISK_QUEUE_BUFFER_POOL_BYTES > 0) {
+			pageBufferPool = makeReference<PageBufferPool>(SERVER_KNOBS->DISK_QUEUE_BUFFER_POOL_BYTES,
+			                                               SERVER_KNOBS->DISK_QUEUE_BUFFER_POOL_HUGE_PAGES);
+		}
+	}
 
 	location push(StringRef contents) override {
 		ASSERT(recovered);
@@ -1132,7 +1254,7 @@ private:
 
 		// pushed_pages.resize( pushed_pages.arena(), pushed_pages.size()+1 );
 		if (!pushed_page_buffer)
-			pushed_page_buffer = new StringBuffer(dbgid);
+			pushed_page_buffer = new StringBuffer(dbgid, pageBufferPool);
 		pushed_page_buffer->alignReserve(sizeof(Page), pushed_page_buffer->size() + sizeof(Page));
 		pushed_page_buffer->append(sizeof(Page));
 
@@ -1541,6 +1663,7 @@ private:
 
 	// Buffer of pushed pages that haven't been committed.  The last one (backPage()) is still mutable.
 	StringBuffer* pushed_page_buffer;
+	Reference<PageBufferPool> pageBufferPool; // Where pushed_page_buffer gets its memory from, if set
 	Page& backPage() {
 		ASSERT(pushedPageCount());
 		return ((Page*)pushed_page_buffer->get().end())[-1];
@@ -1706,3 +1829,35 @@ TEST_CASE("performance/fdbserver/DiskQueue") {
 	wait(queue->onClosed());
 	return Void();
 }
+
+TEST_CASE("/fdbserver/DiskQueue/PageBufferPool") {
+	Reference<PageBufferPool> pool = makeReference<PageBufferPool>(1 << 20, deterministicRandom()->coinflip());
+	StringBuffer* buffer = new StringBuffer(UID(), pool);
+	buffer->alignReserve(_PAGE_SIZE, _PAGE_SIZE);
+	memset(buffer->append(_PAGE_SIZE), 1, _PAGE_SIZE);
+	ASSERT(int64_t(buffer->get().begin()) % _PAGE_SIZE == 0);
+
+	// Growing keeps the contents
+	buffer->alignReserve(_PAGE_SIZE, 100 * _PAGE_SIZE);
+	buffer->append(StringRef(std::string(_PAGE_SIZE, 2)));
+	ASSERT(int64_t(buffer->get().begin()) % _PAGE_SIZE == 0);
+	ASSERT(buffer->get()[0] == 1 && buffer->get()[2 * _PAGE_SIZE - 1] == 2);
+	const uint8_t* data = buffer->get().begin();
+	const int64_t capacity = buffer->reserved;
+	delete buffer;
+	ASSERT_EQ(pool->getIdleBytes(), capacity + _PAGE_SIZE);
+
+	// The next buffer reuses the memory of the last one
+	buffer = new StringBuffer(UID(), pool);
+	buffer->alignReserve(_PAGE_SIZE, _PAGE_SIZE);
+	ASSERT(buffer->get().begin() == data);
+	ASSERT_EQ(pool->getIdleBytes(), _PAGE_SIZE);
+	delete buffer;
+
+	// Buffers over the pool size are freed
+	buffer = new StringBuffer(UID(), pool);
+	buffer->alignReserve(_PAGE_SIZE, 2 << 20);
+	delete buffer;
+	ASSERT_EQ(pool->getIdleBytes(), capacity + _PAGE_SIZE);
+	return Void();
+}
@@ -49,6 +49,8 @@ struct GrvProxyStats {
 	Counter txnStartIn;
 	Counter txnStartOut;
 	Counter txnStartBatch;
+	Counter txnStartBatchCoalesced; // Batches that shared the master round trip of another one
+	Counter txnStartBatchCached; // Batches given a cached version, see GRV_PROXY_CAUSAL_READ_RISKY_MAX_STALENESS
 	Counter txnSystemPriorityStartIn;
 	Counter txnSystemPriorityStartOut;
 	Counter txnBatchPriorityStartIn;
@@ -138,6 +140,7 @@ struct GrvProxyStats {
 
 	    txnRequestIn("TxnRequestIn", cc), txnRequestOut("TxnRequestOut", cc), txnRequestErrors("TxnRequestErrors", cc),
 	    txnStartIn("TxnStartIn", cc), txnStartOut("TxnStartOut", cc), txnStartBatch("TxnStartBatch", cc),
+	    txnStartBatchCoalesced("TxnStartBatchCoalesced", cc), txnStartBatchCached("TxnStartBatchCached", cc),
 	    txnSystemPriorityStartIn("TxnSystemPriorityStartIn", cc),
 	    txnSystemPriorityStartOut("TxnSystemPriorityStartOut", cc),
 	    txnBatchPriorityStartIn("TxnBatchPriorityStartIn", cc),
@@ -225,6 +228,21 @@ struct GrvProxyData {
 	// Cache of the latest commit versions of storage servers.
 	VersionVector ssVersionVectorCache;
 
+	// Incremented for every batch of GRV requests transactionStarter() starts
+	int64_t startBatchNumber;
+	// The GetRawCommittedVersionRequests outstanding at the master when they are coalesced, see
+	// getRawCommittedVersion(), and a trigger for each that returns
+	int outstandingRawCommittedVersionRequests;
+	AsyncTrigger rawCommittedVersionReturned;
+	// The master round trip that batches may share, and the batch number when its request was sent, or -1 while it is
+	// waiting for an outstanding one to return
+	Future<GetRawCommittedVersionReply> sharedRawCommittedVersion;
+	int64_t sharedRawCommittedVersionBatch;
+
+	// The reply of the master with the highest version, and when its request was sent
+	GetRawCommittedVersionReply cachedRawCommittedVersion;
+	double cachedRawCommittedVersionTime;
+
 	void updateLatencyBandConfig(Optional<LatencyBandConfig> newLatencyBandConfig) {
 		if (newLatencyBandConfig.present() != latencyBandConfig.present() ||
 		    (newLatencyBandConfig.present() &&
@@ -250,7 +268,9 @@ struct GrvProxyData {
 	    cx(openDBOnServer(db, TaskPriority::DefaultEndpoint, LockAware::True)), db(db), lastStartCommit(0),
 	    lastCommitLatency(SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION), updateCommitRequests(0), lastCommitTime(0),
 	    version(0), minKnownCommittedVersion(invalidVersion),
-	    tagThrottler(CLIENT_KNOBS->PROXY_MAX_TAG_THROTTLE_DURATION) {
+	    tagThrottler(CLIENT_KNOBS->PROXY_MAX_TAG_THROTTLE_DURATION), startBatchNumber(0),
+	    outstandingRawCommittedVersionRequests(0),
+	    sharedRawCommittedVersionBatch(-1), cachedRawCommittedVersionTime(0) {
 		if (SERVER_KNOBS->ENABLE_VERSION_VECTOR) {
 			versionVectorSizeOnGRVReply =
 			    std::make_unique<LatencySample>("VersionVectorSizeOnGRVReply",
@@ -576,18 +596,18 @@ ACTOR Future<Void> queueGetReadVersionRequests(Reference<AsyncVar<ServerDBInfo>
 					stats->txnStartIn += req.transactionCount;
 					stats->txnSystemPriorityStartIn += req.transactionCount;
 					++stats->systemGRVQueueSize;
-					systemQueue->push_back(req);
+					systemQueue->push_back(std::move(req));
 				} else if (req.priority >= TransactionPriority::DEFAULT) {
 					if (SERVER_KNOBS->ENFORCE_TAG_THROTTLING_ON_PROXIES && req.isTagged()) {
 						++stats->tagThrottlerGRVQueueSize;
 						stats->txnTagThrottlerIn += req.transactionCount;
-						tagThrottler->addRequest(req);
+						tagThrottler->addRequest(std::move(req));
 					} else {
 						++stats->txnRequestIn;
 						stats->txnStartIn += req.transactionCount;
 						stats->txnDefaultPriorityStartIn += req.transactionCount;
 						++stats->defaultGRVQueueSize;
-						defaultQueue->push_back(req);
+						defaultQueue->push_back(std::move(req));
 					}
 				} else {
 					// Return error for batch_priority GRV requests
@@ -599,13 +619,13 @@ ACTOR Future<Void> queueGetReadVersionRequests(Reference<AsyncVar<ServerDBInfo>
 						if (SERVER_KNOBS->ENFORCE_TAG_THROTTLING_ON_PROXIES && req.isTagged()) {
 							++stats->tagThrottlerGRVQueueSize;
 							stats->txnTagThrottlerIn += req.transactionCount;
-							tagThrottler->addRequest(req);
+							tagThrottler->addRequest(std::move(req));
 						} else {
 							++stats->txnRequestIn;
 							stats->txnStartIn += req.transactionCount;
 							stats->txnBatchPriorityStartIn += req.transactionCount;
 							++stats->batchGRVQueueSize;
-							batchQueue->push_back(req);
+							batchQueue->push_back(std::move(req));
 						}
 					}
 				}
@@ -654,6 +674,70 @@ ACTOR Future<Void> lastCommitUpdater(GrvProxyData* self, PromiseStream<Future<Vo
 	}
 }
 
+ACTOR Future<GetRawCommittedVersionReply> sendRawCommittedVersionRequest(GrvProxyData* self,
+                                                                        SpanContext spanContext,
+                                                                        Optional<UID> debugID) {
+	while (self->outstandingRawCommittedVersionRequests >= SERVER_KNOBS->GRV_PROXY_MAX_OUTSTANDING_MASTER_REQUESTS) {
+		wait(self->rawCommittedVersionReturned.onTrigger());
+	}
+
+	++self->outstandingRawCommittedVersionRequests;
+	self->sharedRawCommittedVersionBatch = self->startBatchNumber;
+	try {
+		GetRawCommittedVersionReply reply = wait(self->master.getLiveCommittedVersion.getReply(
+		    GetRawCommittedVersionRequest(spanContext, debugID, self->ssVersionVectorCache.getMaxVersion()),
+		    TaskPriority::GetLiveCommittedVersionReply));
+		--self->outstandingRawCommittedVersionRequests;
+		self->rawCommittedVersionReturned.trigger();
+		return reply;
+	} catch (Error& e) {
+		--self->outstandingRawCommittedVersionRequests;
+		if (e.code() != error_code_actor_cancelled) {
+			self->rawCommittedVersionReturned.trigger();
+		}
+		throw;
+	}
+}
+
+// Returns the reply of a GetRawCommittedVersionRequest sent to the master after all the requests of the current batch
+// were received. With GRV_PROXY_COALESCE_MASTER_REQUESTS, batches share one whenever that holds for all of them: the
+// batches of causal and CAUSAL_READ_RISKY requests started together, and the batches started while the request is
+// waiting for one of the GRV_PROXY_MAX_OUTSTANDING_MASTER_REQUESTS to return.
+Future<GetRawCommittedVersionReply> getRawCommittedVersion(GrvProxyData* self,
+                                                           SpanContext spanContext,
+                                                           Optional<UID> debugID) {
+	if (!SERVER_KNOBS->GRV_PROXY_COALESCE_MASTER_REQUESTS) {
+		return self->master.getLiveCommittedVersion.getReply(
+		    GetRawCommittedVersionRequest(spanContext, debugID, self->ssVersionVectorCache.getMaxVersion()),
+		    TaskPriority::GetLiveCommittedVersionReply);
+	}
+
+	if (self->sharedRawCommittedVersion.isValid() && !self->sharedRawCommittedVersion.isReady() &&
+	    (self->sharedRawCommittedVersionBatch == -1 ||
+	     self->sharedRawCommittedVersionBatch == self->startBatchNumber)) {
+		++self->stats.txnStartBatchCoalesced;
+		return self->sharedRawCommittedVersion;
+	}
+	self->sharedRawCommittedVersionBatch = -1;
+	self->sharedRawCommittedVersion = sendRawCommittedVersionRequest(self, spanContext, debugID);
+	return self->sharedRawCommittedVersion;
+}
+
+// Whether a batch of GRV requests with the given flags may be given cachedRawCommittedVersion instead of a live version
+bool canUseCachedRawCommittedVersion(GrvProxyData* self, uint32_t flags) {
+	if (SERVER_KNOBS->GRV_PROXY_CAUSAL_READ_RISKY_MAX_STALENESS <= 0 ||
+	    (!SERVER_KNOBS->ALWAYS_CAUSAL_READ_RISKY && !(flags & GetReadVersionRequest::FLAG_CAUSAL_READ_RISKY))) {
+		return false;
+	}
+	// Like the CAUSAL_READ_RISKY requests asking the master, only while commits are known to succeed recently
+	if (SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > 0 &&
+	    now() - SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > self->lastCommitTime.get()) {
+		return false;
+	}
+	return self->cachedRawCommittedVersionTime > 0 &&
+	       now() - self->cachedRawCommittedVersionTime <= SERVER_KNOBS->GRV_PROXY_CAUSAL_READ_RISKY_MAX_STALENESS;
+}
+
 ACTOR Future<GetReadVersionReply> getLiveCommittedVersion(std::vector<SpanContext> spanContexts,
                                                           GrvProxyData* grvProxyData,
                                                           uint32_t flags,
@@ -674,35 +758,42 @@ ACTOR Future<GetReadVersionReply> getLiveCommittedVersion(std::vector<SpanContex
 	++grvProxyData->stats.txnStartBatch;
 
 	state double grvStart = now();
-	state Future<GetRawCommittedVersionReply> replyFromMasterFuture;
-	replyFromMasterFuture = grvProxyData->master.getLiveCommittedVersion.getReply(
-	    GetRawCommittedVersionRequest(span.context, debugID, grvProxyData->ssVersionVectorCache.getMaxVersion()),
-	    TaskPriority::GetLiveCommittedVersionReply);
-
-	if (!SERVER_KNOBS->ALWAYS_CAUSAL_READ_RISKY && !(flags & GetReadVersionRequest::FLAG_CAUSAL_READ_RISKY)) {
-		wait(transformError(updateLastCommit(grvProxyData, debugID), broken_promise(), tlog_failed()));
-	} else if (SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > 0 &&
-	           now() - SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > grvProxyData->lastCommitTime.get()) {
-		wait(grvProxyData->lastCommitTime.whenAtLeast(now() - SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION));
-	}
+	state GetRawCommittedVersionReply repFromMaster;
+	if (canUseCachedRawCommittedVersion(grvProxyData, flags)) {
+		++grvProxyData->stats.txnStartBatchCached;
+		repFromMaster = grvProxyData->cachedRawCommittedVersion;
+	} else {
+		state Future<GetRawCommittedVersionReply> replyFromMasterFuture;
+		replyFromMasterFuture = getRawCommittedVersion(grvProxyData, span.context, debugID);
+
+		if (!SERVER_KNOBS->ALWAYS_CAUSAL_READ_RISKY && !(flags & GetReadVersionRequest::FLAG_CAUSAL_READ_RISKY)) {
+			wait(transformError(updateLastCommit(grvProxyData, debugID), broken_promise(), tlog_failed()));
+		} else if (SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > 0 &&
+		           now() - SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION > grvProxyData->lastCommitTime.get()) {
+			wait(grvProxyData->lastCommitTime.whenAtLeast(now() - SERVER_KNOBS->REQUIRED_MIN_RECOVERY_DURATION));
+		}
 
-	state double grvConfirmEpochLive = now();
-	grvProxyData->stats.grvConfirmEpochLiveDist->sampleSeconds(grvConfirmEpochLive - grvStart);
-	if (debugID.present()) {
-		g_traceBatch.addEvent(
-		    "TransactionDebug", debugID.get().first(), "GrvProxyServer.getLiveCommittedVersion.confirmEpochLive");
-	}
+		state double grvConfirmEpochLive = now();
+		grvProxyData->stats.grvConfirmEpochLiveDist->sampleSeconds(grvConfirmEpochLive - grvStart);
+		if (debugID.present()) {
+			g_traceBatch.addEvent(
+			    "TransactionDebug", debugID.get().first(), "GrvProxyServer.getLiveCommittedVersion.confirmEpochLive");
+		}
 
-	GetRawCommittedVersionReply repFromMaster =
-	    wait(transformError(replyFromMasterFuture, broken_promise(), master_failed()));
-	grvProxyData->version = std::max(grvProxyData->version, repFromMaster.version);
-	grvProxyData->minKnownCommittedVersion =
-	    std::max(grvProxyData->minKnownCommittedVersion, repFromMaster.minKnownCommittedVersion);
-	if (SERVER_KNOBS->ENABLE_VERSION_VECTOR) {
-		// TODO add to "status json"
-		grvProxyData->ssVersionVectorCache.applyDelta(repFromMaster.ssVersionVectorDelta);
+		wait(store(repFromMaster, transformError(replyFromMasterFuture, broken_promise(), master_failed())));
+		grvProxyData->version = std::max(grvProxyData->version, repFromMaster.version);
+		grvProxyData->minKnownCommittedVersion =
+		    std::max(grvProxyData->minKnownCommittedVersion, repFromMaster.minKnownCommittedVersion);
+		if (SERVER_KNOBS->ENABLE_VERSION_VECTOR) {
+			// TODO add to "status json"
+			grvProxyData->ssVersionVectorCache.applyDelta(repFromMaster.ssVersionVectorDelta);
+		}
+		if (repFromMaster.version >= grvProxyData->cachedRawCommittedVersion.version) {
+			grvProxyData->cachedRawCommittedVersion = repFromMaster;
+			grvProxyData->cachedRawCommittedVersionTime = grvStart;
+		}
+		grvProxyData->stats.grvGetCommittedVersionRpcDist->sampleSeconds(now() - grvConfirmEpochLive);
 	}
-	grvProxyData->stats.grvGetCommittedVersionRpcDist->sampleSeconds(now() - grvConfirmEpochLive);
 	GetReadVersionReply rep;
 	rep.version = repFromMaster.version;
 	rep.locked = repFromMaster.locked;
@@ -932,6 +1023,7 @@ ACTOR static Future<Void> transactionStarter(GrvProxyInterface proxy,
 
 	loop {
 		waitNext(GRVTimer.getFuture());
+		++grvProxyData->startBatchNumber;
 		// Select zero or more transactions to start
 		double t = now();
 		double elapsed = now() - lastGRVTime;
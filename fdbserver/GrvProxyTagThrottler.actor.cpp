@@ -103,6 +103,10 @@ void GrvProxyTagThrottler::updateRates(TransactionTagMap<double> const& newRates
 }
 
 void GrvProxyTagThrottler::addRequest(GetReadVersionRequest const& req) {
+	addRequest(GetReadVersionRequest(req));
+}
+
+void GrvProxyTagThrottler::addRequest(GetReadVersionRequest&& req) {
 	ASSERT(req.isTagged());
 	auto const& tag = req.tags.begin()->first;
 	if (req.tags.size() > 1) {
@@ -115,7 +119,7 @@ void GrvProxyTagThrottler::addRequest(GetReadVersionRequest const& req) {
 		    .detail("NumTags", req.tags.size())
 		    .detail("UsingTag", tag);
 	}
-	queues[tag].requests.emplace_back(req);
+	queues[tag].requests.emplace_back(std::move(req));
 }
 
 GrvProxyTagThrottler::ReleaseTransactionsResult GrvProxyTagThrottler::releaseTransactions(
@@ -124,114 +128,52 @@ GrvProxyTagThrottler::ReleaseTransactionsResult GrvProxyTagThrottler::releaseTra
     Deque<GetReadVersionRequest>& outDefaultPriority) {
 	ReleaseTransactionsResult result;
 
-	// Pointer to a TagQueue with some extra metadata stored alongside
-	struct TagQueueHandle {
-		// Store pointers here to avoid frequent std::unordered_map lookups
-		TagQueue* queue;
-		// Cannot be stored directly because we need to
-		uint32_t* numReleased;
-		// Sequence number of the first queued request
-		int64_t nextSeqNo;
-		bool operator>(TagQueueHandle const& rhs) const { return nextSeqNo > rhs.nextSeqNo; }
-		explicit TagQueueHandle(TagQueue& queue, uint32_t& numReleased) : queue(&queue), numReleased(&numReleased) {
-			ASSERT(!this->queue->requests.empty());
-			nextSeqNo = this->queue->requests.front().sequenceNumber;
-		}
-	};
-
-	// Priority queue of queues for each tag, ordered by the sequence number of the
-	// next request to process in each queue
-	std::priority_queue<TagQueueHandle, std::vector<TagQueueHandle>, std::greater<TagQueueHandle>> pqOfQueues;
-
-	// Track transactions released for each tag
-	std::vector<std::pair<TransactionTag, uint32_t>> transactionsReleased;
-	transactionsReleased.reserve(queues.size());
-	auto const transactionsReleasedInitialCapacity = transactionsReleased.capacity();
-
 	for (auto& [tag, queue] : queues) {
 		if (queue.rateInfo.present()) {
 			queue.rateInfo.get().startReleaseWindow();
 		}
-		if (!queue.requests.empty()) {
-			// First place the count in the transactionsReleased object,
-			// then pass a reference to the count to the TagQueueHandle object
-			// emplaced into pqOfQueues.
-			//
-			// Because we've reserved enough space in transactionsReleased
-			// to avoid resizing, this reference should remain valid.
-			// This allows each TagQueueHandle to update its number of
-			// numReleased counter without incurring the cost of a std::unordered_map lookup.
-			auto& [_, count] = transactionsReleased.emplace_back(tag, 0);
-			pqOfQueues.emplace(queue, count);
-		}
+		queue.numReleased = 0;
+		merger.add(queue);
 	}
 
-	while (!pqOfQueues.empty()) {
-		auto tagQueueHandle = pqOfQueues.top();
-		pqOfQueues.pop();
-		// Used to determine when it is time to start processing another tag
-		auto const nextQueueSeqNo =
-		    pqOfQueues.empty() ? std::numeric_limits<int64_t>::max() : pqOfQueues.top().nextSeqNo;
-
-		while (!tagQueueHandle.queue->requests.empty()) {
-			auto& delayedReq = tagQueueHandle.queue->requests.front();
-			auto count = delayedReq.req.tags.begin()->second;
-			ASSERT_EQ(tagQueueHandle.nextSeqNo, delayedReq.sequenceNumber);
-			if (tagQueueHandle.queue->rateInfo.present() &&
-			    !tagQueueHandle.queue->rateInfo.get().canStart(*(tagQueueHandle.numReleased), count)) {
-				// Cannot release any more transaction from this tag (don't push the tag queue handle back into
-				// pqOfQueues)
-				CODE_PROBE(true, "GrvProxyTagThrottler throttling transaction");
-				if (tagQueueHandle.queue->isMaxThrottled(maxThrottleDuration)) {
-					// Requests in this queue have been throttled too long and errors
-					// should be sent to clients.
-					result.rejectedRequests += tagQueueHandle.queue->requests.size();
-					tagQueueHandle.queue->rejectRequests(latencyBandsMap);
-				}
-				break;
-			} else {
-				if (tagQueueHandle.nextSeqNo < nextQueueSeqNo) {
-					// Releasing transaction
-					*(tagQueueHandle.numReleased) += count;
-					delayedReq.updateProxyTagThrottledDuration(latencyBandsMap);
-					if (delayedReq.req.priority == TransactionPriority::BATCH) {
-						result.batchPriorityTransactionsReleased += delayedReq.req.transactionCount;
-						++result.batchPriorityRequestsReleased;
-						outBatchPriority.push_back(delayedReq.req);
-					} else if (delayedReq.req.priority == TransactionPriority::DEFAULT) {
-						result.defaultPriorityTransactionsReleased += delayedReq.req.transactionCount;
-						++result.defaultPriorityRequestsReleased;
-						outDefaultPriority.push_back(delayedReq.req);
-					} else {
-						// Immediate priority transactions should bypass the GrvProxyTagThrottler
-						ASSERT(false);
-					}
-					tagQueueHandle.queue->requests.pop_front();
-					if (!tagQueueHandle.queue->requests.empty()) {
-						tagQueueHandle.nextSeqNo = tagQueueHandle.queue->requests.front().sequenceNumber;
-					}
-				} else {
-					CODE_PROBE(true, "GrvProxyTagThrottler switching tags to preserve FIFO");
-					pqOfQueues.push(tagQueueHandle);
-					break;
-				}
+	merger.release([this, &result, &outBatchPriority, &outDefaultPriority](TagQueue& queue) {
+		auto& delayedReq = queue.requests.front();
+		auto count = delayedReq.req.tags.begin()->second;
+		if (queue.rateInfo.present() && !queue.rateInfo.get().canStart(queue.numReleased, count)) {
+			// Cannot release any more transaction from this tag
+			CODE_PROBE(true, "GrvProxyTagThrottler throttling transaction");
+			if (queue.isMaxThrottled(maxThrottleDuration)) {
+				// Requests in this queue have been throttled too long and errors
+				// should be sent to clients.
+				result.rejectedRequests += queue.requests.size();
+				queue.rejectRequests(latencyBandsMap);
 			}
+			return false;
 		}
-	}
 
-	// End release windows for all tag queues
-	{
-		TransactionTagMap<uint32_t> transactionsReleasedMap;
-		for (const auto& [tag, count] : transactionsReleased) {
-			transactionsReleasedMap[tag] = count;
-		}
-		for (auto& [tag, queue] : queues) {
-			queue.endReleaseWindow(transactionsReleasedMap[tag], elapsed);
+		// Releasing transaction
+		queue.numReleased += count;
+		delayedReq.updateProxyTagThrottledDuration(latencyBandsMap);
+		if (delayedReq.req.priority == TransactionPriority::BATCH) {
+			result.batchPriorityTransactionsReleased += delayedReq.req.transactionCount;
+			++result.batchPriorityRequestsReleased;
+			outBatchPriority.push_back(std::move(delayedReq.req));
+		} else if (delayedReq.req.priority == TransactionPriority::DEFAULT) {
+			result.defaultPriorityTransactionsReleased += delayedReq.req.transactionCount;
+			++result.defaultPriorityRequestsReleased;
+			outDefaultPriority.push_back(std::move(delayedReq.req));
+		} else {
+			// Immediate priority transactions should bypass the GrvProxyTagThrottler
+			ASSERT(false);
 		}
+		queue.requests.pop_front();
+		return true;
+	});
+
+	// End release windows for all tag queues
+	for (auto& [tag, queue] : queues) {
+		queue.endReleaseWindow(queue.numReleased, elapsed);
 	}
-	// If the capacity is increased, that means the vector has been illegally resized, potentially
-	// corrupting memory
-	ASSERT_EQ(transactionsReleased.capacity(), transactionsReleasedInitialCapacity);
 
 	return result;
 }
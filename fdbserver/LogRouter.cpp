@@ -20,6 +20,7 @@
 
 #include "fdbrpc/Stats.h"
 #include "fdbserver/Knobs.h"
+#include "fdbserver/LogRouterCache.h"
 #include "fdbserver/LogSystem.h"
 #include "fdbserver/WorkerInterface.actor.h"
 #include "fdbserver/RecoveryState.h"
@@ -92,6 +93,9 @@ struct LogRouterData {
 	int64_t generation = -1;
 	Reference<Histogram> peekLatencyDist;
 	Optional<Version> recoverAt = Optional<Version>();
+	// The recovery version of the old log set LR pulls, or MAX_VERSION if it pulls the current one. Replacement log
+	// routers are only recruited for the current log set.
+	Version epochEnd = MAX_VERSION;
 	Optional<std::map<uint8_t, std::vector<uint16_t>>> knownLockedTLogIds =
 	    Optional<std::map<uint8_t, std::vector<uint16_t>>>();
 
@@ -106,11 +110,16 @@ struct LogRouterData {
 	Counter getMoreCount; // Increase by 1 when LR tries to pull data from satellite tLog.
 	Counter
 	    getMoreBlockedCount; // Increase by 1 if data is not available when LR tries to pull data from satellite tLog.
+	Counter cacheLookups; // Increase by 1 when LR looks for the versions it starts pulling at in the LogRouterCache.
+	Counter cacheHits; // Increase by 1 when LR reads versions from the LogRouterCache instead of from the primary.
+	Counter cacheBytesSaved; // Bytes of messages LR read from the LogRouterCache instead of from the primary.
 	Future<Void> logger;
 	Reference<EventCacheHolder> eventCacheHolder;
 	int activePeekStreams = 0;
 
 	std::vector<Reference<TagData>> tag_data; // we only store data for the remote tag locality
+	LogRouterCache& cache;
+	std::vector<int> pushLocations; // an optimization to avoid reallocating vector memory for every message
 
 	Reference<TagData> getTagData(Tag tag) {
 		ASSERT(tag.locality == tagLocalityRemoteLog);
@@ -133,7 +142,8 @@ struct LogRouterData {
 	    allowPops(false), foundEpochEnd(false), generation(req.recoveryCount),
 	    peekLatencyDist(Histogram::getHistogram("LogRouter"_sr, "PeekTLogLatency"_sr, Histogram::Unit::milliseconds)),
 	    cc("LogRouter", dbgid.toString()), getMoreCount("GetMoreCount", cc),
-	    getMoreBlockedCount("GetMoreBlockedCount", cc) {
+	    getMoreBlockedCount("GetMoreBlockedCount", cc), cacheLookups("CacheLookups", cc), cacheHits("CacheHits", cc),
+	    cacheBytesSaved("CacheBytesSaved", cc), cache(LogRouterCache::get()) {
 		// setup just enough of a logSet to be able to call getPushLocations
 		logSet.logServers.resize(req.tLogLocalities.size());
 		logSet.tLogPolicy = req.tLogPolicy;
@@ -141,6 +151,9 @@ struct LogRouterData {
 		logSet.updateLocalitySet(req.tLogLocalities);
 
 		recoverAt = req.recoverAt;
+		if (recoverAt.present() && startVersion != 0) {
+			epochEnd = recoverAt.get();
+		}
 		knownLockedTLogIds = req.knownLockedTLogIds;
 
 		for (int i = 0; i < req.tLogLocalities.size(); i++) {
@@ -153,6 +166,10 @@ struct LogRouterData {
 
 		eventCacheHolder = makeReference<EventCacheHolder>(dbgid.shortString() + ".PeekLocation");
 
+		if (cache.enabled()) {
+			cache.addReader(generation, epochEnd, routerTag);
+		}
+
 		// FetchedVersions: How many version of mutations buffered at LR and have not been popped by remote tLogs
 		specialCounter(cc, "Version", [this]() { return this->version.get(); });
 		specialCounter(cc, "MinPopped", [this]() { return this->minPopped.get(); });
@@ -187,6 +204,7 @@ struct LogRouterData {
 		});
 		specialCounter(cc, "Generation", [this]() { return this->generation; });
 		specialCounter(cc, "ActivePeekStreams", [this]() { return this->activePeekStreams; });
+		specialCounter(cc, "CacheBytes", [this]() { return this->cache.getBytes(); });
 		logger = cc.traceCounters("LogRouterMetrics",
 		                          dbgid,
 		                          SERVER_KNOBS->WORKER_LOGGING_INTERVAL,
@@ -197,6 +215,12 @@ struct LogRouterData {
 		                          });
 	}
 
+	~LogRouterData() {
+		if (cache.enabled()) {
+			cache.removeReader(generation, epochEnd, routerTag);
+		}
+	}
+
 	std::deque<std::pair<Version, LengthPrefixedStringRef>>& get_version_messages(Tag tag) {
 		auto tagData = getTagData(tag);
 		if (!tagData) {
@@ -213,9 +237,15 @@ struct LogRouterData {
 		return tagData->popped;
 	}
 
+	// Returns the message pushed with tags, tagged with the remote tLogs it is routed to.
+	TagsAndMessage routeMessage(StringRef message, VectorRef<Tag> tags, Arena& arena);
+
 	// Copy pulled messages into memory blocks owned by each tag, i.e., tag_data.
 	void commitMessages(Version version, const std::vector<TagsAndMessage>& taggedMessages);
 
+	// Commits the versions after version.get() that the LogRouterCache has the messages of.
+	Future<Void> pullCachedData();
+
 	Future<Void> waitForVersion(Version ver);
 	Future<Void> waitForVersionAndLog(Version ver);
 
@@ -245,6 +275,18 @@ struct LogRouterData {
 	Future<Void> cleanupPeekTrackers();
 };
 
+TagsAndMessage LogRouterData::routeMessage(StringRef message, VectorRef<Tag> tags, Arena& arena) {
+	TagsAndMessage tagAndMsg;
+	tagAndMsg.message = message;
+	pushLocations.clear();
+	logSet.getPushLocations(tags, pushLocations, 0);
+	tagAndMsg.tags.reserve(arena, pushLocations.size());
+	for (const auto& t : pushLocations) {
+		tagAndMsg.tags.push_back(arena, Tag(tagLocalityRemoteLog, t));
+	}
+	return tagAndMsg;
+}
+
 void LogRouterData::commitMessages(Version version, const std::vector<TagsAndMessage>& taggedMessages) {
 	if (!taggedMessages.size()) {
 		return;
@@ -439,12 +481,23 @@ Future<Void> LogRouterData::pullAsyncData() {
 	Reference<ILogSystem::IPeekCursor> r;
 	Version tagAt = version.get() + 1;
 	Version lastVer = 0;
-	std::vector<int> tags; // an optimization to avoid reallocating vector memory in every loop
+	Version cachedVer = invalidVersion; // The messages of the versions up to it pulled by r are in the cache
 
 	bool isReplaced = startVersion == 0; // replacement log router
 
+	if (cache.enabled() && !isReplaced) {
+		co_await pullCachedData();
+		tagAt = version.get() + 1;
+	}
+
 	while (true) {
+		Reference<ILogSystem::IPeekCursor> prevCursor = r;
 		r = co_await getPeekCursorData(r, tagAt);
+		if (r != prevCursor) {
+			cachedVer = tagAt - 1;
+		}
+		// Messages of versions before the popped version may be missing
+		cachedVer = std::max(cachedVer, r->popped() - 1);
 
 		minKnownCommittedVersion = std::max(minKnownCommittedVersion, r->getMinKnownCommittedVersion());
 
@@ -463,10 +516,23 @@ Future<Void> LogRouterData::pullAsyncData() {
 				continue;
 			}
 			isReplaced = false;
+
+			// The log router this one replaces, or another one of the process, may have left the versions after
+			// the popped version in the cache. If so, reopen the cursor after them.
+			if (cache.enabled()) {
+				co_await pullCachedData();
+				if (version.get() >= tagAt) {
+					tagAt = version.get() + 1;
+					r = Reference<ILogSystem::IPeekCursor>();
+					logSystemChanged = Void();
+					continue;
+				}
+			}
 		}
 
 		Version ver = 0;
 		std::vector<TagsAndMessage> messages;
+		std::vector<TagsAndMessage> pulledMessages; // messages with the tags they were pushed with, for the cache
 		Arena arena;
 		while (true) {
 			bool foundMessage = r->hasMessage();
@@ -481,6 +547,10 @@ Future<Void> LogRouterData::pullAsyncData() {
 					    .detail("MessageCount", messages.size());
 
 					commitMessages(ver, messages);
+					if (cache.enabled() && ver > cachedVer) {
+						cache.add(generation, epochEnd, routerTag, cachedVer, ver, pulledMessages);
+						cachedVer = ver;
+					}
 					version.set(ver);
 					co_await yield(TaskPriority::TLogCommit);
 					//TraceEvent("LogRouterVersion").detail("Ver",ver);
@@ -488,10 +558,15 @@ Future<Void> LogRouterData::pullAsyncData() {
 				lastVer = ver;
 				ver = r->version().version;
 				messages.clear();
+				pulledMessages.clear();
 				arena = Arena();
 
 				if (!foundMessage) {
 					ver--; // ver is the next possible version we will get data for
+					if (cache.enabled() && ver > cachedVer) {
+						cache.add(generation, epochEnd, routerTag, cachedVer, ver, pulledMessages);
+						cachedVer = ver;
+					}
 					if (ver > version.get() && ver >= r->popped()) {
 						co_await waitForVersionAndLog(ver);
 
@@ -502,15 +577,12 @@ Future<Void> LogRouterData::pullAsyncData() {
 				}
 			}
 
-			TagsAndMessage tagAndMsg;
-			tagAndMsg.message = r->getMessageWithTags();
-			tags.clear();
-			logSet.getPushLocations(r->getTags(), tags, 0);
-			tagAndMsg.tags.reserve(arena, tags.size());
-			for (const auto& t : tags) {
-				tagAndMsg.tags.push_back(arena, Tag(tagLocalityRemoteLog, t));
+			// getMessageWithTags() consumes the message, so it is read once for routing and caching
+			StringRef msg = r->getMessageWithTags();
+			messages.push_back(routeMessage(msg, r->getTags(), arena));
+			if (cache.enabled()) {
+				pulledMessages.emplace_back(msg, r->getTags());
 			}
-			messages.push_back(std::move(tagAndMsg));
 
 			r->nextMessage();
 		}
@@ -519,6 +591,41 @@ Future<Void> LogRouterData::pullAsyncData() {
 	}
 }
 
+Future<Void> LogRouterData::pullCachedData() {
+	// A cursor would not return the versions at or after the epoch end
+	const Version limit = epochEnd == MAX_VERSION ? MAX_VERSION : epochEnd - 1;
+	std::vector<LogRouterCache::VersionMessages> cached;
+	++cacheLookups;
+	const Version end = cache.read(generation, epochEnd, routerTag, version.get(), limit, cached);
+	if (end == version.get()) {
+		co_return;
+	}
+	++cacheHits;
+
+	std::vector<TagsAndMessage> messages;
+	for (const auto& v : cached) {
+		co_await waitForVersionAndLog(v.version);
+		Arena arena;
+		messages.clear();
+		for (const auto& m : v.messages) {
+			messages.push_back(routeMessage(m.message, m.tags, arena));
+			cacheBytesSaved += m.message.size();
+		}
+		commitMessages(v.version, messages);
+		version.set(v.version);
+		co_await yield(TaskPriority::TLogCommit);
+	}
+	if (end > version.get()) {
+		co_await waitForVersionAndLog(end);
+		version.set(end);
+		co_await yield(TaskPriority::TLogCommit);
+	}
+	TraceEvent("LogRouterPulledCachedData", dbgid)
+	    .detail("RouterTag", routerTag.toString())
+	    .detail("Versions", cached.size())
+	    .detail("End", end);
+}
+
 void LogRouterData::peekMessagesFromMemory(Tag tag, Version begin, BinaryWriter& messages, Version& endVersion) {
 	ASSERT(!messages.getLength());
 
@@ -0,0 +1,218 @@
+/*
+ * LogRouterCache.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+
+#include "fdbserver/Knobs.h"
+#include "fdbserver/LogRouterCache.h"
+#include "flow/UnitTest.h"
+#include "flow/network.h"
+
+namespace {
+
+int64_t messagesBytes(VectorRef<TagsAndMessage> messages) {
+	int64_t bytes = 0;
+	for (const auto& m : messages) {
+		bytes += m.message.size() + m.tags.size() * sizeof(Tag);
+	}
+	return bytes;
+}
+
+} // namespace
+
+LogRouterCache& LogRouterCache::get() {
+	auto cache = g_network->global(INetwork::enLogRouterCache);
+	if (cache) {
+		return *reinterpret_cast<LogRouterCache*>(cache);
+	}
+	auto res = new LogRouterCache(SERVER_KNOBS->LOG_ROUTER_CACHE_BYTES);
+	g_network->setGlobal(INetwork::enLogRouterCache, res);
+	return *res;
+}
+
+void LogRouterCache::addReader(int64_t generation, Version epochEnd, Tag routerTag) {
+	tags[Key{ generation, epochEnd, routerTag }].readers++;
+	for (auto it = tags.begin(); it != tags.end() && it->first.generation < generation;) {
+		if (it->second.readers == 0) {
+			bytes -= it->second.bytes;
+			it = tags.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+void LogRouterCache::removeReader(int64_t generation, Version epochEnd, Tag routerTag) {
+	auto it = tags.find(Key{ generation, epochEnd, routerTag });
+	ASSERT(it != tags.end() && it->second.readers > 0);
+	if (--it->second.readers == 0 && tags.rbegin()->first.generation > generation) {
+		bytes -= it->second.bytes;
+		tags.erase(it);
+	}
+}
+
+void LogRouterCache::add(int64_t generation,
+                         Version epochEnd,
+                         Tag routerTag,
+                         Version previous,
+                         Version version,
+                         const std::vector<TagsAndMessage>& messages) {
+	auto it = tags.find(Key{ generation, epochEnd, routerTag });
+	if (it == tags.end()) {
+		return;
+	}
+	TagCache& cache = it->second;
+	ASSERT(version > previous);
+	if (cache.end != previous) {
+		bytes -= cache.bytes;
+		cache.bytes = 0;
+		cache.versions.clear();
+		cache.begin = previous;
+	}
+	cache.end = version;
+	if (messages.empty()) {
+		return;
+	}
+
+	VersionMessages entry{ version, Standalone<VectorRef<TagsAndMessage>>() };
+	Arena& arena = entry.messages.arena();
+	entry.messages.reserve(arena, messages.size());
+	for (const auto& m : messages) {
+		entry.messages.push_back(arena, TagsAndMessage(StringRef(arena, m.message), VectorRef<Tag>(arena, m.tags)));
+	}
+	const int64_t entryBytes = messagesBytes(entry.messages);
+	cache.versions.push_back(std::move(entry));
+	cache.bytes += entryBytes;
+	bytes += entryBytes;
+	evict();
+}
+
+Version LogRouterCache::read(int64_t generation,
+                             Version epochEnd,
+                             Tag routerTag,
+                             Version begin,
+                             Version limit,
+                             std::vector<VersionMessages>& out) const {
+	auto it = tags.find(Key{ generation, epochEnd, routerTag });
+	if (it == tags.end() || begin < it->second.begin || begin >= it->second.end) {
+		return begin;
+	}
+	const TagCache& cache = it->second;
+	const Version end = std::min(cache.end, limit);
+	auto v = std::upper_bound(cache.versions.begin(),
+	                          cache.versions.end(),
+	                          begin,
+	                          [](Version l, const VersionMessages& r) { return l < r.version; });
+	for (; v != cache.versions.end() && v->version <= end; ++v) {
+		out.push_back(*v);
+	}
+	return std::max(begin, end);
+}
+
+// Drops the oldest version of the router tag with the most bytes cached until the cache fits
+void LogRouterCache::evict() {
+	while (bytes > maxBytes) {
+		auto largest = std::max_element(tags.begin(), tags.end(), [](const auto& l, const auto& r) {
+			return l.second.bytes < r.second.bytes;
+		});
+		TagCache& cache = largest->second;
+		ASSERT(!cache.versions.empty());
+		const int64_t entryBytes = messagesBytes(cache.versions.front().messages);
+		cache.begin = cache.versions.front().version;
+		cache.versions.pop_front();
+		cache.bytes -= entryBytes;
+		bytes -= entryBytes;
+	}
+}
+
+namespace {
+
+std::vector<TagsAndMessage> makeMessages(Arena& arena, int count) {
+	std::vector<TagsAndMessage> messages;
+	for (int i = 0; i < count; i++) {
+		VectorRef<Tag> tags;
+		tags.push_back(arena, Tag(tagLocalityLogRouter, i));
+		messages.emplace_back(StringRef(arena, std::string(100, 'a' + i)), tags);
+	}
+	return messages;
+}
+
+} // namespace
+
+TEST_CASE("/fdbserver/LogRouterCache/readAfterAdd") {
+	LogRouterCache cache(1000);
+	const Tag routerTag(tagLocalityLogRouter, 0);
+	std::vector<LogRouterCache::VersionMessages> out;
+	Arena arena;
+
+	// Nothing is cached for router tags without readers
+	cache.add(1, MAX_VERSION, routerTag, 0, 10, makeMessages(arena, 1));
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 0, 100, out), 0);
+
+	cache.addReader(1, MAX_VERSION, routerTag);
+	cache.add(1, MAX_VERSION, routerTag, 0, 10, makeMessages(arena, 1));
+	cache.add(1, MAX_VERSION, routerTag, 10, 15, {});
+	cache.add(1, MAX_VERSION, routerTag, 15, 20, makeMessages(arena, 2));
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 0, 100, out), 20);
+	ASSERT_EQ(out.size(), 2);
+	ASSERT_EQ(out[0].version, 10);
+	ASSERT_EQ(out[1].version, 20);
+	ASSERT(out[1].messages[1].message == StringRef(std::string(100, 'b')));
+	ASSERT(out[1].messages[1].tags[0] == Tag(tagLocalityLogRouter, 1));
+
+	out.clear();
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 12, 17, out), 17);
+	ASSERT(out.empty());
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 20, 100, out), 20);
+	ASSERT_EQ(cache.read(2, MAX_VERSION, routerTag, 0, 100, out), 0);
+
+	// A gap restarts the known range
+	cache.add(1, MAX_VERSION, routerTag, 25, 30, makeMessages(arena, 1));
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 0, 100, out), 0);
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 25, 100, out), 30);
+	ASSERT_EQ(out.size(), 1);
+
+	// Going over the size limit drops the oldest versions
+	for (Version v = 30; v < 70; v += 10) {
+		cache.add(1, MAX_VERSION, routerTag, v, v + 10, makeMessages(arena, 3));
+	}
+	ASSERT(cache.getBytes() <= 1000);
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 25, 100, out), 25);
+	out.clear();
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 40, 100, out), 70);
+	ASSERT_EQ(out.size(), 3);
+
+	// The log sets of a generation are kept apart
+	cache.addReader(1, 50, routerTag);
+	cache.add(1, 50, routerTag, 40, 45, makeMessages(arena, 1));
+	out.clear();
+	ASSERT_EQ(cache.read(1, 50, routerTag, 40, 100, out), 45);
+	ASSERT_EQ(out.size(), 1);
+	ASSERT_EQ(out[0].version, 45);
+	ASSERT_EQ(cache.read(1, 60, routerTag, 40, 100, out), 40);
+	cache.removeReader(1, 50, routerTag);
+
+	// The data of older generations goes away with their readers
+	cache.addReader(2, MAX_VERSION, routerTag);
+	cache.removeReader(1, MAX_VERSION, routerTag);
+	ASSERT_EQ(cache.read(1, MAX_VERSION, routerTag, 40, 100, out), 40);
+	ASSERT_EQ(cache.getBytes(), 0);
+	return Void();
+}
@@ -285,6 +285,7 @@ LogPushData::LogPushData(Reference<ILogSystem> logSystem, int tlogCount) : logSy
 		messagesWriter.emplace_back(AssumeVersion(g_network->protocolVersion()));
 	}
 	messagesWritten = std::vector<bool>(tlogCount, false);
+	referencedValues.resize(tlogCount);
 }
 
 void LogPushData::addTxsTag() {
@@ -323,6 +324,143 @@ void LogPushData::writeMessage(StringRef rawMessageWithoutLength, bool usePrevio
 	}
 }
 
+uint32_t LogPushData::prepareMessage(bool metadataMessage, bool allLocations) {
+	prev_tags.clear();
+	if (logSystem->hasRemoteLogs()) {
+		prev_tags.push_back(chooseRouterTag());
+	}
+	for (auto& tag : next_message_tags) {
+		prev_tags.push_back(tag);
+	}
+	msg_locations.clear();
+	logSystem->getPushLocations(prev_tags, msg_locations, allLocations, fromLocations);
+
+	// Metadata messages (currently LogProtocolMessage is the only metadata
+	// message) should be written before span information. If this isn't a
+	// metadata message, make sure all locations have had transaction info
+	// written to them.  Mutations may have different sets of tags, so it
+	// is necessary to check all tag locations each time a mutation is
+	// written.
+	if (!metadataMessage) {
+		uint32_t subseq = this->subsequence++;
+		bool updatedLocation = false;
+		for (int loc : msg_locations) {
+			updatedLocation = writeTransactionInfo(loc, subseq) || updatedLocation;
+		}
+		// If this message doesn't write to any new locations, the
+		// subsequence wasn't actually used and can be decremented.
+		if (!updatedLocation) {
+			this->subsequence--;
+			CODE_PROBE(true, "No new SpanContextMessage written to transaction logs");
+			ASSERT(this->subsequence > 0);
+		}
+	} else {
+		// When writing a metadata message, make sure transaction state has
+		// been reset. If you are running into this assertion, make sure
+		// you are calling addTransactionInfo before each transaction.
+		ASSERT(writtenLocations.size() == 0);
+	}
+
+	return this->subsequence++;
+}
+
+void LogPushData::writeMutation(MutationRef const& mutation, Arena const& valueArena, int minReferencedBytes) {
+	if (minReferencedBytes <= 0 || mutation.type == MutationRef::ClearRange ||
+	    mutation.param2.size() < minReferencedBytes) {
+		writeTypedMessage(mutation);
+		return;
+	}
+
+	uint32_t subseq = prepareMessage(false, false);
+
+	// Everything MutationRef::serialize() writes but the value, which is followed by the checksum and the
+	// accumulative checksum index, if any
+	MutationRef m = mutation;
+	uint8_t type = m.type;
+	uint8_t valueSuffix[sizeof(uint32_t) + sizeof(uint16_t)];
+	int valueSuffixLength = 0;
+	if (g_network->protocolVersion().hasMutationChecksum() && CLIENT_KNOBS->ENABLE_MUTATION_CHECKSUM) {
+		m.populateChecksum();
+		type = m.createTypeWithChecksum(type);
+		uint32_t cs = m.checksum.get();
+		memcpy(valueSuffix, &cs, sizeof(cs));
+		valueSuffixLength = sizeof(cs);
+		if (CLIENT_KNOBS->ENABLE_ACCUMULATIVE_CHECKSUM && m.accumulativeChecksumIndex.present()) {
+			type = m.createTypeWithAccumulativeChecksumIndex(type);
+			uint16_t acsIdx = m.accumulativeChecksumIndex.get();
+			memcpy(valueSuffix + valueSuffixLength, &acsIdx, sizeof(acsIdx));
+			valueSuffixLength += sizeof(acsIdx);
+		}
+	}
+
+	bool first = true;
+	int firstOffset = -1, firstLength = -1, valueOffset = -1;
+	for (int loc : msg_locations) {
+		BinaryWriter& wr = messagesWriter[loc];
+		const int offset = wr.getLength();
+		if (first) {
+			firstOffset = offset;
+			wr << uint32_t(0) << subseq << uint16_t(prev_tags.size());
+			for (auto& tag : prev_tags)
+				wr << tag;
+			wr << type << m.param1 << uint32_t(m.param2.size() + valueSuffixLength);
+			valueOffset = wr.getLength() - firstOffset;
+			wr.serializeBytes(valueSuffix, valueSuffixLength);
+			firstLength = wr.getLength() - firstOffset;
+			*(uint32_t*)((uint8_t*)wr.getData() + firstOffset) = firstLength + m.param2.size() - sizeof(uint32_t);
+			first = false;
+		} else {
+			BinaryWriter& from = messagesWriter[msg_locations[0]];
+			wr.serializeBytes((uint8_t*)from.getData() + firstOffset, firstLength);
+		}
+		referencedValues[loc].emplace_back(offset + valueOffset, m.param2);
+	}
+	if (lastReferencedArena != &valueArena) {
+		referencedArena.dependsOn(valueArena);
+		lastReferencedArena = &valueArena;
+	}
+	written_tags.insert(next_message_tags.begin(), next_message_tags.end());
+	next_message_tags.clear();
+}
+
+Standalone<StringRef> LogPushData::getMessages(int loc) const {
+	if (referencedValues[loc].empty()) {
+		return messagesWriter[loc].toValue();
+	}
+	Standalone<VectorRef<StringRef>> pieces = getMessagePieces(loc);
+	int length = 0;
+	for (const auto& piece : pieces) {
+		length += piece.size();
+	}
+	Standalone<StringRef> messages = makeString(length);
+	uint8_t* out = mutateString(messages);
+	for (const auto& piece : pieces) {
+		memcpy(out, piece.begin(), piece.size());
+		out += piece.size();
+	}
+	return messages;
+}
+
+Standalone<VectorRef<StringRef>> LogPushData::getMessagePieces(int loc) const {
+	Standalone<VectorRef<StringRef>> pieces;
+	Standalone<StringRef> written = messagesWriter[loc].toValue();
+	pieces.arena().dependsOn(written.arena());
+	pieces.arena().dependsOn(referencedArena);
+	pieces.reserve(pieces.arena(), 2 * referencedValues[loc].size() + 1);
+	int offset = 0;
+	for (const auto& [valueOffset, value] : referencedValues[loc]) {
+		if (valueOffset > offset) {
+			pieces.push_back(pieces.arena(), written.substr(offset, valueOffset - offset));
+		}
+		pieces.push_back(pieces.arena(), value);
+		offset = valueOffset;
+	}
+	if (offset < written.size()) {
+		pieces.push_back(pieces.arena(), written.substr(offset));
+	}
+	return pieces;
+}
+
 std::vector<Standalone<StringRef>> LogPushData::getAllMessages() const {
 	std::vector<Standalone<StringRef>> results;
 	results.reserve(messagesWriter.size());
@@ -336,7 +474,7 @@ void LogPushData::recordEmptyMessage(int loc, const Standalone<StringRef>& value
 	if (!messagesWritten[loc]) {
 		BinaryWriter w(AssumeVersion(g_network->protocolVersion()));
 		Standalone<StringRef> v = w.toValue();
-		if (value.size() > v.size()) {
+		if (value.size() > v.size() || !referencedValues[loc].empty()) {
 			messagesWritten[loc] = true;
 		}
 	}
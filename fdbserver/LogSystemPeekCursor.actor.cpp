@@ -22,6 +22,7 @@
 #include "fdbrpc/FailureMonitor.h"
 #include "fdbserver/Knobs.h"
 #include "fdbserver/MutationTracking.h"
+#include "fdbserver/PeekCursorReplicas.h"
 #include "fdbrpc/ReplicationUtils.h"
 #include "flow/DebugTrace.h"
 #include "flow/actorcompiler.h" // has to be last include
@@ -40,7 +41,7 @@ ACTOR Future<Void> tryEstablishPeekStream(ILogSystem::ServerPeekCursor* self) {
 	auto req = TLogPeekStreamRequest(self->messageVersion.version,
 	                                 self->tag,
 	                                 self->returnIfBlocked,
-	                                 std::numeric_limits<int>::max(),
+	                                 SERVER_KNOBS->PEEK_STREAM_BUFFER_BYTES,
 	                                 self->end.version,
 	                                 self->returnEmptyIfStopped);
 	self->peekReplyStream = self->interf->get().interf().peekStreamMessages.getReplyStream(req);
@@ -178,6 +179,25 @@ VectorRef<Tag> ILogSystem::ServerPeekCursor::getTags() const {
 
 void ILogSystem::ServerPeekCursor::advanceTo(LogMessageVersion n) {
 	//TraceEvent("SPC_AdvanceTo", randomID).detail("N", n.toString());
+	if (hasMessage() && messageVersion.version < n.version) {
+		// Skip the versions before n by the lengths in their headers, without loading the tags of their messages
+		getMessage();
+		while (!rd.empty()) {
+			const int32_t length = *(int32_t*)rd.peekBytes(sizeof(int32_t));
+			if (length == VERSION_HEADER) {
+				const uint8_t* header = (const uint8_t*)rd.peekBytes(sizeof(int32_t) + sizeof(Version));
+				Version ver;
+				memcpy(&ver, header + sizeof(int32_t), sizeof(ver));
+				if (ver >= n.version || ver >= end.version) {
+					break;
+				}
+				rd.readBytes(sizeof(int32_t) + sizeof(Version));
+			} else {
+				rd.readBytes(sizeof(int32_t) + length);
+			}
+		}
+		nextMessage();
+	}
 	while (messageVersion < n && hasMessage()) {
 		getMessage();
 		nextMessage();
@@ -728,13 +748,12 @@ void ILogSystem::MergedPeekCursor::calcHasMessage() {
 			serverCursors[bestServer]->advanceTo(nextVersion.get());
 		}
 		if (serverCursors[bestServer]->hasMessage()) {
+			const LogMessageVersion previousVersion = messageVersion;
 			messageVersion = serverCursors[bestServer]->version();
 			currentCursor = bestServer;
 			hasNextMessage = true;
 
-			for (auto& c : serverCursors) {
-				c->advanceTo(messageVersion);
-			}
+			advanceReplicaCursors(serverCursors, previousVersion, messageVersion);
 
 			return;
 		}
@@ -1029,6 +1048,7 @@ void ILogSystem::SetPeekCursor::calcHasMessage() {
 			serverCursors[bestSet][bestServer]->advanceTo(nextVersion.get());
 		}
 		if (serverCursors[bestSet][bestServer]->hasMessage()) {
+			const LogMessageVersion previousVersion = messageVersion;
 			messageVersion = serverCursors[bestSet][bestServer]->version();
 			currentSet = bestSet;
 			currentCursor = bestServer;
@@ -1037,9 +1057,7 @@ void ILogSystem::SetPeekCursor::calcHasMessage() {
 			//TraceEvent("LPC_Calc1").detail("Ver", messageVersion.toString()).detail("Tag", tag.toString()).detail("HasNextMessage", hasNextMessage);
 
 			for (auto& cursors : serverCursors) {
-				for (auto& c : cursors) {
-					c->advanceTo(messageVersion);
-				}
+				advanceReplicaCursors(cursors, previousVersion, messageVersion);
 			}
 
 			return;
@@ -0,0 +1,146 @@
+/*
+ * MutationCoalescer.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbserver/MutationCoalescer.h"
+#include "flow/UnitTest.h"
+
+void MutationCoalescer::add(MutationRef const& m) {
+	ASSERT(m.type == MutationRef::SetValue || m.type == MutationRef::ClearRange);
+	++mutationsAdded;
+	bytesAdded += m.expectedSize();
+
+	if (m.type == MutationRef::SetValue) {
+		sets[m.param1] = m.param2;
+		return;
+	}
+
+	KeyRef begin = m.param1;
+	KeyRef end = m.param2;
+	if (begin >= end) {
+		return;
+	}
+	sets.erase(sets.lower_bound(begin), sets.lower_bound(end));
+
+	// Merge with the clear before it if that reaches begin, then absorb every clear that starts at or before end
+	auto i = clears.upper_bound(begin);
+	if (i != clears.begin() && std::prev(i)->second >= begin) {
+		--i;
+		begin = i->first;
+	}
+	while (i != clears.end() && i->first <= end) {
+		end = std::max(end, i->second);
+		i = clears.erase(i);
+	}
+	clears[begin] = end;
+}
+
+std::vector<MutationRef> MutationCoalescer::getMutations() const {
+	std::vector<MutationRef> mutations;
+	mutations.reserve(clears.size() + sets.size());
+	for (const auto& [begin, end] : clears) {
+		mutations.emplace_back(MutationRef::ClearRange, begin, end);
+	}
+	for (const auto& [key, value] : sets) {
+		mutations.emplace_back(MutationRef::SetValue, key, value);
+	}
+	return mutations;
+}
+
+namespace {
+
+MutationRef set(KeyRef key, ValueRef value) {
+	return MutationRef(MutationRef::SetValue, key, value);
+}
+
+MutationRef clear(KeyRef begin, KeyRef end) {
+	return MutationRef(MutationRef::ClearRange, begin, end);
+}
+
+bool sameMutations(std::vector<MutationRef> const& a, std::vector<MutationRef> const& b) {
+	if (a.size() != b.size()) {
+		return false;
+	}
+	for (size_t i = 0; i < a.size(); i++) {
+		if (a[i].type != b[i].type || a[i].param1 != b[i].param1 || a[i].param2 != b[i].param2) {
+			return false;
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+TEST_CASE("/fdbserver/MutationCoalescer/coalesce") {
+	MutationCoalescer c;
+	ASSERT(c.getMutations().empty());
+
+	// Repeated sets of a key keep the last value, and a set after a clear survives it
+	c.add(set("a"_sr, "1"_sr));
+	c.add(set("b"_sr, "1"_sr));
+	c.add(set("a"_sr, "2"_sr));
+	c.add(clear("b"_sr, "c"_sr));
+	c.add(set("b"_sr, "2"_sr));
+	c.add(set("d"_sr, "1"_sr));
+	c.add(clear("c"_sr, "e"_sr));
+	ASSERT(sameMutations(c.getMutations(), { clear("b"_sr, "e"_sr), set("a"_sr, "2"_sr), set("b"_sr, "2"_sr) }));
+	ASSERT_EQ(c.getMutationsAdded(), 7);
+
+	// Overlapping clears merge and disjoint ones stay apart
+	c.add(clear("x"_sr, "z"_sr));
+	c.add(clear("g"_sr, "h"_sr));
+	c.add(clear("a"_sr, "b"_sr));
+	c.add(clear("f"_sr, "y"_sr));
+	c.add(clear("q"_sr, "q"_sr));
+	ASSERT(sameMutations(c.getMutations(), { clear("a"_sr, "e"_sr), clear("f"_sr, "z"_sr), set("b"_sr, "2"_sr) }));
+
+	// The result matches applying every added mutation in order
+	MutationCoalescer r;
+	std::map<Key, Value> expected, actual;
+	auto apply = [](std::map<Key, Value>& kv, MutationRef const& m) {
+		if (m.type == MutationRef::SetValue) {
+			kv[m.param1] = m.param2;
+		} else {
+			kv.erase(kv.lower_bound(m.param1), kv.lower_bound(m.param2));
+		}
+	};
+	for (int i = 0; i < 26; i++) {
+		actual[Key(std::string(1, 'a' + i))] = "0"_sr;
+	}
+	expected = actual;
+	Arena arena;
+	for (int i = 0; i < 200; i++) {
+		KeyRef a(arena, std::string(1, 'a' + deterministicRandom()->randomInt(0, 26)));
+		KeyRef b(arena, std::string(1, 'a' + deterministicRandom()->randomInt(0, 26)));
+		MutationRef m = deterministicRandom()->coinflip()
+		                    ? set(a, StringRef(arena, format("%d", i)))
+		                    : clear(std::min(a, b), std::max(a, b));
+		r.add(m);
+		apply(expected, m);
+	}
+	int bytes = 0;
+	for (const auto& m : r.getMutations()) {
+		apply(actual, m);
+		bytes += m.expectedSize();
+	}
+	ASSERT(expected == actual);
+	ASSERT(bytes <= r.getBytesAdded());
+
+	return Void();
+}
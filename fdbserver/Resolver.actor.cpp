@@ -158,10 +158,13 @@ struct Resolver : ReferenceCounted<Resolver> {
 	CounterCollection cc;
 	Counter resolveBatchIn;
 	Counter resolveBatchStart;
+	Counter resolveBatchPreparedEarly;
 	Counter resolvedTransactions;
 	Counter resolvedBytes;
 	Counter resolvedReadConflictRanges;
 	Counter resolvedWriteConflictRanges;
+	Counter readConflictFilterHits;
+	Counter readConflictFilterMisses;
 	Counter transactionsAccepted;
 	Counter transactionsTooOld;
 	Counter transactionsConflicted;
@@ -192,11 +195,18 @@ struct Resolver : ReferenceCounted<Resolver> {
 
 	Resolver(UID dbgid, int commitProxyCount, int resolverCount)
 	  : dbgid(dbgid), commitProxyCount(commitProxyCount), resolverCount(resolverCount), version(-1),
-	    conflictSet(newConflictSet()), iopsSample(SERVER_KNOBS->KEY_BYTES_PER_SAMPLE), cc("Resolver", dbgid.toString()),
+	    conflictSet(newConflictSet(conflictSetTypeFromString(SERVER_KNOBS->RESOLVER_CONFLICT_SET_TYPE),
+	                               SERVER_KNOBS->RESOLVER_CONFLICT_CHECK_THREADS,
+	                               SERVER_KNOBS->RESOLVER_CONFLICT_CHECK_MIN_RANGES,
+	                               SERVER_KNOBS->RESOLVER_CONFLICT_FILTER_SLOTS,
+	                               SERVER_KNOBS->RESOLVER_CONFLICT_FILTER_PREFIX_LENGTH)),
+	    iopsSample(SERVER_KNOBS->KEY_BYTES_PER_SAMPLE), cc("Resolver", dbgid.toString()),
 	    resolveBatchIn("ResolveBatchIn", cc), resolveBatchStart("ResolveBatchStart", cc),
+	    resolveBatchPreparedEarly("ResolveBatchPreparedEarly", cc),
 	    resolvedTransactions("ResolvedTransactions", cc), resolvedBytes("ResolvedBytes", cc),
 	    resolvedReadConflictRanges("ResolvedReadConflictRanges", cc),
 	    resolvedWriteConflictRanges("ResolvedWriteConflictRanges", cc),
+	    readConflictFilterHits("ReadConflictFilterHits", cc), readConflictFilterMisses("ReadConflictFilterMisses", cc),
 	    transactionsAccepted("TransactionsAccepted", cc), transactionsTooOld("TransactionsTooOld", cc),
 	    transactionsConflicted("TransactionsConflicted", cc),
 	    resolvedStateTransactions("ResolvedStateTransactions", cc),
@@ -256,6 +266,21 @@ static bool hasNonLogRouterTags(const std::set<Tag>& allTags) {
 	return false;
 }
 
+// Adds the transactions of a batch to a new ConflictBatch and sorts their conflict ranges. None of this depends on the
+// conflict set, so it can be done while the batch is still waiting for the previous version to be resolved.
+static std::unique_ptr<ConflictBatch> prepareConflictBatch(Resolver* self,
+                                                           const ResolveTransactionBatchRequest& req,
+                                                           std::map<int, VectorRef<int>>* conflictingKeyRangeMap,
+                                                           Arena* arena) {
+	auto conflictBatch = std::make_unique<ConflictBatch>(self->conflictSet, conflictingKeyRangeMap, arena);
+	const Version newOldestVersion = req.version - SERVER_KNOBS->MAX_WRITE_TRANSACTION_LIFE_VERSIONS;
+	for (const auto& tr : req.transactions) {
+		conflictBatch->addTransaction(tr, newOldestVersion);
+	}
+	conflictBatch->sortConflictRanges();
+	return conflictBatch;
+}
+
 ACTOR Future<Void> resolveBatch(Reference<Resolver> self,
                                 ResolveTransactionBatchRequest req,
                                 Reference<AsyncVar<ServerDBInfo> const> db) {
@@ -266,6 +291,9 @@ ACTOR Future<Void> resolveBatch(Reference<Resolver> self,
 	state NetworkAddress proxyAddress =
 	    req.prevVersion >= 0 ? req.reply.getEndpoint().getPrimaryAddress() : NetworkAddress();
 	state ProxyRequestsInfo& proxyInfo = self->proxyInfoMap[proxyAddress];
+	state std::map<int, VectorRef<int>> conflictingKeyRangeMap;
+	state Arena conflictingKeyRangeArena;
+	state std::unique_ptr<ConflictBatch> conflictBatch;
 
 	++self->resolveBatchIn;
 
@@ -297,6 +325,11 @@ ACTOR Future<Void> resolveBatch(Reference<Resolver> self,
 		g_traceBatch.addEvent("CommitDebug", debugID.get().first(), "Resolver.resolveBatch.AfterQueueSizeCheck");
 	}
 
+	if (SERVER_KNOBS->RESOLVER_PREPARE_BATCH_EARLY && self->version.get() < req.prevVersion) {
+		conflictBatch = prepareConflictBatch(self.getPtr(), req, &conflictingKeyRangeMap, &conflictingKeyRangeArena);
+		++self->resolveBatchPreparedEarly;
+	}
+
 	wait(versionReady(self.getPtr(), &proxyInfo, req.prevVersion));
 
 	if (check_yield(TaskPriority::DefaultEndpoint)) {
@@ -337,10 +370,12 @@ ACTOR Future<Void> resolveBatch(Reference<Resolver> self,
 
 		// Detect conflicts
 		double expire = now() + SERVER_KNOBS->SAMPLE_EXPIRATION_TIME;
-		ConflictBatch conflictBatch(self->conflictSet, &reply.conflictingKeyRangeMap, &reply.arena);
+		if (!conflictBatch) {
+			conflictBatch =
+			    prepareConflictBatch(self.getPtr(), req, &conflictingKeyRangeMap, &conflictingKeyRangeArena);
+		}
 		const Version newOldestVersion = req.version - SERVER_KNOBS->MAX_WRITE_TRANSACTION_LIFE_VERSIONS;
 		for (int t = 0; t < req.transactions.size(); t++) {
-			conflictBatch.addTransaction(req.transactions[t], newOldestVersion);
 			self->resolvedReadConflictRanges += req.transactions[t].read_conflict_ranges.size();
 			self->resolvedWriteConflictRanges += req.transactions[t].write_conflict_ranges.size();
 
@@ -353,7 +388,14 @@ ACTOR Future<Void> resolveBatch(Reference<Resolver> self,
 					    it.begin, SERVER_KNOBS->SAMPLE_OFFSET_PER_KEY + it.begin.size(), expire);
 			}
 		}
-		conflictBatch.detectConflicts(req.version, newOldestVersion, commitList, &tooOldList);
+		conflictBatch->detectConflicts(req.version, newOldestVersion, commitList, &tooOldList);
+		if (conflictSetHasFilter(self->conflictSet)) {
+			self->readConflictFilterHits += conflictBatch->filteredReadConflictRanges;
+			self->readConflictFilterMisses += conflictBatch->checkedReadConflictRanges;
+		}
+		conflictBatch.reset();
+		reply.conflictingKeyRangeMap = std::move(conflictingKeyRangeMap);
+		reply.arena.dependsOn(conflictingKeyRangeArena);
 
 		reply.debugID = req.debugID;
 		reply.committed.resize(reply.arena, req.transactions.size());
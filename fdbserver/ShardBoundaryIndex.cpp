@@ -0,0 +1,199 @@
+/*
+ * ShardBoundaryIndex.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <cstring>
+
+#include "fdbserver/ShardBoundaryIndex.h"
+#include "flow/Platform.h"
+#include "flow/UnitTest.h"
+
+namespace {
+
+// The 8 bytes of key following offset, zero padded, as a big endian integer, so that the words of keys sharing their
+// first offset bytes sort like the keys themselves.
+force_inline uint64_t keyWord(const KeyRef& key, int offset) {
+	uint64_t word = 0;
+	if (offset < key.size())
+		memcpy(&word, key.begin() + offset, std::min(key.size() - offset, (int)sizeof(word)));
+	return bigEndian64(word);
+}
+
+// Returns the index of the first of the sorted words[0, n) that is > w if orEqual, or >= w otherwise. The comparisons
+// only select the next base, which compiles to conditional moves rather than branches.
+template <bool orEqual>
+force_inline int wordBound(const uint64_t* words, int n, uint64_t w) {
+	if (n == 0)
+		return 0;
+	const uint64_t* base = words;
+	while (n > 1) {
+		const int half = n / 2;
+		base += (orEqual ? base[half] <= w : base[half] < w) ? half : 0;
+		n -= half;
+	}
+	return (base - words) + (orEqual ? *base <= w : *base < w);
+}
+
+// Returns the index of the last of the n > 0 sorted keys that is <= key, or -1. All the keys share their first
+// prefixLength bytes and words[i] is keyWord(keys[i], prefixLength).
+force_inline int searchSorted(const KeyRef* keys, const uint64_t* words, int n, int prefixLength, const KeyRef& key) {
+	const int length = std::min(key.size(), prefixLength);
+	const int c = length ? memcmp(key.begin(), keys[0].begin(), length) : 0;
+	if (c < 0 || (c == 0 && key.size() < prefixLength))
+		return -1;
+	if (c > 0)
+		return n - 1;
+
+	const uint64_t w = keyWord(key, prefixLength);
+	const int begin = wordBound<false>(words, n, w);
+	const int end = wordBound<true>(words, n, w);
+	// Keys with the same word as key are ordered by their remaining bytes
+	return std::upper_bound(keys + begin, keys + end, key) - keys - 1;
+}
+
+} // namespace
+
+int ShardBoundaries::lastLessOrEqual(const KeyRef& key) const {
+	if (keys.empty())
+		return -1;
+
+	const int blockCount = blockKeys.size();
+	int block = 0;
+	if (blockCount > 1) {
+		block =
+		    1 + searchSorted(blockKeys.data() + 1, blockWords.data() + 1, blockCount - 1, blockKeysPrefixLength, key);
+	}
+	const int first = block * blockSize;
+	const int n = std::min(blockSize, size() - first);
+	return first + searchSorted(keys.data() + first, words.data() + first, n, blockPrefixLengths[block], key);
+}
+
+int ShardBoundaries::lowerBound(const KeyRef& key) const {
+	const int i = lastLessOrEqual(key);
+	return i >= 0 && keys[i] == key ? i : i + 1;
+}
+
+void ShardBoundaries::replace(int begin, int end, const std::vector<KeyRef>& newKeys) {
+	ASSERT(0 <= begin && begin <= end && end <= size());
+	for (int i = begin; i < end; i++) {
+		liveBytes -= keys[i].size();
+	}
+	std::vector<KeyRef> copies;
+	copies.reserve(newKeys.size());
+	for (const auto& key : newKeys) {
+		copies.push_back(KeyRef(arena, key));
+		liveBytes += key.size();
+	}
+	keys.erase(keys.begin() + begin, keys.begin() + end);
+	keys.insert(keys.begin() + begin, copies.begin(), copies.end());
+
+	// Replaced keys stay in the arena, so copy the live ones to a new arena once most of it is garbage
+	if (arena.getSize(FastInaccurateEstimate::True) > 2 * liveBytes + 4096) {
+		compact();
+	} else {
+		rebuild(begin / blockSize);
+	}
+}
+
+void ShardBoundaries::compact() {
+	Arena newArena;
+	for (auto& key : keys) {
+		key = KeyRef(newArena, key);
+	}
+	arena = newArena;
+	rebuild(0);
+}
+
+void ShardBoundaries::rebuild(int fromBlock) {
+	const int blockCount = (size() + blockSize - 1) / blockSize;
+	words.resize(size());
+	blockPrefixLengths.resize(blockCount);
+	blockKeys.resize(blockCount);
+	for (int b = fromBlock; b < blockCount; b++) {
+		const int first = b * blockSize;
+		const int last = std::min(first + blockSize, size()) - 1;
+		// The keys are sorted, so the first and last keys of the block share the prefix of all of them
+		const int prefixLength = commonPrefixLength(keys[first], keys[last]);
+		blockPrefixLengths[b] = prefixLength;
+		blockKeys[b] = keys[first];
+		for (int i = first; i <= last; i++) {
+			words[i] = keyWord(keys[i], prefixLength);
+		}
+	}
+
+	blockKeysPrefixLength = blockCount > 1 ? commonPrefixLength(blockKeys[1], blockKeys.back()) : 0;
+	blockWords.resize(blockCount);
+	for (int b = 1; b < blockCount; b++) {
+		blockWords[b] = keyWord(blockKeys[b], blockKeysPrefixLength);
+	}
+}
+
+namespace {
+
+// Keys with long shared prefixes and many keys that are equal in the 8 bytes following them
+Key randomBoundaryKey() {
+	static const char* prefixes[] = { "", "\x15\x01", "tenant/00000042/", "\xff/keyServers/" };
+	static const char bytes[] = { '\x00', 'a', 'b', '\xff' };
+	std::string key = prefixes[deterministicRandom()->randomInt(0, 4)];
+	const int length = deterministicRandom()->randomInt(0, 14);
+	for (int i = 0; i < length; i++) {
+		key.push_back(bytes[deterministicRandom()->randomInt(0, 4)]);
+	}
+	return Key(StringRef(key));
+}
+
+} // namespace
+
+TEST_CASE("/fdbserver/ShardBoundaryIndex/matchesKeyRangeMap") {
+	KeyRangeMap<int> map;
+	ShardBoundaryIndex<int> index;
+	const int steps = deterministicRandom()->randomInt(1, 2000);
+	for (int step = 0; step < steps; step++) {
+		// Change the map and apply a few changes at a time to the index
+		const int changes = deterministicRandom()->randomInt(0, 4);
+		for (int c = 0; c < changes; c++) {
+			Key a = randomBoundaryKey();
+			Key b = randomBoundaryKey();
+			if (b < a)
+				std::swap(a, b);
+			if (deterministicRandom()->random01() < 0.1)
+				a = Key();
+			KeyRangeRef range(a, b);
+			map.insert(range, step);
+			if (deterministicRandom()->random01() < 0.01) {
+				index.invalidateAll();
+			} else {
+				index.invalidate(range);
+			}
+		}
+		index.update(map);
+
+		for (int i = 0; i < 20; i++) {
+			Key key = randomBoundaryKey();
+			if (i == 0)
+				key = "\xff\xff\xff"_sr;
+			ASSERT(index.rangeContaining(key) == map.rangeContaining(key));
+		}
+		for (auto it : map.ranges()) {
+			ASSERT(index.rangeContaining(it.begin()) == it);
+		}
+	}
+	return Void();
+}
@@ -33,6 +33,9 @@
 #include "fdbclient/KeyRangeMap.h"
 #include "fdbclient/SystemData.h"
 #include "fdbserver/ConflictSet.h"
+#include "flow/Hash3.h"
+#include "flow/IThreadPool.h"
+#include "flow/ThreadPrimitives.h"
 #include "flow/UnitTest.h"
 
 static std::vector<PerfDoubleCounter*> skc;
@@ -784,20 +787,539 @@ private:
 	}
 };
 
+// An alternative to SkipList for the version history of written key ranges, selected by
+// RESOLVER_CONFLICT_SET_TYPE. Boundary keys live sorted in fixed-capacity leaves. Each leaf also keeps, in one
+// contiguous array, the 8 bytes of every key that follow the prefix shared by all of the leaf's keys, packed into
+// big-endian words. Locating a key within a leaf is then a branch-free scan over a few cache lines of integers
+// (which the compiler vectorizes), and full key comparisons are only needed when two words tie. The upper levels of
+// the skip list are replaced by flat arrays holding each leaf's first word and max version, so a read range check
+// can skip whole leaves that have not been written since the read snapshot.
+//
+// A boundary at key k with version v means that the range [k, next boundary) was last written at v. The boundary at
+// the empty key plays the role of SkipList's header and is never removed.
+class ConflictSetBTree : NonCopyable {
+private:
+	static constexpr int LeafCapacity = 64;
+
+	struct alignas(64) Leaf : NonCopyable {
+		// keyWords[i] holds the bytes [prefixLength, prefixLength + 8) of keys[i], zero padded
+		uint64_t keyWords[LeafCapacity];
+		Version versions[LeafCapacity];
+		StringRef keys[LeafCapacity];
+		int count = 0;
+		// Length of the prefix shared by all keys in this leaf. It may be shorter than the longest such prefix.
+		int prefixLength = 0;
+		int64_t keyBytes = 0; // Bytes of the keys currently in the leaf
+		int64_t arenaBytes = 0; // Bytes of the keys ever copied into arena
+		Arena arena;
+
+		void rebuildKeyWords() {
+			prefixLength = count > 1 ? commonPrefixLength(keys[0], keys[count - 1]) : 0;
+			for (int i = 0; i < count; i++)
+				keyWords[i] = keyWord(keys[i], prefixLength);
+		}
+
+		// Copies the keys into a fresh arena once more than half of the current one is garbage
+		void compactKeys() {
+			if (arenaBytes <= 2 * keyBytes + 4096)
+				return;
+			Arena newArena;
+			for (int i = 0; i < count; i++)
+				keys[i] = StringRef(newArena, keys[i]);
+			arena = newArena;
+			arenaBytes = keyBytes;
+		}
+
+		// Returns the number of keys in the leaf that are less than key
+		int lowerBound(const StringRef& key) const {
+			if (prefixLength) {
+				int c = memcmp(key.begin(), keys[0].begin(), std::min(key.size(), prefixLength));
+				if (c < 0 || (c == 0 && key.size() < prefixLength))
+					return 0;
+				if (c > 0)
+					return count;
+			}
+			const uint64_t word = keyWord(key, prefixLength);
+			int i = 0;
+			for (int j = 0; j < count; j++)
+				i += keyWords[j] < word;
+			while (i < count && keyWords[i] == word && compare(keys[i], key) < 0)
+				i++;
+			return i;
+		}
+
+		// pre: count < LeafCapacity, and key belongs at index
+		void insert(int index, const StringRef& key, Version version) {
+			const int tail = count - index;
+			memmove(&keyWords[index + 1], &keyWords[index], tail * sizeof(uint64_t));
+			memmove(&versions[index + 1], &versions[index], tail * sizeof(Version));
+			memmove(&keys[index + 1], &keys[index], tail * sizeof(StringRef));
+			keys[index] = StringRef(arena, key);
+			versions[index] = version;
+			keyBytes += key.size();
+			arenaBytes += key.size();
+			count++;
+			if ((index == 0 || index == count - 1) && count > 1 &&
+			    commonPrefixLength(keys[0], keys[count - 1]) < prefixLength) {
+				rebuildKeyWords();
+			} else {
+				keyWords[index] = keyWord(keys[index], prefixLength);
+			}
+		}
+
+		void erase(int begin, int end) {
+			if (begin >= end)
+				return;
+			for (int i = begin; i < end; i++)
+				keyBytes -= keys[i].size();
+			const int tail = count - end;
+			memmove(&keyWords[begin], &keyWords[end], tail * sizeof(uint64_t));
+			memmove(&versions[begin], &versions[end], tail * sizeof(Version));
+			memmove(&keys[begin], &keys[end], tail * sizeof(StringRef));
+			count -= end - begin;
+			if (!count)
+				prefixLength = 0;
+		}
+
+		// Visits the entries from begin while budget lasts, dropping each entry that is older than version along with
+		// the entry before it. Returns the index of the first unvisited entry.
+		int removeBefore(int begin, Version version, int& budget, bool& wasAbove) {
+			int kept = begin;
+			int i = begin;
+			for (; i < count && budget > 0; i++, budget--) {
+				const bool isAbove = versions[i] >= version;
+				if (isAbove || wasAbove) {
+					keyWords[kept] = keyWords[i];
+					versions[kept] = versions[i];
+					keys[kept] = keys[i];
+					kept++;
+				} else {
+					keyBytes -= keys[i].size();
+				}
+				wasAbove = isAbove;
+			}
+			const int tail = count - i;
+			memmove(&keyWords[kept], &keyWords[i], tail * sizeof(uint64_t));
+			memmove(&versions[kept], &versions[i], tail * sizeof(Version));
+			memmove(&keys[kept], &keys[i], tail * sizeof(StringRef));
+			count = kept + tail;
+			return kept;
+		}
+
+		// Moves the entries [begin, count) of this leaf to the end of other
+		void moveTo(int begin, Leaf* other) {
+			ASSERT(other->count + count - begin <= LeafCapacity);
+			for (int i = begin; i < count; i++) {
+				other->keys[other->count] = StringRef(other->arena, keys[i]);
+				other->versions[other->count] = versions[i];
+				other->keyBytes += keys[i].size();
+				other->arenaBytes += keys[i].size();
+				other->count++;
+			}
+			erase(begin, count);
+			other->rebuildKeyWords();
+		}
+	};
+
+	// Leaves in key order, along with the word of each leaf's first key and the max version in each leaf
+	std::vector<Leaf*> leaves;
+	std::vector<uint64_t> leafFirstWords;
+	std::vector<Version> leafMaxVersions;
+
+	static force_inline uint64_t keyWord(const StringRef& key, int offset) {
+		uint64_t word = 0;
+		if (offset < key.size())
+			memcpy(&word, key.begin() + offset, std::min(key.size() - offset, (int)sizeof(word)));
+		return bigEndian64(word);
+	}
+
+	void destroy() {
+		for (Leaf* leaf : leaves)
+			delete leaf;
+		leaves.clear();
+		leafFirstWords.clear();
+		leafMaxVersions.clear();
+	}
+
+	// Updates the first word and max version of leaves[li] after it has been modified
+	void refreshLeaf(int li) {
+		const Leaf* leaf = leaves[li];
+		ASSERT(leaf->count > 0);
+		leafFirstWords[li] = keyWord(leaf->keys[0], 0);
+		leafMaxVersions[li] = *std::max_element(leaf->versions, leaf->versions + leaf->count);
+	}
+
+	void insertLeaf(int li, Leaf* leaf) {
+		leaves.insert(leaves.begin() + li, leaf);
+		leafFirstWords.insert(leafFirstWords.begin() + li, 0);
+		leafMaxVersions.insert(leafMaxVersions.begin() + li, 0);
+	}
+
+	// Deletes leaves [begin, end)
+	void eraseLeaves(int begin, int end) {
+		for (int li = begin; li < end; li++)
+			delete leaves[li];
+		leaves.erase(leaves.begin() + begin, leaves.begin() + end);
+		leafFirstWords.erase(leafFirstWords.begin() + begin, leafFirstWords.begin() + end);
+		leafMaxVersions.erase(leafMaxVersions.begin() + begin, leafMaxVersions.begin() + end);
+	}
+
+	// Returns the index of the last leaf whose first key is <= key
+	int findLeaf(const StringRef& key) const {
+		const uint64_t word = keyWord(key, 0);
+		auto lower = std::lower_bound(leafFirstWords.begin(), leafFirstWords.end(), word);
+		auto upper = std::upper_bound(lower, leafFirstWords.end(), word);
+		auto begin = leaves.begin() + (lower - leafFirstWords.begin());
+		auto end = leaves.begin() + (upper - leafFirstWords.begin());
+		if (end - begin > 0) {
+			// Only leaves whose first words tie with the key need a full comparison
+			end = std::upper_bound(
+			    begin, end, key, [](const StringRef& k, const Leaf* leaf) { return compare(k, leaf->keys[0]) < 0; });
+		}
+		ASSERT(end != leaves.begin());
+		return end - leaves.begin() - 1;
+	}
+
+	// Inserts a boundary at index of leaves[li], splitting the leaf if it is full
+	void insert(int li, int index, const StringRef& key, Version version) {
+		Leaf* leaf = leaves[li];
+		if (leaf->count == LeafCapacity) {
+			Leaf* right = new Leaf;
+			const int half = LeafCapacity / 2;
+			leaf->moveTo(half, right);
+			leaf->rebuildKeyWords();
+			insertLeaf(li + 1, right);
+			refreshLeaf(li + 1);
+			if (index > half) {
+				index -= half;
+				leaf = right;
+				li++;
+			}
+		}
+		leaf->insert(index, key, version);
+		leaf->compactKeys();
+		refreshLeaf(li);
+	}
+
+	// Merges leaves[li + 1] into leaves[li] if both are sparse
+	void maybeMergeWithNext(int li) {
+		if (li + 1 >= leaves.size() || leaves[li]->count + leaves[li + 1]->count > LeafCapacity / 2)
+			return;
+		leaves[li + 1]->moveTo(0, leaves[li]);
+		eraseLeaves(li + 1, li + 2);
+		refreshLeaf(li);
+	}
+
+	// Returns true if a boundary covering any part of [begin, end) was written after version
+	bool isNewerThan(const StringRef& begin, const StringRef& end, Version version) const {
+		int li = findLeaf(begin);
+		int index = leaves[li]->lowerBound(begin);
+		// Start from the boundary covering begin. Like SkipList, an empty range is checked against the boundary
+		// before begin.
+		const Leaf* leaf = leaves[li];
+		if (begin == end || index == leaf->count || leaf->keys[index] != begin) {
+			if (index == 0) {
+				if (li == 0)
+					return false;
+				leaf = leaves[--li];
+				index = leaf->count;
+			}
+			index--;
+			if (leaf->versions[index] > version)
+				return true;
+			index++;
+		}
+
+		while (true) {
+			// Every boundary of this leaf is inside the range if the next leaf starts at or before end
+			const bool wholeLeaf = li + 1 < leaves.size() && compare(leaves[li + 1]->keys[0], end) <= 0;
+			if (leafMaxVersions[li] > version) {
+				for (; index < leaf->count; index++) {
+					if (compare(leaf->keys[index], end) >= 0)
+						return false;
+					if (leaf->versions[index] > version)
+						return true;
+				}
+			} else if (!wholeLeaf) {
+				return false;
+			}
+			if (++li == leaves.size())
+				return false;
+			leaf = leaves[li];
+			index = 0;
+		}
+	}
+
+public:
+	explicit ConflictSetBTree(Version version = 0) { clear(version); }
+	~ConflictSetBTree() { destroy(); }
+
+	void clear(Version version) {
+		destroy();
+		insertLeaf(0, new Leaf);
+		leaves[0]->insert(0, StringRef(), version);
+		refreshLeaf(0);
+	}
+
+	// Returns the total number of boundaries, not counting the one at the empty key.
+	int count() const {
+		int count = -1;
+		for (const Leaf* leaf : leaves)
+			count += leaf->count;
+		return count;
+	}
+
+	void detectConflicts(ReadConflictRange* ranges, int count, bool* transactionConflictStatus) {
+		for (int i = 0; i < count; i++) {
+			const ReadConflictRange& range = ranges[i];
+			if (isNewerThan(range.begin, range.end, range.version)) {
+				transactionConflictStatus[range.transaction] = true;
+				if (range.conflictingKeyRange != nullptr)
+					range.conflictingKeyRange->push_back(*range.cKRArena, range.indexInTx);
+			}
+		}
+	}
+
+	// Records that [begin, end) was written at version. Ranges must be added in increasing key order, or at least
+	// not overlap each other.
+	void addConflictRange(const StringRef& begin, const StringRef& end, Version version) {
+		// Keep the version history from end onwards unchanged
+		int le = findLeaf(end);
+		int ie = leaves[le]->lowerBound(end);
+		if (ie == leaves[le]->count || leaves[le]->keys[ie] != end) {
+			ASSERT(ie > 0);
+			insert(le, ie, end, leaves[le]->versions[ie - 1]);
+			le = findLeaf(end);
+			ie = leaves[le]->lowerBound(end);
+		}
+
+		const int lb = findLeaf(begin);
+		const int ib = leaves[lb]->lowerBound(begin);
+		if (lb == le) {
+			leaves[lb]->erase(ib, ie);
+		} else {
+			leaves[le]->erase(0, ie);
+			refreshLeaf(le);
+			leaves[lb]->erase(ib, leaves[lb]->count);
+			eraseLeaves(lb + 1, le);
+		}
+		// leaves[lb] may be empty at this point, but never is once begin is inserted
+		insert(lb, ib, begin, version);
+		maybeMergeWithNext(lb);
+	}
+
+	void addConflictRanges(const std::pair<StringRef, StringRef>* ranges, int count, Version version) {
+		for (int r = 0; r < count; r++)
+			addConflictRange(ranges[r].first, ranges[r].second, version);
+	}
+
+	// Like SkipList::removeBefore(), visits up to nodeCount boundaries starting from the first one >= startKey, and
+	// drops each boundary that, along with the boundary before it, is older than version. Returns the key of the
+	// first unvisited boundary, or an empty key once the end has been reached.
+	Key removeBefore(Version version, const StringRef& startKey, int nodeCount) {
+		int li = findLeaf(startKey);
+		int index = leaves[li]->lowerBound(startKey);
+		bool wasAbove = true;
+		while (true) {
+			Leaf* leaf = leaves[li];
+			const int before = leaf->count;
+			index = leaf->removeBefore(index, version, nodeCount, wasAbove);
+			if (!leaf->count) {
+				// The first leaf always keeps the boundary at the empty key
+				ASSERT(li > 0);
+				eraseLeaves(li, li + 1);
+				index = 0;
+			} else {
+				if (leaf->count != before)
+					refreshLeaf(li);
+				if (index == leaf->count)
+					maybeMergeWithNext(li);
+				if (index == leaf->count) {
+					li++;
+					index = 0;
+				}
+			}
+			if (li == leaves.size())
+				return Key();
+			if (!nodeCount)
+				return Key(leaves[li]->keys[index]);
+		}
+	}
+};
+
+// A versioned blocked bloom filter kept next to the version history of a ConflictSet. Each key is hashed by its first
+// prefixLength bytes to two slots in one cache line, and a slot holds the newest version written to any key hashing
+// there. A write range confined to one prefix raises its slots; any other write raises wideWriteVersion. A read range
+// confined to one prefix whose slots and wideWriteVersion are all at or below its snapshot cannot conflict, so its
+// walk of the history can be skipped.
+//
+// Nothing has to be removed as the history ages: a version at or below the oldest version of the ConflictSet is never
+// above the snapshot of a read that is still checked, so old slots stop causing walks on their own.
+class ConflictFilter : NonCopyable {
+public:
+	static constexpr int SlotsPerBlock = 64 / sizeof(Version);
+
+	// slotCount is rounded up to a power of two number of blocks, so that hashes can be masked
+	ConflictFilter(int slotCount, int prefixLength)
+	  : prefixLength(std::max(prefixLength, 1)), blockMask(blockCount(slotCount) - 1), slots(blockMask + 1) {}
+
+	void clear(Version v) {
+		std::fill(slots.begin(), slots.end(), Block());
+		wideWriteVersion = v;
+	}
+
+	bool mayConflict(const StringRef& begin, const StringRef& end, Version snapshot) const {
+		if (wideWriteVersion > snapshot || !isNarrow(begin, end))
+			return true;
+		int slot[2];
+		const Block& block = slots[probe(begin, slot)];
+		return std::max(block.versions[slot[0]], block.versions[slot[1]]) > snapshot;
+	}
+
+	void addWrite(const StringRef& begin, const StringRef& end, Version now) {
+		if (!isNarrow(begin, end)) {
+			wideWriteVersion = now;
+			return;
+		}
+		int slot[2];
+		Block& block = slots[probe(begin, slot)];
+		block.versions[slot[0]] = block.versions[slot[1]] = now;
+	}
+
+private:
+	struct alignas(64) Block {
+		Version versions[SlotsPerBlock] = {};
+	};
+
+	static uint32_t blockCount(int slotCount) {
+		const int64_t blocks = std::max<int64_t>((int64_t(slotCount) + SlotsPerBlock - 1) / SlotsPerBlock, 1);
+		uint32_t count = 1;
+		while (count < blocks && count < (1u << 30))
+			count <<= 1;
+		return count;
+	}
+
+	// True if every key in [begin, end) has the same first prefixLength bytes, or the range is the single key begin
+	bool isNarrow(const StringRef& begin, const StringRef& end) const {
+		if (begin.size() < prefixLength)
+			return end.size() == begin.size() + 1 && end[begin.size()] == 0 && end.startsWith(begin);
+		return end.size() >= prefixLength && commonPrefixLength(begin, end) >= prefixLength && begin < end;
+	}
+
+	// Returns the block of the key's prefix, and sets slot to the two slots of the prefix within that block
+	uint32_t probe(const StringRef& key, int* slot) const {
+		uint32_t h1 = 0, h2 = 0;
+		hashlittle2(key.begin(), std::min(key.size(), prefixLength), &h1, &h2);
+		slot[0] = h2 % SlotsPerBlock;
+		slot[1] = (h2 / SlotsPerBlock) % SlotsPerBlock;
+		return h1 & blockMask;
+	}
+
+	int prefixLength;
+	uint32_t blockMask;
+	std::vector<Block> slots;
+	Version wideWriteVersion = 0;
+};
+
+// A worker thread of a ConflictSet checking one key range slice of a batch's read conflict ranges
+struct ConflictCheckChunk {
+	std::vector<ReadConflictRange> ranges; // ranges[i].transaction == i, so conflicts are reported per range
+	std::unique_ptr<bool[]> conflicts;
+	Optional<Error> error;
+	Event done;
+};
+
+struct ConflictCheckThread final : IThreadPoolReceiver {
+	void init() override {}
+
+	struct CheckAction final : TypedAction<ConflictCheckThread, CheckAction> {
+		ConflictSet* cs;
+		ConflictCheckChunk* chunk;
+		CheckAction(ConflictSet* cs, ConflictCheckChunk* chunk) : cs(cs), chunk(chunk) {}
+		double getTimeEstimate() const override { return 0; }
+	};
+	void action(CheckAction& a);
+};
+
 struct ConflictSet {
-	ConflictSet() : removalKey(makeString(0)), oldestVersion(0) {}
+	ConflictSet(ConflictSetType type,
+	            int checkParallelism,
+	            int minRangesPerCheck,
+	            int filterSlots,
+	            int filterPrefixLength)
+	  : removalKey(makeString(0)), oldestVersion(0), checkParallelism(std::max(checkParallelism, 1)),
+	    minRangesPerCheck(std::max(minRangesPerCheck, 1)) {
+		if (type == ConflictSetType::BTree)
+			btreeHistory = std::make_unique<ConflictSetBTree>();
+		if (filterSlots > 0 && filterPrefixLength > 0)
+			filter = std::make_unique<ConflictFilter>(filterSlots, filterPrefixLength);
+		// In simulation the slices are checked one after another on the network thread, which exercises the same
+		// split and merge without introducing real threads
+		if (this->checkParallelism > 1 && !g_network->isSimulated()) {
+			checkThreads = createGenericThreadPool();
+			for (int i = 1; i < this->checkParallelism; i++)
+				checkThreads->addThread(new ConflictCheckThread, "fdb-resolver-check");
+		}
+	}
 	~ConflictSet() {}
 
+	void detectConflicts(ReadConflictRange* ranges, int count, bool* transactionConflictStatus) {
+		if (btreeHistory)
+			btreeHistory->detectConflicts(ranges, count, transactionConflictStatus);
+		else
+			versionHistory.detectConflicts(ranges, count, transactionConflictStatus);
+	}
+
+	void detectConflicts(ConflictCheckChunk& chunk) {
+		try {
+			detectConflicts(chunk.ranges.data(), chunk.ranges.size(), chunk.conflicts.get());
+		} catch (Error& e) {
+			chunk.error = e;
+		}
+		chunk.done.set();
+	}
+
 	SkipList versionHistory;
+	std::unique_ptr<ConflictSetBTree> btreeHistory; // Replaces versionHistory when set
+	std::unique_ptr<ConflictFilter> filter; // Lets reads of ranges not written recently skip the history
 	Key removalKey;
 	Version oldestVersion;
+
+	// Read conflict ranges are checked in up to checkParallelism slices of at least minRangesPerCheck ranges each
+	int checkParallelism;
+	int minRangesPerCheck;
+	Reference<IThreadPool> checkThreads; // checkParallelism - 1 workers, the network thread checks one slice itself
 };
 
-ConflictSet* newConflictSet() {
-	return new ConflictSet;
+void ConflictCheckThread::action(CheckAction& a) {
+	a.cs->detectConflicts(*a.chunk);
+}
+
+ConflictSetType conflictSetTypeFromString(const std::string& name) {
+	if (name == "btree")
+		return ConflictSetType::BTree;
+	if (name != "skiplist")
+		TraceEvent(SevWarnAlways, "UnknownConflictSetType").detail("Type", name);
+	return ConflictSetType::SkipList;
+}
+
+ConflictSet* newConflictSet(ConflictSetType type,
+                            int checkParallelism,
+                            int minRangesPerCheck,
+                            int filterSlots,
+                            int filterPrefixLength) {
+	return new ConflictSet(type, checkParallelism, minRangesPerCheck, filterSlots, filterPrefixLength);
+}
+bool conflictSetHasFilter(ConflictSet const* cs) {
+	return cs->filter != nullptr;
 }
 void clearConflictSet(ConflictSet* cs, Version v) {
-	SkipList(v).swap(cs->versionHistory);
+	if (cs->filter)
+		cs->filter->clear(v);
+	if (cs->btreeHistory)
+		cs->btreeHistory->clear(v);
+	else
+		SkipList(v).swap(cs->versionHistory);
 }
 void destroyConflictSet(ConflictSet* cs) {
 	delete cs;
@@ -806,7 +1328,8 @@ void destroyConflictSet(ConflictSet* cs) {
 ConflictBatch::ConflictBatch(ConflictSet* cs,
                              std::map<int, VectorRef<int>>* conflictingKeyRangeMap,
                              Arena* resolveBatchReplyArena)
-  : cs(cs), transactionCount(0), conflictingKeyRangeMap(conflictingKeyRangeMap),
+  : cs(cs), transactionCount(0), pointsSorted(false), filteredReadConflictRanges(0), checkedReadConflictRanges(0),
+    conflictingKeyRangeMap(conflictingKeyRangeMap),
     resolveBatchReplyArena(resolveBatchReplyArena) {}
 
 ConflictBatch::~ConflictBatch() {}
@@ -831,6 +1354,7 @@ bool ConflictBatch::ignoreWriteSet() const {
 }
 
 void ConflictBatch::addTransaction(const CommitTransactionRef& tr, Version newOldestVersion) {
+	ASSERT(!pointsSorted);
 	const int t = transactionCount++;
 
 	Arena& arena = transactionInfo.arena();
@@ -979,18 +1503,32 @@ void ConflictBatch::GetTooOldTransactions(std::vector<int>& tooOldTransactions)
 	}
 }
 
+void ConflictBatch::sortConflictRanges() {
+	if (pointsSorted)
+		return;
+	double t = timer();
+	sortPoints(points);
+	// Split the read conflict ranges by key so that each slice searches its own part of the history
+	if (readCheckChunkCount() > 1)
+		std::sort(combinedReadConflictRanges.begin(), combinedReadConflictRanges.end());
+	g_sort += timer() - t;
+	pointsSorted = true;
+}
+
+int ConflictBatch::readCheckChunkCount() const {
+	return std::min<int>(cs->checkParallelism, combinedReadConflictRanges.size() / cs->minRangesPerCheck);
+}
+
 void ConflictBatch::detectConflicts(Version now,
                                     Version newOldestVersion,
                                     std::vector<int>& nonConflicting,
                                     std::vector<int>* tooOldTransactions) {
-	double t = timer();
-	sortPoints(points);
-	g_sort += timer() - t;
+	sortConflictRanges();
 
 	transactionConflictStatus = new bool[transactionCount];
 	memset(transactionConflictStatus, 0, transactionCount * sizeof(bool));
 
-	t = timer();
+	double t = timer();
 	checkReadConflictRanges();
 	g_checkRead += timer() - t;
 
@@ -1017,7 +1555,11 @@ void ConflictBatch::detectConflicts(Version now,
 	delete[] transactionConflictStatus;
 
 	t = timer();
-	if (newOldestVersion > cs->oldestVersion) {
+	if (newOldestVersion > cs->oldestVersion && cs->btreeHistory) {
+		cs->oldestVersion = newOldestVersion;
+		cs->removalKey = cs->btreeHistory->removeBefore(
+		    cs->oldestVersion, cs->removalKey, combinedWriteConflictRanges.size() * 3 + 10);
+	} else if (newOldestVersion > cs->oldestVersion) {
 		cs->oldestVersion = newOldestVersion;
 		SkipList::Finger finger;
 		int temp;
@@ -1029,11 +1571,65 @@ void ConflictBatch::detectConflicts(Version now,
 }
 
 void ConflictBatch::checkReadConflictRanges() {
+	if (cs->filter) {
+		// Keep only the ranges the filter cannot rule out, in their original order
+		auto mayConflict = std::stable_partition(
+		    combinedReadConflictRanges.begin(), combinedReadConflictRanges.end(), [&](const ReadConflictRange& r) {
+			    return cs->filter->mayConflict(r.begin, r.end, r.version);
+		    });
+		filteredReadConflictRanges = combinedReadConflictRanges.end() - mayConflict;
+		combinedReadConflictRanges.erase(mayConflict, combinedReadConflictRanges.end());
+	}
+	checkedReadConflictRanges = combinedReadConflictRanges.size();
 	if (combinedReadConflictRanges.empty())
 		return;
 
-	cs->versionHistory.detectConflicts(
-	    &combinedReadConflictRanges[0], combinedReadConflictRanges.size(), transactionConflictStatus);
+	const int count = combinedReadConflictRanges.size();
+	const int chunkCount = readCheckChunkCount();
+	if (chunkCount <= 1) {
+		cs->detectConflicts(&combinedReadConflictRanges[0], count, transactionConflictStatus);
+		return;
+	}
+
+	// The ranges were sorted by sortConflictRanges(). Slices only read the history and report conflicts by range
+	// index; transactionConflictStatus and the reply arena are updated below in range order, so the result does not
+	// depend on how the slices are scheduled.
+	std::vector<ConflictCheckChunk> chunks(chunkCount);
+	for (int c = 0; c < chunkCount; c++) {
+		const int begin = int64_t(count) * c / chunkCount;
+		const int end = int64_t(count) * (c + 1) / chunkCount;
+		ConflictCheckChunk& chunk = chunks[c];
+		chunk.ranges.reserve(end - begin);
+		for (int i = begin; i < end; i++) {
+			const ReadConflictRange& range = combinedReadConflictRanges[i];
+			chunk.ranges.emplace_back(range.begin, range.end, range.version, i - begin, range.indexInTx);
+		}
+		chunk.conflicts.reset(new bool[end - begin]());
+	}
+
+	for (int c = 1; c < chunkCount; c++) {
+		if (cs->checkThreads)
+			cs->checkThreads->post(new ConflictCheckThread::CheckAction(cs, &chunks[c]));
+		else
+			cs->detectConflicts(chunks[c]);
+	}
+	cs->detectConflicts(chunks[0]);
+	for (auto& chunk : chunks)
+		chunk.done.block();
+
+	int i = 0;
+	for (auto& chunk : chunks) {
+		if (chunk.error.present())
+			throw chunk.error.get();
+		for (int j = 0; j < chunk.ranges.size(); j++, i++) {
+			if (!chunk.conflicts[j])
+				continue;
+			const ReadConflictRange& range = combinedReadConflictRanges[i];
+			transactionConflictStatus[range.transaction] = true;
+			if (range.conflictingKeyRange != nullptr)
+				range.conflictingKeyRange->push_back(*range.cKRArena, range.indexInTx);
+		}
+	}
 }
 
 void ConflictBatch::addConflictRanges(Version now,
@@ -1063,7 +1659,18 @@ void ConflictBatch::mergeWriteConflictRanges(Version now) {
 	if (combinedWriteConflictRanges.empty())
 		return;
 
-	addConflictRanges(now, combinedWriteConflictRanges.begin(), combinedWriteConflictRanges.end(), &cs->versionHistory);
+	if (cs->filter) {
+		for (const auto& [begin, end] : combinedWriteConflictRanges)
+			cs->filter->addWrite(begin, end, now);
+	}
+
+	if (cs->btreeHistory) {
+		cs->btreeHistory->addConflictRanges(
+		    &combinedWriteConflictRanges[0], combinedWriteConflictRanges.size(), now);
+	} else {
+		addConflictRanges(
+		    now, combinedWriteConflictRanges.begin(), combinedWriteConflictRanges.end(), &cs->versionHistory);
+	}
 }
 
 void ConflictBatch::combineWriteConflictRanges() {
@@ -1152,45 +1759,22 @@ void operatorLessThanTest() {
 }
 } // namespace
 
-void skipListTest() {
-	printf("Skip list test\n");
-
-	miniConflictSetTest();
-
-	operatorLessThanTest();
-
-	setAffinity(0);
-
-	double start;
-
-	ConflictSet* cs = newConflictSet();
-
-	Arena testDataArena;
-	VectorRef<VectorRef<KeyRangeRef>> testData;
-	const int batches = 500; // deterministicRandom()->randomInt(500, 5000);
-	const int data_per_batch = 5000;
-	testData.resize(testDataArena, batches);
-	std::vector<std::vector<uint8_t>> success(batches);
-	std::vector<std::vector<uint8_t>> success2(batches);
-	for (int i = 0; i < batches; i++) {
-		testData[i].resize(testDataArena, data_per_batch);
-		success[i].assign(data_per_batch, false);
-		success2[i].assign(data_per_batch, false);
-		for (int j = 0; j < data_per_batch; j++) {
-			int key = deterministicRandom()->randomInt(0, 20000000);
-			int key2 = key + 1 + deterministicRandom()->randomInt(0, 10);
-			testData[i][j] = KeyRangeRef(setK(testDataArena, key), setK(testDataArena, key2));
-		}
+// Runs every batch of testData through a new conflict set of the given type, and returns the non-conflicting
+// transactions of each batch.
+static std::vector<std::vector<int>> conflictSetTest(ConflictSetType type,
+                                                     const char* name,
+                                                     const VectorRef<VectorRef<KeyRangeRef>>& testData) {
+	for (auto counter : skc) {
+		counter->clear();
 	}
-	printf("Test data generated: %d batches, %d/batch\n", batches, data_per_batch);
 
-	printf("Running\n");
+	ConflictSet* cs = newConflictSet(type);
 
 	int readCount = 1, writeCount = 1;
 	int cranges = 0, tcount = 0;
 
-	start = timer();
-	std::vector<std::vector<int>> nonConflict(batches);
+	double start = timer();
+	std::vector<std::vector<int>> nonConflict(testData.size());
 	Version version = 0;
 	for (const auto& data : testData) {
 		Arena buf;
@@ -1227,6 +1811,7 @@ void skipListTest() {
 		version++;
 	}
 	double elapsed = timer() - start;
+	printf("%s:\n", name);
 	printf("New conflict set: %0.3f sec\n", elapsed);
 	printf("                  %0.3f Mtransactions/sec\n", tcount / elapsed / 1e6);
 	printf("                  %0.3f Mkeys/sec\n", cranges * 2 / elapsed / 1e6);
@@ -1237,7 +1822,7 @@ void skipListTest() {
 	printf("                  %0.3f Mkeys/sec\n", cranges * 2 / elapsed / 1e6);
 
 	elapsed = g_checkRead.getValue() + g_merge.getValue();
-	printf("Skiplist only:    %0.3f sec\n", elapsed);
+	printf("History only:     %0.3f sec\n", elapsed);
 	printf("                  %0.3f Mtransactions/sec\n", tcount / elapsed / 1e6);
 	printf("                  %0.3f Mkeys/sec\n", cranges * 2 / elapsed / 1e6);
 
@@ -1246,7 +1831,41 @@ void skipListTest() {
 		printf("%20s: %s\n", counter->getMetric().name().c_str(), counter->getMetric().formatted().c_str());
 	}
 
-	printf("%d entries in version history\n", cs->versionHistory.count());
+	printf("%d entries in version history\n",
+	       cs->btreeHistory ? cs->btreeHistory->count() : cs->versionHistory.count());
+	destroyConflictSet(cs);
+	return nonConflict;
+}
+
+void skipListTest() {
+	printf("Skip list test\n");
+
+	miniConflictSetTest();
+
+	operatorLessThanTest();
+
+	setAffinity(0);
+
+	Arena testDataArena;
+	VectorRef<VectorRef<KeyRangeRef>> testData;
+	const int batches = 500; // deterministicRandom()->randomInt(500, 5000);
+	const int data_per_batch = 5000;
+	testData.resize(testDataArena, batches);
+	for (int i = 0; i < batches; i++) {
+		testData[i].resize(testDataArena, data_per_batch);
+		for (int j = 0; j < data_per_batch; j++) {
+			int key = deterministicRandom()->randomInt(0, 20000000);
+			int key2 = key + 1 + deterministicRandom()->randomInt(0, 10);
+			testData[i][j] = KeyRangeRef(setK(testDataArena, key), setK(testDataArena, key2));
+		}
+	}
+	printf("Test data generated: %d batches, %d/batch\n", batches, data_per_batch);
+
+	printf("Running\n");
+
+	auto skipListResults = conflictSetTest(ConflictSetType::SkipList, "SkipList", testData);
+	auto btreeResults = conflictSetTest(ConflictSetType::BTree, "BTree", testData);
+	ASSERT(skipListResults == btreeResults);
 }
 
 TEST_CASE("/fdbserver/skiplist/miniConflictSetCompatibility") {
@@ -1546,3 +2165,93 @@ TEST_CASE("/fdbserver/skiplist/miniConflictSetCompatibility") {
 
 	return Void();
 }
+
+TEST_CASE("/fdbserver/skiplist/btreeMatchesSkipList") {
+	// The others check read conflict ranges in several slices or behind a filter, including filters whose slot count
+	// is not a power of two blocks or whose prefix length disables them
+	ConflictSet* conflictSets[] = { newConflictSet(ConflictSetType::SkipList),
+		                            newConflictSet(ConflictSetType::BTree),
+		                            newConflictSet(ConflictSetType::SkipList, 4, 1),
+		                            newConflictSet(ConflictSetType::BTree, 3, 5),
+		                            newConflictSet(ConflictSetType::SkipList, 1, 1, 64, 9),
+		                            newConflictSet(ConflictSetType::BTree, 2, 1, 8, 12),
+		                            newConflictSet(ConflictSetType::SkipList, 1, 1, 1000, 10),
+		                            newConflictSet(ConflictSetType::BTree, 1, 1, 3, 0) };
+	const int setCount = sizeof(conflictSets) / sizeof(conflictSets[0]);
+	ASSERT(conflictSetHasFilter(conflictSets[6]) && !conflictSetHasFilter(conflictSets[7]));
+
+	// Keys share a prefix and are drawn from a tiny alphabet, so that many of them are prefixes of each other and
+	// the B-tree leaves have to fall back to full key comparisons.
+	auto randomKey = [](Arena& arena) {
+		const char alphabet[] = { '\0', 'a', 'b' };
+		std::string key = "tenant/";
+		int length = deterministicRandom()->randomInt(0, 12);
+		for (int i = 0; i < length; i++) {
+			key.push_back(alphabet[deterministicRandom()->randomInt(0, 3)]);
+		}
+		return StringRef(arena, key);
+	};
+	auto randomRange = [&](Arena& arena) {
+		StringRef a = randomKey(arena);
+		StringRef b = randomKey(arena);
+		if (b < a) {
+			std::swap(a, b);
+		}
+		if (a == b) {
+			b = b.withSuffix("\x00"_sr, arena);
+		}
+		return KeyRangeRef(a, b);
+	};
+
+	Version version = 100;
+	for (int batch = 0; batch < 3000; batch++) {
+		if (batch == 1500) {
+			for (auto cs : conflictSets) {
+				clearConflictSet(cs, version);
+			}
+		}
+
+		Arena arena;
+		std::vector<CommitTransactionRef> trs(deterministicRandom()->randomInt(1, 50));
+		for (auto& tr : trs) {
+			for (int r = deterministicRandom()->randomInt(0, 4); r > 0; r--) {
+				tr.read_conflict_ranges.push_back(arena, randomRange(arena));
+			}
+			for (int r = deterministicRandom()->randomInt(0, 4); r > 0; r--) {
+				tr.write_conflict_ranges.push_back(arena, randomRange(arena));
+			}
+			tr.read_snapshot = version - deterministicRandom()->randomInt(0, 30);
+			tr.report_conflicting_keys = deterministicRandom()->coinflip();
+		}
+
+		const Version newOldestVersion = version - 20;
+		std::vector<int> nonConflicting[setCount], tooOld[setCount];
+		std::map<int, VectorRef<int>> conflictingKeyRanges[setCount];
+		for (int i = 0; i < setCount; i++) {
+			ConflictBatch conflictBatch(conflictSets[i], &conflictingKeyRanges[i], &arena);
+			for (const auto& tr : trs) {
+				conflictBatch.addTransaction(tr, newOldestVersion);
+			}
+			conflictBatch.detectConflicts(version, newOldestVersion, nonConflicting[i], &tooOld[i]);
+		}
+
+		for (int i = 1; i < setCount; i++) {
+			ASSERT(nonConflicting[0] == nonConflicting[i]);
+			ASSERT(tooOld[0] == tooOld[i]);
+			ASSERT(conflictingKeyRanges[0].size() == conflictingKeyRanges[i].size());
+			for (auto& [t, ranges] : conflictingKeyRanges[0]) {
+				VectorRef<int>& other = conflictingKeyRanges[i][t];
+				std::sort(ranges.begin(), ranges.end());
+				std::sort(other.begin(), other.end());
+				ASSERT(ranges.size() == other.size() && std::equal(ranges.begin(), ranges.end(), other.begin()));
+			}
+		}
+
+		version += deterministicRandom()->randomInt(1, 5);
+	}
+
+	for (auto cs : conflictSets) {
+		destroyConflictSet(cs);
+	}
+	return Void();
+}
@@ -0,0 +1,116 @@
+/*
+ * StorageValueCache.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbserver/StorageValueCache.h"
+#include "flow/UnitTest.h"
+
+bool StorageValueCache::get(KeyRef key, Optional<Value>& value) {
+	auto i = index.find(key);
+	if (i == index.end()) {
+		return false;
+	}
+	entries.splice(entries.begin(), entries, i->second);
+	value = i->second->value;
+	return true;
+}
+
+int StorageValueCache::add(KeyRef key, Optional<Value> const& value, uint64_t readEpoch) {
+	if (!enabled() || readEpoch != epoch) {
+		return 0;
+	}
+	auto i = index.find(key);
+	if (i != index.end()) {
+		erase(i);
+	}
+	// Copy the value out of the arena of the read, which may hold much more
+	entries.push_front(Entry{ Key(key), value.present() ? Value(value.get().contents()) : Optional<Value>() });
+	index[entries.front().key] = entries.begin();
+	bytes += entryBytes(entries.front());
+
+	int evicted = 0;
+	while (bytes > maxBytes) {
+		erase(index.find(entries.back().key));
+		evicted++;
+	}
+	return evicted;
+}
+
+void StorageValueCache::invalidate(KeyRangeRef keys) {
+	epoch++;
+	for (auto i = index.lower_bound(keys.begin); i != index.end() && i->first < keys.end;) {
+		erase(i++);
+	}
+}
+
+void StorageValueCache::clear() {
+	epoch++;
+	index.clear();
+	entries.clear();
+	bytes = 0;
+}
+
+void StorageValueCache::erase(std::map<KeyRef, std::list<Entry>::iterator>::iterator i) {
+	auto e = i->second;
+	bytes -= entryBytes(*e);
+	index.erase(i);
+	entries.erase(e);
+}
+
+TEST_CASE("/fdbserver/StorageValueCache/invalidate") {
+	StorageValueCache cache(1000);
+	Optional<Value> value;
+
+	ASSERT(!cache.get("a"_sr, value));
+	cache.add("a"_sr, Value("1"_sr), cache.getEpoch());
+	cache.add("b"_sr, Optional<Value>(), cache.getEpoch());
+	cache.add("c"_sr, Value("3"_sr), cache.getEpoch());
+	ASSERT(cache.get("a"_sr, value) && value.get() == "1"_sr);
+	ASSERT(cache.get("b"_sr, value) && !value.present());
+
+	// Reads that overlap an invalidation are not cached
+	const uint64_t epoch = cache.getEpoch();
+	cache.invalidate(KeyRangeRef("b"_sr, "c"_sr));
+	cache.add("d"_sr, Value("4"_sr), epoch);
+	ASSERT(!cache.get("b"_sr, value));
+	ASSERT(!cache.get("d"_sr, value));
+	ASSERT(cache.get("c"_sr, value) && value.get() == "3"_sr);
+
+	cache.invalidate("a"_sr);
+	ASSERT(!cache.get("a"_sr, value));
+	cache.add("a"_sr, Value("5"_sr), cache.getEpoch());
+	ASSERT(cache.get("a"_sr, value) && value.get() == "5"_sr);
+
+	// The least recently used keys are evicted first
+	const Value large(std::string(300, 'x'));
+	int evicted = 0;
+	for (int i = 0; i < 3; i++) {
+		ASSERT(cache.get("a"_sr, value));
+		evicted += cache.add(Key(format("large%d", i)), large, cache.getEpoch());
+	}
+	ASSERT(evicted > 0);
+	ASSERT(cache.getBytes() <= 1000);
+	ASSERT(!cache.get("c"_sr, value));
+	ASSERT(cache.get("a"_sr, value) && value.get() == "5"_sr);
+
+	cache.clear();
+	ASSERT_EQ(cache.getBytes(), 0);
+	ASSERT(!cache.get("a"_sr, value));
+	return Void();
+}
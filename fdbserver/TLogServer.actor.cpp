@@ -18,6 +18,7 @@
  * limitations under the License.
  */
 
+#include "flow/CompressionUtils.h"
 #include "flow/Hash3.h"
 #include "flow/UnitTest.h"
 #include "fdbclient/NativeAPI.actor.h"
@@ -102,12 +103,16 @@ struct TLogData;
 
 struct TLogQueue final : public IClosable {
 public:
-	TLogQueue(IDiskQueue* queue, UID dbgid) : queue(queue), dbgid(dbgid) {}
+	TLogQueue(IDiskQueue* queue, UID dbgid)
+	  : queue(queue), dbgid(dbgid), compressionFilter(compressionFilterFromKnobs(dbgid)) {}
 
 	// Each packet in the queue is
 	//    uint32_t payloadSize
-	//    uint8_t payload[payloadSize]  (begins with uint64_t protocolVersion via IncludeVersion)
+	//    uint8_t payload[payloadSize]
 	//    uint8_t validFlag
+	// With validFlag PLAIN_PACKET the payload begins with uint64_t protocolVersion via IncludeVersion. With
+	// COMPRESSED_PACKET it is a uint8_t CompressionFilter followed by such a payload compressed with that filter.
+	enum : uint8_t { PLAIN_PACKET = 1, COMPRESSED_PACKET = 2 };
 
 	// TLogQueue is a durable queue of TLogQueueEntry objects with an interface similar to IDiskQueue
 
@@ -124,9 +129,18 @@ public:
 
 	template <class T>
 	void push(T const& qe, Reference<LogData> logData);
+	template <class T>
+	static Standalone<StringRef> encodePacket(T const& qe, CompressionFilter filter);
+	// Returns the entry in the payload of a packet with the given validFlag. The entry may reference arena.
+	static TLogQueueEntry decodePayload(StringRef payload, uint8_t validFlag, Arena arena);
 	void forgetBefore(Version upToVersion, Reference<LogData> logData);
 	void pop(IDiskQueue::location upToLocation);
-	Future<Void> commit() { return queue->commit(); }
+	Future<Void> commit() {
+		uncommittedEntries = 0;
+		return queue->commit();
+	}
+	// Returns the number of entries pushed since the last commit, by any generation
+	int getUncommittedEntries() const { return uncommittedEntries; }
 
 	// Implements IClosable
 	Future<Void> getError() const override { return queue->getError(); }
@@ -143,6 +157,19 @@ public:
 private:
 	IDiskQueue* queue;
 	UID dbgid;
+	CompressionFilter compressionFilter;
+	int uncommittedEntries = 0;
+
+	static CompressionFilter compressionFilterFromKnobs(UID dbgid) {
+		const CompressionFilter filter =
+		    CompressionUtils::fromFilterString(SERVER_KNOBS->TLOG_QUEUE_COMPRESSION_FILTER);
+		if (!CompressionUtils::supportedFilters.count(filter)) {
+			TraceEvent(SevWarnAlways, "TLogQueueCompressionNotSupported", dbgid)
+			    .detail("Filter", SERVER_KNOBS->TLOG_QUEUE_COMPRESSION_FILTER);
+			return CompressionFilter::NONE;
+		}
+		return filter;
+	}
 
 	void updateVersionSizes(const TLogQueueEntry& result,
 	                        TLogData* tLog,
@@ -178,10 +205,7 @@ private:
 			}
 
 			if (e[payloadSize]) {
-				ASSERT(e[payloadSize] == 1);
-				Arena a = e.arena();
-				ArenaReader ar(a, e.substr(0, payloadSize), IncludeVersion());
-				ar >> result;
+				result = decodePayload(e.substr(0, payloadSize), e[payloadSize], e.arena());
 				const IDiskQueue::location endloc = self->queue->getNextReadLocation();
 				self->updateVersionSizes(result, tLog, startloc, endloc);
 				return result;
@@ -283,6 +307,23 @@ struct SpilledData {
 	uint32_t mutationBytes = 0;
 };
 
+// The messages of a commit for each tag, as runs of consecutive messages in the commit, so that the messages of a
+// spilled commit can be copied for each peeked tag without parsing the commit again.
+struct CommitTagIndex : ReferenceCounted<CommitTagIndex> {
+	struct Run {
+		Tag tag;
+		uint32_t offset;
+		uint32_t length;
+	};
+	std::vector<Run> runs; // Sorted by tag, then offset
+
+	std::pair<std::vector<Run>::const_iterator, std::vector<Run>::const_iterator> runsForTag(Tag tag) const {
+		return std::equal_range(runs.begin(), runs.end(), Run{ tag, 0, 0 }, [](const Run& l, const Run& r) {
+			return l.tag < r.tag;
+		});
+	}
+};
+
 struct TLogData : NonCopyable {
 	AsyncTrigger newLogData;
 	// A process has only 1 SharedTLog, which holds data for multiple logs, so that it obeys its assigned memory limit.
@@ -368,6 +409,9 @@ struct TLogData : NonCopyable {
 	// and ends when the data is flushed and durable.
 	Reference<Histogram> timeUntilDurableDist;
 
+	// Distribution of the number of TLogQueue entries, of all generations, made durable by each DiskQueue commit.
+	Reference<Histogram> queueCommitBatchDist;
+
 	// Controls whether the health monitoring running in this TLog force checking any other processes are degraded.
 	Reference<AsyncVar<bool>> enablePrimaryTxnSystemHealthCheck;
 
@@ -390,6 +434,8 @@ struct TLogData : NonCopyable {
 	    commitLatencyDist(Histogram::getHistogram("tLog"_sr, "commit"_sr, Histogram::Unit::milliseconds)),
 	    queueWaitLatencyDist(Histogram::getHistogram("tLog"_sr, "QueueWait"_sr, Histogram::Unit::milliseconds)),
 	    timeUntilDurableDist(Histogram::getHistogram("tLog"_sr, "TimeUntilDurable"_sr, Histogram::Unit::milliseconds)),
+	    queueCommitBatchDist(
+	        Histogram::getHistogram("tLog"_sr, "QueueCommitBatch"_sr, Histogram::Unit::countLinear, 0, 256)),
 	    enablePrimaryTxnSystemHealthCheck(enablePrimaryTxnSystemHealthCheck) {
 		cx = openDBOnServer(dbInfo, TaskPriority::DefaultEndpoint, LockAware::True);
 	}
@@ -481,6 +527,9 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 	    versionLocation; // For the version of each entry that was push()ed, the [start, end) location of the serialized
 	                     // bytes
 
+	// The indexes of the spilled commits peeked most recently, see TLOG_PEEK_SPILLED_COMMIT_INDEXES
+	std::map<Version, Reference<CommitTagIndex>> spilledCommitIndexes;
+
 	/*
 	Popped version tracking contract needed by log system to implement ILogCursor::popped():
 
@@ -786,17 +835,49 @@ struct LogData : NonCopyable, public ReferenceCounted<LogData> {
 };
 
 template <class T>
-void TLogQueue::push(T const& qe, Reference<LogData> logData) {
+Standalone<StringRef> TLogQueue::encodePacket(T const& qe, CompressionFilter filter) {
 	BinaryWriter wr(Unversioned()); // outer framing is not versioned
 	wr << uint32_t(0);
 	IncludeVersion(ProtocolVersion::withTLogQueueEntryRef()).write(wr); // payload is versioned
 	wr << qe;
-	wr << uint8_t(1);
-	*(uint32_t*)wr.getData() = wr.getLength() - sizeof(uint32_t) - sizeof(uint8_t);
+	const int payloadSize = wr.getLength() - sizeof(uint32_t);
+	if (filter != CompressionFilter::NONE && payloadSize >= SERVER_KNOBS->TLOG_QUEUE_COMPRESSION_MIN_BYTES) {
+		Arena arena;
+		const StringRef compressed = CompressionUtils::compress(
+		    filter, StringRef((const uint8_t*)wr.getData() + sizeof(uint32_t), payloadSize), arena);
+		// Entries which do not compress are kept as they are
+		if (compressed.size() + 1 < payloadSize) {
+			BinaryWriter cwr(Unversioned());
+			cwr << uint32_t(compressed.size() + sizeof(uint8_t)) << uint8_t(filter);
+			cwr.serializeBytes(compressed);
+			cwr << uint8_t(COMPRESSED_PACKET);
+			return cwr.toValue();
+		}
+	}
+	wr << uint8_t(PLAIN_PACKET);
+	*(uint32_t*)wr.getData() = payloadSize;
+	return wr.toValue();
+}
+
+TLogQueueEntry TLogQueue::decodePayload(StringRef payload, uint8_t validFlag, Arena arena) {
+	if (validFlag == COMPRESSED_PACKET) {
+		const CompressionFilter filter = static_cast<CompressionFilter>(payload[0]);
+		payload = CompressionUtils::decompress(filter, payload.substr(1), arena);
+	} else {
+		ASSERT(validFlag == PLAIN_PACKET);
+	}
+	TLogQueueEntry entry;
+	ArenaReader ar(arena, payload, IncludeVersion());
+	ar >> entry;
+	return entry;
+}
+
+template <class T>
+void TLogQueue::push(T const& qe, Reference<LogData> logData) {
 	const IDiskQueue::location startloc = queue->getNextPushLocation();
 	// FIXME: push shouldn't return anything.  We should call getNextPushLocation() again.
-	const IDiskQueue::location endloc = queue->push(wr.toValue());
-	//TraceEvent("TLogQueueVersionWritten", dbgid).detail("Size", wr.getLength() - sizeof(uint32_t) - sizeof(uint8_t)).detail("Loc", loc);
+	const IDiskQueue::location endloc = queue->push(encodePacket(qe, compressionFilter));
+	++uncommittedEntries;
 	logData->versionLocation[qe.version] = std::make_pair(startloc, endloc);
 }
 
@@ -1750,6 +1831,68 @@ ACTOR Future<std::vector<StringRef>> parseMessagesForTag(StringRef commitBlob, T
 	return relevantMessages;
 }
 
+// Indexes the messages of commitBlob by the tags they are for, with the log router tags reduced to logRouters tags like
+// in parseMessagesForTag().
+ACTOR Future<Reference<CommitTagIndex>> indexMessagesByTag(StringRef commitBlob, int logRouters) {
+	state Reference<CommitTagIndex> index = makeReference<CommitTagIndex>();
+	state BinaryReader rd(commitBlob, AssumeVersion(g_network->protocolVersion()));
+	while (!rd.empty()) {
+		TagsAndMessage tagsAndMessage;
+		tagsAndMessage.loadFromArena(&rd, nullptr);
+		const StringRef rawMessage = tagsAndMessage.getRawMessage();
+		const uint32_t offset = rawMessage.begin() - commitBlob.begin();
+		const int firstRun = index->runs.size();
+		for (Tag t : tagsAndMessage.tags) {
+			if (t.locality == tagLocalityLogRouter && logRouters > 0) {
+				t.id = t.id % logRouters;
+			}
+			// A message is sent once to each tag, even if several of its tags were reduced to it
+			bool duplicate = false;
+			for (int i = firstRun; i < index->runs.size(); i++) {
+				duplicate = duplicate || index->runs[i].tag == t;
+			}
+			if (!duplicate) {
+				index->runs.push_back(CommitTagIndex::Run{ t, offset, static_cast<uint32_t>(rawMessage.size()) });
+			}
+		}
+		wait(yield());
+	}
+
+	std::stable_sort(index->runs.begin(), index->runs.end(), [](const auto& l, const auto& r) { return l.tag < r.tag; });
+	// Merge the runs of consecutive messages
+	int merged = 0;
+	for (const auto& run : index->runs) {
+		if (merged > 0 && index->runs[merged - 1].tag == run.tag &&
+		    index->runs[merged - 1].offset + index->runs[merged - 1].length == run.offset) {
+			index->runs[merged - 1].length += run.length;
+		} else {
+			index->runs[merged++] = run;
+		}
+	}
+	index->runs.resize(merged);
+	return index;
+}
+
+// Returns the index of the messages of the spilled commit at version, building it the first time the commit is peeked.
+// It is kept for the peeks of other tags until TLOG_PEEK_SPILLED_COMMIT_INDEXES more recently indexed commits evict it.
+ACTOR Future<Reference<CommitTagIndex>> getSpilledCommitIndex(Reference<LogData> logData,
+                                                              Version version,
+                                                              StringRef commitBlob) {
+	auto it = logData->spilledCommitIndexes.find(version);
+	if (it != logData->spilledCommitIndexes.end()) {
+		return it->second;
+	}
+
+	Reference<CommitTagIndex> index = wait(indexMessagesByTag(commitBlob, logData->logRouterTags));
+	logData->spilledCommitIndexes[version] = index;
+	while (logData->spilledCommitIndexes.size() > SERVER_KNOBS->TLOG_PEEK_SPILLED_COMMIT_INDEXES) {
+		// Evict the oldest commit, peeks move towards newer ones
+		auto oldest = logData->spilledCommitIndexes.begin();
+		logData->spilledCommitIndexes.erase(oldest->first == version ? std::next(oldest) : oldest);
+	}
+	return index;
+}
+
 // Common logics to peek TLog and create TLogPeekReply that serves both streaming peek or normal peek request
 ACTOR template <typename PromiseType>
 Future<Void> tLogPeekMessages(PromiseType replyPromise,
@@ -1761,7 +1904,8 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
                               bool reqOnlySpilled = false,
                               Optional<std::pair<UID, int>> reqSequence = Optional<std::pair<UID, int>>(),
                               Optional<Version> reqEnd = Optional<Version>(),
-                              Optional<bool> reqReturnEmptyIfStopped = Optional<bool>()) {
+                              Optional<bool> reqReturnEmptyIfStopped = Optional<bool>(),
+                              int reqSpilledBytes = SERVER_KNOBS->DESIRED_TOTAL_BYTES) {
 	state BinaryWriter messages(Unversioned());
 	state BinaryWriter messages2(Unversioned());
 	state int sequence = -1;
@@ -2006,8 +2150,8 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 				    KeyRangeRef(
 				        persistTagMessagesKey(logData->logId, reqTag, reqBegin),
 				        persistTagMessagesKey(logData->logId, reqTag, logData->persistentDataDurableVersion + 1)),
-				    SERVER_KNOBS->DESIRED_TOTAL_BYTES,
-				    SERVER_KNOBS->DESIRED_TOTAL_BYTES));
+				    reqSpilledBytes,
+				    reqSpilledBytes));
 
 				for (auto& kv : kvs) {
 					auto ver = decodeTagMessagesKey(kv.key);
@@ -2015,7 +2159,7 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 					messages.serializeBytes(kv.value);
 				}
 
-				if (kvs.expectedSize() >= SERVER_KNOBS->DESIRED_TOTAL_BYTES) {
+				if (kvs.expectedSize() >= reqSpilledBytes) {
 					endVersion = decodeTagMessagesKey(kvs.end()[-1].key) + 1;
 					onlySpilled = true;
 				} else {
@@ -2042,7 +2186,7 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 					BinaryReader r(kv.value, AssumeVersion(logData->protocolVersion));
 					r >> spilledData;
 					for (const SpilledData& sd : spilledData) {
-						if (mutationBytes >= SERVER_KNOBS->DESIRED_TOTAL_BYTES) {
+						if (mutationBytes >= reqSpilledBytes) {
 							earlyEnd = true;
 							break;
 						}
@@ -2076,24 +2220,34 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 					if (index >= messageReads.size())
 						break;
 					Standalone<StringRef> queueEntryData = messageReads[index].get();
-					uint8_t valid;
 					const uint32_t length = *(uint32_t*)queueEntryData.begin();
 					queueEntryData = queueEntryData.substr(4, queueEntryData.size() - 4);
-					BinaryReader rd(queueEntryData, IncludeVersion());
-					state TLogQueueEntry entry;
-					rd >> entry >> valid;
-					ASSERT(valid == 0x01);
-					ASSERT(length + sizeof(valid) == queueEntryData.size());
+					ASSERT(length + sizeof(uint8_t) == queueEntryData.size());
+					state TLogQueueEntry entry = TLogQueue::decodePayload(
+					    queueEntryData.substr(0, length), queueEntryData[length], queueEntryData.arena());
 
 					messages << VERSION_HEADER << entry.version;
 
-					std::vector<StringRef> rawMessages =
-					    wait(parseMessagesForTag(entry.messages, reqTag, logData->logRouterTags));
-					for (const StringRef& msg : rawMessages) {
-						messages.serializeBytes(msg);
-						DEBUG_TAGS_AND_MESSAGE("TLogPeekFromDisk", entry.version, msg, logData->logId)
-						    .detail("DebugID", self->dbgid)
-						    .detail("PeekTag", reqTag);
+					if (SERVER_KNOBS->TLOG_PEEK_SPILLED_COMMIT_INDEXES > 0) {
+						Reference<CommitTagIndex> index =
+						    wait(getSpilledCommitIndex(logData, entry.version, entry.messages));
+						auto [run, end] = index->runsForTag(reqTag);
+						for (; run != end; ++run) {
+							const StringRef msgs = entry.messages.substr(run->offset, run->length);
+							messages.serializeBytes(msgs);
+							DEBUG_TAGS_AND_MESSAGE("TLogPeekFromDisk", entry.version, msgs, logData->logId)
+							    .detail("DebugID", self->dbgid)
+							    .detail("PeekTag", reqTag);
+						}
+					} else {
+						std::vector<StringRef> rawMessages =
+						    wait(parseMessagesForTag(entry.messages, reqTag, logData->logRouterTags));
+						for (const StringRef& msg : rawMessages) {
+							messages.serializeBytes(msg);
+							DEBUG_TAGS_AND_MESSAGE("TLogPeekFromDisk", entry.version, msg, logData->logId)
+							    .detail("DebugID", self->dbgid)
+							    .detail("PeekTag", reqTag);
+						}
 					}
 
 					lastRefMessageVersion = entry.version;
@@ -2211,18 +2365,35 @@ Future<Void> tLogPeekMessages(PromiseType replyPromise,
 	return Void();
 }
 
+// The bytes of replies a peek stream may have unacknowledged: as many as its consumer asked for, up to
+// MAXIMUM_PEEK_BYTES and, if TLOG_PEEK_STREAM_MEMORY_BYTES is set, to an equal share of it among the active streams.
+int64_t peekStreamByteLimit(TLogData const* self, int limitBytes) {
+	int64_t limit = std::min(SERVER_KNOBS->MAXIMUM_PEEK_BYTES, limitBytes);
+	if (SERVER_KNOBS->TLOG_PEEK_STREAM_MEMORY_BYTES > 0) {
+		const int64_t share = SERVER_KNOBS->TLOG_PEEK_STREAM_MEMORY_BYTES / std::max(self->activePeekStreams, 1);
+		limit = std::min(limit, std::max<int64_t>(share, SERVER_KNOBS->DESIRED_TOTAL_BYTES));
+	}
+	return std::max<int64_t>(limit, 1);
+}
+
 // This actor keep pushing TLogPeekStreamReply until it's removed from the cluster or should recover
 ACTOR Future<Void> tLogPeekStream(TLogData* self, TLogPeekStreamRequest req, Reference<LogData> logData) {
 	self->activePeekStreams++;
 
 	state Version begin = req.begin;
 	state bool onlySpilled = false;
-	req.reply.setByteLimit(std::min(SERVER_KNOBS->MAXIMUM_PEEK_BYTES, req.limitBytes));
 	loop {
 		state TLogPeekStreamReply reply;
 		state Promise<TLogPeekReply> promise;
 		state Future<TLogPeekReply> future(promise.getFuture());
 		try {
+			// The window is recomputed for every reply since the number of active streams changes. With prefetching,
+			// a consumer that is catching up on spilled data gets all of the window it has not used yet in one read.
+			req.reply.setByteLimit(peekStreamByteLimit(self, req.limitBytes));
+			const int spilledBytes =
+			    SERVER_KNOBS->TLOG_PEEK_STREAM_PREFETCH
+			        ? std::max<int64_t>(SERVER_KNOBS->DESIRED_TOTAL_BYTES, req.reply.availableBytes())
+			        : SERVER_KNOBS->DESIRED_TOTAL_BYTES;
 			wait(req.reply.onReady() && store(reply.rep, future) &&
 			     tLogPeekMessages(promise,
 			                      self,
@@ -2233,7 +2404,8 @@ ACTOR Future<Void> tLogPeekStream(TLogData* self, TLogPeekStreamRequest req, Ref
 			                      onlySpilled,
 			                      Optional<std::pair<UID, int>>(),
 			                      req.end,
-			                      req.returnEmptyIfStopped));
+			                      req.returnEmptyIfStopped,
+			                      spilledBytes));
 
 			reply.rep.begin = begin;
 			req.reply.send(reply);
@@ -2272,6 +2444,7 @@ ACTOR Future<Void> doQueueCommit(TLogData* self,
 	logData->queueCommittingVersion = ver;
 
 	g_network->setCurrentTask(TaskPriority::TLogCommitReply);
+	self->queueCommitBatchDist->sampleRecordCounter(self->persistentQueue->getUncommittedEntries());
 	Future<Void> c = self->persistentQueue->commit();
 	self->diskQueueCommitBytes = 0;
 	self->largeDiskQueueCommitBytes.set(false);
@@ -2380,6 +2553,11 @@ ACTOR Future<Void> commitQueue(TLogData* self) {
 						wait(self->queueCommitEnd.whenAtLeast(self->queueCommitBegin) ||
 						     self->largeDiskQueueCommitBytes.onChange());
 					}
+					// Let the pushes of this and other generations arriving shortly share the commit
+					if (SERVER_KNOBS->TLOG_QUEUE_COMMIT_COALESCE_DELAY > 0 && !self->largeDiskQueueCommitBytes.get()) {
+						wait(delay(SERVER_KNOBS->TLOG_QUEUE_COMMIT_COALESCE_DELAY, TaskPriority::TLogCommit) ||
+						     self->largeDiskQueueCommitBytes.onChange());
+					}
 					if (logData->queueCommittedVersion.get() == std::numeric_limits<Version>::max()) {
 						break;
 					}
@@ -3910,3 +4088,131 @@ TEST_CASE("Lfdbserver/tlogserver/VersionMessagesOverheadFactor") {
 
 	return Void();
 }
+
+namespace {
+
+// The messages of a TLogCommitRequest alone, to check how they are serialized
+struct TestCommitMessages {
+	constexpr static FileIdentifier file_identifier = 9153367;
+	StringRef messages;
+	VectorRef<StringRef> pieces;
+	Arena arena;
+
+	template <class Ar>
+	void serialize(Ar& ar) {
+		auto wrappedMessages = TLogCommitMessages(messages, pieces);
+		serializer(ar, wrappedMessages, arena);
+	}
+};
+
+} // namespace
+
+TEST_CASE("/fdbserver/tlogserver/CommitMessagePieces") {
+	Standalone<StringRef> expected = "header:value:checksum"_sr;
+
+	TestCommitMessages contiguous;
+	contiguous.messages = expected;
+	Standalone<StringRef> contiguousBytes = ObjectWriter::toValue(contiguous, Unversioned());
+
+	Standalone<VectorRef<StringRef>> pieces;
+	pieces.push_back(pieces.arena(), "header:"_sr);
+	pieces.push_back(pieces.arena(), "value"_sr);
+	pieces.push_back(pieces.arena(), ":checksum"_sr);
+	TestCommitMessages split;
+	split.pieces = pieces;
+	Standalone<StringRef> splitBytes = ObjectWriter::toValue(split, Unversioned());
+
+	// The pieces are sent exactly like the messages they make up
+	ASSERT(splitBytes == contiguousBytes);
+	TestCommitMessages received = ObjectReader::fromStringRef<TestCommitMessages>(splitBytes, Unversioned());
+	ASSERT(received.messages == expected);
+	ASSERT(received.pieces.empty());
+
+	return Void();
+}
+
+TEST_CASE("/fdbserver/tlogserver/CommitTagIndex") {
+	state int logRouters = deterministicRandom()->randomInt(1, 4);
+	state std::vector<Tag> tags;
+	for (int i = 0; i < 4; i++) {
+		tags.emplace_back(deterministicRandom()->randomInt(0, 3), i);
+	}
+	for (int i = 0; i < 6; i++) {
+		tags.emplace_back(tagLocalityLogRouter, i);
+	}
+
+	// Messages with random tags, in the format of LogPushData
+	BinaryWriter wr(AssumeVersion(g_network->protocolVersion()));
+	const int messageCount = deterministicRandom()->randomInt(0, 200);
+	for (int i = 0; i < messageCount; i++) {
+		std::vector<Tag> messageTags;
+		const int tagCount = deterministicRandom()->randomInt(1, 4);
+		for (int t = 0; t < tagCount; t++) {
+			messageTags.push_back(deterministicRandom()->randomChoice(tags));
+		}
+		const int payloadLength = deterministicRandom()->randomInt(1, 50);
+		wr << int32_t(TagsAndMessage::getHeaderSize(tagCount) - sizeof(int32_t) + payloadLength) << uint32_t(i)
+		   << uint16_t(tagCount);
+		for (const Tag& tag : messageTags) {
+			wr << tag;
+		}
+		wr.serializeBytes(deterministicRandom()->randomAlphaNumeric(payloadLength));
+	}
+	state Standalone<StringRef> commitBlob = wr.toValue();
+
+	state Reference<CommitTagIndex> index = wait(indexMessagesByTag(commitBlob, logRouters));
+	state int tagIndex = 0;
+	for (tagIndex = 0; tagIndex < tags.size(); tagIndex++) {
+		state Tag tag = tags[tagIndex];
+		if (tag.locality == tagLocalityLogRouter && tag.id >= logRouters) {
+			continue;
+		}
+		std::vector<StringRef> expected = wait(parseMessagesForTag(commitBlob, tag, logRouters));
+		std::string expectedBytes;
+		for (const StringRef& message : expected) {
+			expectedBytes += message.toString();
+		}
+		std::string indexedBytes;
+		auto [run, end] = index->runsForTag(tag);
+		for (; run != end; ++run) {
+			indexedBytes += commitBlob.substr(run->offset, run->length).toString();
+		}
+		ASSERT(indexedBytes == expectedBytes);
+	}
+	return Void();
+}
+
+TEST_CASE("/fdbserver/tlogserver/QueuePacketCompression") {
+	TLogQueueEntryRef qe;
+	qe.id = deterministicRandom()->randomUniqueID();
+	qe.version = deterministicRandom()->randomInt64(0, 1e12);
+	qe.knownCommittedVersion = qe.version - deterministicRandom()->randomInt(0, 1e6);
+	// Repetitive messages, as tags and mutations are
+	const std::string messages =
+	    std::string(deterministicRandom()->randomInt(0, 100), 'a') +
+	    std::string(deterministicRandom()->randomInt(0, 20000), 'b') + deterministicRandom()->randomAlphaNumeric(100);
+	qe.messages = StringRef(messages);
+
+	int plainSize = 0;
+	for (const CompressionFilter filter : CompressionUtils::supportedFilters) {
+		const Standalone<StringRef> packet = TLogQueue::encodePacket(qe, filter);
+		const uint32_t payloadSize = *(const uint32_t*)packet.begin();
+		ASSERT_EQ(packet.size(), sizeof(uint32_t) + payloadSize + sizeof(uint8_t));
+		const uint8_t validFlag = packet[packet.size() - 1];
+		if (filter == CompressionFilter::NONE) {
+			ASSERT_EQ(validFlag, TLogQueue::PLAIN_PACKET);
+			plainSize = packet.size();
+		} else if (validFlag == TLogQueue::COMPRESSED_PACKET) {
+			ASSERT_LT(payloadSize, messages.size());
+		}
+
+		const TLogQueueEntry entry =
+		    TLogQueue::decodePayload(packet.substr(sizeof(uint32_t), payloadSize), validFlag, packet.arena());
+		ASSERT(entry.id == qe.id);
+		ASSERT_EQ(entry.version, qe.version);
+		ASSERT_EQ(entry.knownCommittedVersion, qe.knownCommittedVersion);
+		ASSERT(entry.messages == qe.messages);
+	}
+	ASSERT_GT(plainSize, messages.size());
+	return Void();
+}
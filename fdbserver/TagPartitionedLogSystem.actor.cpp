@@ -669,30 +669,39 @@ Future<Version> TagPartitionedLogSystem::push(const ILogSystem::PushVersionSet&
 
 		std::vector<Future<Void>> tLogCommitResults;
 		for (size_t loc = 0; loc < it->logServers.size(); loc++) {
-			Standalone<StringRef> msg = data.getMessages(location);
+			const auto& interface = it->logServers[loc]->get().interf();
+			// Messages referencing mutation values in the arenas of commit requests are serialized straight from
+			// their pieces, unless the request is handed to a TLog of this process as it is
+			Standalone<StringRef> msg;
+			Standalone<VectorRef<StringRef>> msgPieces;
+			if (data.hasReferencedValues(location) && interface.commit.isRemoteEndpoint()) {
+				msgPieces = data.getMessagePieces(location);
+			} else {
+				msg = data.getMessages(location);
+			}
 			data.recordEmptyMessage(location, msg);
 			if (SERVER_KNOBS->ENABLE_VERSION_VECTOR_TLOG_UNICAST) {
 				if (tpcvMap.get().contains(location)) {
 					prevVersion = tpcvMap.get()[location];
 				} else {
-					ASSERT(!msg.size());
+					ASSERT(!msg.size() && msgPieces.empty());
 					location++;
 					continue;
 				}
 			}
 
-			const auto& interface = it->logServers[loc]->get().interf();
-			const auto request = TLogCommitRequest(spanContext,
-			                                       msg.arena(),
-			                                       prevVersion,
-			                                       versionSet.version,
-			                                       versionSet.knownCommittedVersion,
-			                                       versionSet.minKnownCommittedVersion,
-			                                       seqPrevVersion,
-			                                       msg,
-			                                       tLogCount[logGroupLocal],
-			                                       tLogLocIds[logGroupLocal],
-			                                       debugID);
+			auto request = TLogCommitRequest(spanContext,
+			                                 msgPieces.empty() ? msg.arena() : msgPieces.arena(),
+			                                 prevVersion,
+			                                 versionSet.version,
+			                                 versionSet.knownCommittedVersion,
+			                                 versionSet.minKnownCommittedVersion,
+			                                 seqPrevVersion,
+			                                 msg,
+			                                 tLogCount[logGroupLocal],
+			                                 tLogLocIds[logGroupLocal],
+			                                 debugID);
+			request.messagePieces = msgPieces;
 			auto tLogReply = recordPushMetrics(it->connectionResetTrackers[loc],
 			                                   it->tlogPushDistTrackers[loc],
 			                                   interface.address(),
@@ -22,14 +22,28 @@
 #define CONFLICTSET_H
 #pragma once
 
+#include <string>
 #include <utility>
 #include <vector>
 
 #include "fdbclient/CommitTransaction.h"
 #include "fdbserver/ResolverBug.h"
 
+// The data structure backing the version history of a ConflictSet, see RESOLVER_CONFLICT_SET_TYPE
+enum class ConflictSetType { SkipList, BTree };
+ConflictSetType conflictSetTypeFromString(const std::string& name);
+
 struct ConflictSet;
-ConflictSet* newConflictSet();
+// Read conflict checks of a batch are split across up to checkParallelism threads, in slices of at least
+// minRangesPerCheck ranges, see RESOLVER_CONFLICT_CHECK_THREADS. A filter with filterSlots slots lets reads of key
+// ranges that were not written recently skip the version history, see RESOLVER_CONFLICT_FILTER_SLOTS. The filter is
+// only built if filterSlots and filterPrefixLength are both positive.
+ConflictSet* newConflictSet(ConflictSetType type = ConflictSetType::SkipList,
+                            int checkParallelism = 1,
+                            int minRangesPerCheck = 1,
+                            int filterSlots = 0,
+                            int filterPrefixLength = 1);
+bool conflictSetHasFilter(ConflictSet const*);
 void clearConflictSet(ConflictSet*, Version);
 void destroyConflictSet(ConflictSet*);
 
@@ -48,17 +62,26 @@ struct ConflictBatch {
 	};
 
 	void addTransaction(const CommitTransactionRef& transaction, Version newOldestVersion);
+	// Sorts the conflict ranges added so far. This does not look at the conflict set, so it can be done while an
+	// earlier batch is still being resolved; otherwise detectConflicts() does it.
+	void sortConflictRanges();
 	void detectConflicts(Version now,
 	                     Version newOldestVersion,
 	                     std::vector<int>& nonConflicting,
 	                     std::vector<int>* tooOldTransactions = nullptr);
 	void GetTooOldTransactions(std::vector<int>& tooOldTransactions);
 
+	// Read conflict ranges detectConflicts() ruled out with the filter of the ConflictSet, and those it checked
+	// against the version history
+	int filteredReadConflictRanges;
+	int checkedReadConflictRanges;
+
 private:
 	ConflictSet* cs;
 	Standalone<VectorRef<struct TransactionInfo*>> transactionInfo;
 	std::vector<struct KeyInfo> points;
 	int transactionCount;
+	bool pointsSorted;
 	std::vector<std::pair<StringRef, StringRef>> combinedWriteConflictRanges;
 	std::vector<struct ReadConflictRange> combinedReadConflictRanges;
 	bool* transactionConflictStatus;
@@ -74,6 +97,7 @@ private:
 
 	void checkIntraBatchConflicts();
 	void combineWriteConflictRanges();
+	int readCheckChunkCount() const;
 	void checkReadConflictRanges();
 	void mergeWriteConflictRanges(Version now);
 	void addConflictRanges(Version now,
@@ -24,6 +24,7 @@
 #include "fdbclient/TagThrottle.actor.h"
 #include "fdbserver/GrvTransactionRateInfo.h"
 #include "fdbserver/LatencyBandsMap.h"
+#include "fdbserver/TagQueueMerger.h"
 
 // GrvProxyTagThrottler is used to throttle GetReadVersionRequests based on tag quotas
 // before they're pushed into priority-partitioned queues.
@@ -43,8 +44,8 @@ class GrvProxyTagThrottler {
 		GetReadVersionRequest req;
 		uint64_t sequenceNumber;
 
-		explicit DelayedRequest(GetReadVersionRequest const& req)
-		  : req(req), startTime(now()), sequenceNumber(++lastSequenceNumber) {}
+		explicit DelayedRequest(GetReadVersionRequest&& req)
+		  : startTime(now()), req(std::move(req)), sequenceNumber(++lastSequenceNumber) {}
 
 		void updateProxyTagThrottledDuration(LatencyBandsMap&);
 		bool isMaxThrottled(double maxThrottleDuration) const;
@@ -53,6 +54,8 @@ class GrvProxyTagThrottler {
 	struct TagQueue {
 		Optional<GrvTransactionRateInfo> rateInfo;
 		Deque<DelayedRequest> requests;
+		// Transactions released in the current release window
+		uint32_t numReleased = 0;
 
 		TagQueue() = default;
 		explicit TagQueue(double rate)
@@ -69,6 +72,7 @@ class GrvProxyTagThrottler {
 	// Track the budgets for each tag
 	TransactionTagMap<TagQueue> queues;
 	double maxThrottleDuration;
+	TagQueueMerger<TagQueue> merger;
 
 	// Track latency bands for each tag
 	LatencyBandsMap latencyBandsMap;
@@ -95,6 +99,7 @@ public:
 	                                              Deque<GetReadVersionRequest>& outDefaultPriority);
 
 	void addRequest(GetReadVersionRequest const&);
+	void addRequest(GetReadVersionRequest&&);
 
 	void addLatencyBandThreshold(double value);
 
@@ -0,0 +1,109 @@
+/*
+ * LogRouterCache.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_LOGROUTERCACHE_H
+#define FDBSERVER_LOGROUTERCACHE_H
+#pragma once
+
+#include <deque>
+#include <map>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "fdbclient/FDBTypes.h"
+#include "flow/Arena.h"
+
+// The messages the log routers of a process pulled from the primary TLogs, by generation, log set, router tag and
+// version. A log router that starts pulling a version range another log router of the process already pulled for the
+// same router tag of the same log set, such as a replacement log router, reads it from here instead of over the WAN.
+// Messages keep the tags they were pushed with, so the reader maps them to its own remote TLogs.
+//
+// A recovery recruits log routers for each old log set it still has to copy to the remote region, and for the current
+// one, all with the same generation and router tags. The log sets are told apart by their epoch end, which is the
+// recovery version of an old log set and MAX_VERSION for the current one.
+//
+// For each log set and router tag, the cache knows all the messages of the versions in (begin, end]. Versions without
+// messages have no entry. The oldest versions are dropped when the cache is over its size limit.
+class LogRouterCache : NonCopyable {
+public:
+	struct VersionMessages {
+		Version version;
+		Standalone<VectorRef<TagsAndMessage>> messages;
+	};
+
+	explicit LogRouterCache(int64_t maxBytes) : maxBytes(maxBytes) {}
+
+	// The cache shared by the log routers of this process, sized by LOG_ROUTER_CACHE_BYTES
+	static LogRouterCache& get();
+
+	bool enabled() const { return maxBytes > 0; }
+	int64_t getBytes() const { return bytes; }
+
+	// Log routers register for the router tag they pull while they run. The data of a generation no log router is
+	// registered for is dropped once a newer generation is added.
+	void addReader(int64_t generation, Version epochEnd, Tag routerTag);
+	void removeReader(int64_t generation, Version epochEnd, Tag routerTag);
+
+	// Records that the messages of the versions in (previous, version] are the given ones, all at version. If previous
+	// is not the end of the known range, the known range restarts at previous.
+	void add(int64_t generation,
+	         Version epochEnd,
+	         Tag routerTag,
+	         Version previous,
+	         Version version,
+	         const std::vector<TagsAndMessage>& messages);
+
+	// If the messages of the versions after begin are known, appends those of the versions in (begin, min(end, limit)]
+	// to out and returns that end. Otherwise returns begin.
+	Version read(int64_t generation,
+	             Version epochEnd,
+	             Tag routerTag,
+	             Version begin,
+	             Version limit,
+	             std::vector<VersionMessages>& out) const;
+
+private:
+	struct Key {
+		int64_t generation;
+		Version epochEnd;
+		Tag routerTag;
+
+		bool operator<(const Key& r) const {
+			return std::tie(generation, epochEnd, routerTag) < std::tie(r.generation, r.epochEnd, r.routerTag);
+		}
+	};
+
+	struct TagCache {
+		int readers = 0;
+		Version begin = invalidVersion;
+		Version end = invalidVersion;
+		int64_t bytes = 0;
+		std::deque<VersionMessages> versions;
+	};
+
+	const int64_t maxBytes;
+	int64_t bytes = 0;
+	std::map<Key, TagCache> tags;
+
+	void evict();
+};
+
+#endif
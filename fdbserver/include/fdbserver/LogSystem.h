@@ -821,13 +821,24 @@ struct LogPushData : NonCopyable {
 	template <class T>
 	void writeTypedMessage(T const& item, bool metadataMessage = false, bool allLocations = false);
 
-	Standalone<StringRef> getMessages(int loc) const { return messagesWriter[loc].toValue(); }
+	// Writes mutation like writeTypedMessage(), except that a value of at least minReferencedBytes (if positive) is
+	// not copied into the messages: they reference it, and keep valueArena alive, until they are sent.
+	void writeMutation(MutationRef const& mutation, Arena const& valueArena, int minReferencedBytes);
+
+	// Returns the messages of a location as one string, which copies the values referenced by writeMutation()
+	Standalone<StringRef> getMessages(int loc) const;
+
+	// Returns the messages of a location as the pieces they are held in, which reference the values written by
+	// writeMutation() rather than copying them
+	Standalone<VectorRef<StringRef>> getMessagePieces(int loc) const;
+
+	bool hasReferencedValues(int loc) const { return !referencedValues[loc].empty(); }
 
 	// Returns all locations' messages, including empty ones.
 	std::vector<Standalone<StringRef>> getAllMessages() const;
 
 	// Records if a tlog (specified by "loc") will receive an empty version batch message.
-	// "value" is the message returned by getMessages() call.
+	// "value" is the message returned by getMessages() call, or empty if getMessagePieces() was called instead.
 	void recordEmptyMessage(int loc, const Standalone<StringRef>& value);
 
 	// Returns the ratio of empty messages in this version batch.
@@ -852,6 +863,10 @@ private:
 	std::set<Tag> written_tags;
 	std::vector<BinaryWriter> messagesWriter;
 	std::vector<bool> messagesWritten; // if messagesWriter has written anything
+	// For each location, the values referenced by writeMutation() and the offsets in messagesWriter they belong at
+	std::vector<std::vector<std::pair<int, StringRef>>> referencedValues;
+	Arena referencedArena; // Depends on the arenas of the referenced values
+	const Arena* lastReferencedArena = nullptr;
 	std::vector<int> msg_locations;
 	Optional<std::vector<Reference<LocalitySet>>> fromLocations;
 	// Stores message locations that have had span information written to them
@@ -868,6 +883,10 @@ private:
 	// written.
 	bool writeTransactionInfo(int location, uint32_t subseq);
 
+	// Finds the locations of the next message into msg_locations, and writes transaction info to them before a
+	// mutation. Returns the subsequence of the message.
+	uint32_t prepareMessage(bool metadataMessage, bool allLocations);
+
 	Tag chooseRouterTag() {
 		return savedRandomRouterTag.present() ? savedRandomRouterTag.get() : logSystem->getRandomRouterTag();
 	}
@@ -875,45 +894,7 @@ private:
 
 template <class T>
 void LogPushData::writeTypedMessage(T const& item, bool metadataMessage, bool allLocations) {
-	prev_tags.clear();
-	if (logSystem->hasRemoteLogs()) {
-		prev_tags.push_back(chooseRouterTag());
-	}
-	for (auto& tag : next_message_tags) {
-		prev_tags.push_back(tag);
-	}
-	msg_locations.clear();
-	logSystem->getPushLocations(prev_tags, msg_locations, allLocations, fromLocations);
-
-	BinaryWriter bw(AssumeVersion(g_network->protocolVersion()));
-
-	// Metadata messages (currently LogProtocolMessage is the only metadata
-	// message) should be written before span information. If this isn't a
-	// metadata message, make sure all locations have had transaction info
-	// written to them.  Mutations may have different sets of tags, so it
-	// is necessary to check all tag locations each time a mutation is
-	// written.
-	if (!metadataMessage) {
-		uint32_t subseq = this->subsequence++;
-		bool updatedLocation = false;
-		for (int loc : msg_locations) {
-			updatedLocation = writeTransactionInfo(loc, subseq) || updatedLocation;
-		}
-		// If this message doesn't write to any new locations, the
-		// subsequence wasn't actually used and can be decremented.
-		if (!updatedLocation) {
-			this->subsequence--;
-			CODE_PROBE(true, "No new SpanContextMessage written to transaction logs");
-			ASSERT(this->subsequence > 0);
-		}
-	} else {
-		// When writing a metadata message, make sure transaction state has
-		// been reset. If you are running into this assertion, make sure
-		// you are calling addTransactionInfo before each transaction.
-		ASSERT(writtenLocations.size() == 0);
-	}
-
-	uint32_t subseq = this->subsequence++;
+	uint32_t subseq = prepareMessage(metadataMessage, allLocations);
 	bool first = true;
 	int firstOffset = -1, firstLength = -1;
 	for (int loc : msg_locations) {
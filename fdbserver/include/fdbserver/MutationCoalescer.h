@@ -0,0 +1,55 @@
+/*
+ * MutationCoalescer.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_MUTATIONCOALESCER_H
+#define FDBSERVER_MUTATIONCOALESCER_H
+#pragma once
+
+#include <map>
+#include <vector>
+
+#include "fdbclient/CommitTransaction.h"
+
+// Collapses a sequence of SetValue and ClearRange mutations into the fewest writes with the same effect on a key
+// value store: only the last set of each key is kept, sets followed by a clear of their key are dropped, and clears
+// that overlap or touch are merged into one. Every set that remains was added after all the clears of its key, so
+// writing the clears before the sets gives the same result as writing the added mutations in order.
+//
+// Only references to the keys and values of the added mutations are kept, so their memory must outlive the coalescer.
+class MutationCoalescer : NonCopyable {
+public:
+	void add(MutationRef const& m);
+
+	// Clears in key order, followed by sets in key order
+	std::vector<MutationRef> getMutations() const;
+
+	int getMutationsAdded() const { return mutationsAdded; }
+	// The sum of the expectedSize() of the added mutations
+	int64_t getBytesAdded() const { return bytesAdded; }
+
+private:
+	std::map<KeyRef, ValueRef> sets;
+	// Begin to end of each cleared range. The ranges neither overlap nor touch.
+	std::map<KeyRef, KeyRef> clears;
+	int mutationsAdded = 0;
+	int64_t bytesAdded = 0;
+};
+
+#endif
@@ -0,0 +1,44 @@
+/*
+ * PeekCursorReplicas.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_PEEKCURSORREPLICAS_H
+#define FDBSERVER_PEEKCURSORREPLICAS_H
+#pragma once
+
+#include "fdbclient/FDBTypes.h"
+
+// The server cursors of a merged peek cursor hold replicas of the same messages, and while the best server's cursor
+// has messages all of them are read from it. The other cursors are then only moved along at the first message of each
+// version, instead of stepping each of them through every message, which made reading a message cost a call per
+// server. Before anything reads their versions, the merged cursor advances them again, as it already did when the best
+// server runs out of messages.
+//
+// Advances the cursors to current if the message there starts a new version after the one at previous.
+template <class Cursors>
+void advanceReplicaCursors(Cursors& cursors, LogMessageVersion const& previous, LogMessageVersion const& current) {
+	if (current.version == previous.version) {
+		return;
+	}
+	for (auto& c : cursors) {
+		c->advanceTo(current);
+	}
+}
+
+#endif
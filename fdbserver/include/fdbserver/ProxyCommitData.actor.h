@@ -34,7 +34,9 @@
 #include "fdbserver/LogSystemDiskQueueAdapter.h"
 #include "fdbserver/MasterInterface.h"
 #include "fdbserver/ResolverInterface.h"
+#include "fdbserver/ShardBoundaryIndex.h"
 #include "flow/IRandom.h"
+#include "flow/IThreadPool.h"
 
 #include "flow/actorcompiler.h" // This must be the last #include.
 
@@ -52,6 +54,58 @@ struct ApplyMutationsData {
 	Reference<KeyRangeMap<Version>> keyVersion;
 };
 
+// Chooses the commit batching interval and the number of transactions per batch so that the p99 latency of commit
+// batches settles at a target, see COMMIT_BATCH_TARGET_P99_LATENCY. The latency of a batch counts the interval its
+// first transaction may have waited to be batched, plus the time the batch took to get through the commit pipeline.
+// Every COMMIT_BATCH_CONTROLLER_WINDOW batches, both limits are scaled by the relative error of the p99 over that
+// window: down when over the target, and up in proportion to the headroom when under it.
+class CommitBatchController {
+public:
+	explicit CommitBatchController(double targetLatency)
+	  : targetLatency(targetLatency), interval(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN),
+	    countLimit(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX), lastP99(0) {}
+
+	bool enabled() const { return targetLatency > 0; }
+	double getInterval() const { return interval; }
+	int getCountLimit() const { return countLimit; }
+	double getLastP99() const { return lastP99; }
+
+	static int minCountLimit() {
+		return std::clamp(
+		    SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MIN, 1, SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX);
+	}
+
+	// Returns true if the limits were updated
+	bool addBatch(double pipelineLatency) {
+		latencies.push_back(interval + pipelineLatency);
+		if (latencies.size() < std::max(SERVER_KNOBS->COMMIT_BATCH_CONTROLLER_WINDOW, 1))
+			return false;
+
+		auto p99 = latencies.begin() + (latencies.size() - 1) * 99 / 100;
+		std::nth_element(latencies.begin(), p99, latencies.end());
+		lastP99 = *p99;
+		latencies.clear();
+
+		const double error = (targetLatency - lastP99) / targetLatency;
+		const double factor = std::clamp(1 + SERVER_KNOBS->COMMIT_BATCH_CONTROLLER_GAIN * error, 0.5, 2.0);
+		interval = std::clamp(interval * factor,
+		                      SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN,
+		                      SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MAX);
+		// Under overload batches stay large enough to amortize the fixed cost of each one, rather than shrinking to
+		// single transactions and collapsing throughput further
+		countLimit = std::clamp(
+		    countLimit * factor, (double)minCountLimit(), (double)SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX);
+		return true;
+	}
+
+private:
+	double targetLatency;
+	double interval;
+	double countLimit; // Kept fractional so that small limits can still grow by less than one
+	double lastP99;
+	std::vector<double> latencies;
+};
+
 struct ProxyStats {
 	CounterCollection cc;
 	Counter txnCommitIn, txnCommitVersionAssigned, txnCommitResolving, txnCommitResolved, txnCommitOut,
@@ -89,6 +143,12 @@ struct ProxyStats {
 	Reference<Histogram> processingMutationDist;
 	Reference<Histogram> tlogLoggingDist;
 	Reference<Histogram> replyCommitDist;
+	// Time commit batches spend in each stage of commitBatchImpl, from the start of the stage to the end of the wait
+	Reference<Histogram> preResolutionStageDist;
+	Reference<Histogram> resolutionStageDist;
+	Reference<Histogram> postResolutionStageDist;
+	Reference<Histogram> transactionLoggingStageDist;
+	Reference<Histogram> replyStageDist;
 
 	// These metrics are only logged as part of `ProxyDetailedMetrics`. Since
 	// the detailed proxy metrics combine data from different sources, we can't
@@ -156,7 +216,16 @@ struct ProxyStats {
 	    processingMutationDist(
 	        Histogram::getHistogram("CommitProxy"_sr, "ProcessingMutation"_sr, Histogram::Unit::milliseconds)),
 	    tlogLoggingDist(Histogram::getHistogram("CommitProxy"_sr, "TlogLogging"_sr, Histogram::Unit::milliseconds)),
-	    replyCommitDist(Histogram::getHistogram("CommitProxy"_sr, "ReplyCommit"_sr, Histogram::Unit::milliseconds)) {
+	    replyCommitDist(Histogram::getHistogram("CommitProxy"_sr, "ReplyCommit"_sr, Histogram::Unit::milliseconds)),
+	    preResolutionStageDist(
+	        Histogram::getHistogram("CommitProxy"_sr, "StagePreResolution"_sr, Histogram::Unit::milliseconds)),
+	    resolutionStageDist(
+	        Histogram::getHistogram("CommitProxy"_sr, "StageResolution"_sr, Histogram::Unit::milliseconds)),
+	    postResolutionStageDist(
+	        Histogram::getHistogram("CommitProxy"_sr, "StagePostResolution"_sr, Histogram::Unit::milliseconds)),
+	    transactionLoggingStageDist(
+	        Histogram::getHistogram("CommitProxy"_sr, "StageTransactionLogging"_sr, Histogram::Unit::milliseconds)),
+	    replyStageDist(Histogram::getHistogram("CommitProxy"_sr, "StageReply"_sr, Histogram::Unit::milliseconds)) {
 		specialCounter(cc, "LastAssignedCommitVersion", [this]() { return this->lastCommitVersionAssigned; });
 		specialCounter(cc, "Version", [pVersion]() { return pVersion->get(); });
 		specialCounter(cc, "CommittedVersion", [pCommittedVersion]() { return pCommittedVersion->get(); });
@@ -204,12 +273,19 @@ struct ProxyCommitData {
 	// only tracks normalKeys. This is used for tracking versions for systemKeys.
 	Deque<Version> systemKeyVersions;
 	KeyRangeMap<ServerCacheInfo> keyInfo; // keyrange -> all storage servers in all DCs for the keyrange
+	ShardBoundaryIndex<ServerCacheInfo> keyInfoIndex; // Invalidated by every change to keyInfo, see PROXY_KEY_INFO_INDEX
 	std::map<Key, ApplyMutationsData> uid_applyMutationsData;
 	bool firstProxy;
 	double lastCoalesceTime;
 	bool locked;
 	Optional<Value> metadataVersion;
 	double commitBatchInterval;
+	int commitBatchCountLimit;
+	CommitBatchController commitBatchController;
+	// Mutations of a commit batch have their keyInfo shards looked up in up to shardLookupParallelism slices, all but
+	// one of them on shardLookupThreads, see PROXY_SHARD_LOOKUP_THREADS
+	int shardLookupParallelism = 1;
+	Reference<IThreadPool> shardLookupThreads;
 	bool provisional;
 
 	int64_t localCommitBatchesStarted;
@@ -321,7 +397,9 @@ struct ProxyCommitData {
 	    txnStateStore(nullptr), committedVersion(recoveryTransactionVersion), minKnownCommittedVersion(0), version(0),
 	    lastVersionTime(0), commitVersionRequestNumber(1), mostRecentProcessedRequestNumber(0), firstProxy(firstProxy),
 	    provisional(provisional), lastCoalesceTime(0), locked(false),
-	    commitBatchInterval(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN), localCommitBatchesStarted(0),
+	    commitBatchInterval(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_INTERVAL_MIN),
+	    commitBatchCountLimit(SERVER_KNOBS->COMMIT_TRANSACTION_BATCH_COUNT_MAX),
+	    commitBatchController(SERVER_KNOBS->COMMIT_BATCH_TARGET_P99_LATENCY), localCommitBatchesStarted(0),
 	    getConsistentReadVersion(getConsistentReadVersion), commit(commit),
 	    cx(openDBOnServer(db, TaskPriority::DefaultEndpoint, LockAware::True)), db(db),
 	    singleKeyMutationEvent("SingleKeyMutation"_sr), lastTxsPop(0), popRemoteTxs(false), lastStartCommit(0),
@@ -0,0 +1,134 @@
+/*
+ * ShardBoundaryIndex.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_SHARDBOUNDARYINDEX_H
+#define FDBSERVER_SHARDBOUNDARYINDEX_H
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/KeyRangeMap.h"
+#include "flow/Arena.h"
+
+// A sorted array of keys laid out for fast lastLessOrEqual() searches. The keys are split into blocks of blockSize,
+// and each key is stored as the big endian 8 bytes following the prefix shared by all keys of its block, so most of
+// a search is a branch free binary search over a few cache lines of integers. Full key comparisons are only needed
+// for keys that are equal in those 8 bytes. The first keys of the blocks are indexed the same way to pick the block.
+class ShardBoundaries {
+public:
+	static constexpr int blockSize = 32;
+
+	int size() const { return keys.size(); }
+	const KeyRef& operator[](int i) const { return keys[i]; }
+
+	// Returns the index of the last key <= key, or -1 if there is none
+	int lastLessOrEqual(const KeyRef& key) const;
+
+	// Returns the index of the first key >= key, or size() if there is none
+	int lowerBound(const KeyRef& key) const;
+
+	// Replaces the keys at [begin, end) with the sorted newKeys, which are copied. The result must remain sorted.
+	void replace(int begin, int end, const std::vector<KeyRef>& newKeys);
+
+private:
+	Arena arena;
+	int64_t liveBytes = 0;
+	std::vector<KeyRef> keys;
+	std::vector<uint64_t> words; // keyWord(keys[i], blockPrefixLengths[i / blockSize])
+	std::vector<int> blockPrefixLengths;
+	std::vector<KeyRef> blockKeys; // The first key of each block
+	std::vector<uint64_t> blockWords; // keyWord(blockKeys[b], blockKeysPrefixLength) for b >= 1
+	int blockKeysPrefixLength = 0; // Shared by blockKeys[1..], blockKeys[0] is the least key
+
+	void rebuild(int fromBlock);
+	void compact();
+};
+
+// A read-optimized copy of the range boundaries of a KeyRangeMap, answering rangeContaining() like the map itself.
+// The map must report every insert to invalidate() or invalidateAll(), and update() must be called after changing it
+// and before the next lookup. update() only re-reads the invalidated part of the map.
+template <class Val>
+class ShardBoundaryIndex {
+public:
+	using iterator = typename KeyRangeMap<Val>::iterator;
+
+	bool isDirty() const { return dirty; }
+
+	// Marks the boundaries in [range.begin, range.end] as possibly changed
+	void invalidate(const KeyRangeRef& range) {
+		if (dirtyAll)
+			return;
+		if (!dirty) {
+			dirty = true;
+			dirtyBegin = range.begin;
+			dirtyEnd = range.end;
+		} else {
+			if (range.begin < dirtyBegin)
+				dirtyBegin = range.begin;
+			if (range.end > dirtyEnd)
+				dirtyEnd = range.end;
+		}
+	}
+
+	void invalidateAll() { dirty = dirtyAll = true; }
+
+	void update(KeyRangeMap<Val>& map) {
+		if (!dirty)
+			return;
+
+		std::vector<KeyRef> newKeys;
+		std::vector<iterator> newRanges;
+		const auto last = map.ranges().end();
+		for (auto it = dirtyAll ? map.ranges().begin() : map.rangeContaining(dirtyBegin);; ++it) {
+			if (!dirtyAll && it.begin() > dirtyEnd)
+				break;
+			if (dirtyAll || it.begin() >= dirtyBegin) {
+				newKeys.push_back(it.begin());
+				newRanges.push_back(it);
+			}
+			if (it == last)
+				break;
+		}
+
+		const int begin = dirtyAll ? 0 : boundaries.lowerBound(dirtyBegin);
+		const int end = dirtyAll ? boundaries.size() : boundaries.lastLessOrEqual(dirtyEnd) + 1;
+		boundaries.replace(begin, end, newKeys);
+		ranges.erase(ranges.begin() + begin, ranges.begin() + end);
+		ranges.insert(ranges.begin() + begin, newRanges.begin(), newRanges.end());
+		dirty = dirtyAll = false;
+	}
+
+	iterator rangeContaining(const KeyRef& key) const {
+		ASSERT(!dirty);
+		return ranges[boundaries.lastLessOrEqual(key)];
+	}
+
+private:
+	ShardBoundaries boundaries;
+	std::vector<iterator> ranges; // ranges[i].begin() == boundaries[i], including the map's end
+	bool dirty = true;
+	bool dirtyAll = true;
+	Key dirtyBegin;
+	Key dirtyEnd;
+};
+
+#endif
@@ -0,0 +1,79 @@
+/*
+ * StorageValueCache.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_STORAGEVALUECACHE_H
+#define FDBSERVER_STORAGEVALUECACHE_H
+#pragma once
+
+#include <list>
+#include <map>
+
+#include "fdbclient/FDBTypes.h"
+#include "flow/Arena.h"
+
+// The values a storage server last read from its storage engine for the most recently read keys, including keys that
+// were not there. A storage server only reads a key from the engine when its versioned data has nothing for the key
+// at the read version, in which case the value in the engine is the one at that version, so a cached value can be
+// returned in its place until the storage server writes the key to the engine again. Every write to the engine
+// invalidates the keys it covers.
+//
+// A read that was in flight while keys were invalidated may have seen the engine before or after the write, so values
+// are only added if nothing was invalidated since the read started, which callers check with getEpoch().
+class StorageValueCache : NonCopyable {
+public:
+	explicit StorageValueCache(int64_t maxBytes) : maxBytes(maxBytes) {}
+
+	bool enabled() const { return maxBytes > 0; }
+	int64_t getBytes() const { return bytes; }
+	// Changes whenever keys are invalidated
+	uint64_t getEpoch() const { return epoch; }
+
+	// Sets value to the cached value of key and returns true, or returns false if key is not cached
+	bool get(KeyRef key, Optional<Value>& value);
+
+	// Caches the value of key read from the engine if nothing was invalidated since epoch, evicting the least recently
+	// used keys to stay under the size limit. Returns the number of keys evicted.
+	int add(KeyRef key, Optional<Value> const& value, uint64_t epoch);
+
+	void invalidate(KeyRangeRef keys);
+	void invalidate(KeyRef key) { invalidate(singleKeyRange(key)); }
+	void clear();
+
+private:
+	struct Entry {
+		Key key;
+		Optional<Value> value;
+	};
+
+	const int64_t maxBytes;
+	int64_t bytes = 0;
+	uint64_t epoch = 0;
+	// Most recently used first
+	std::list<Entry> entries;
+	// Keys refer to the memory of the entries
+	std::map<KeyRef, std::list<Entry>::iterator> index;
+
+	static int64_t entryBytes(Entry const& e) {
+		return sizeof(Entry) + 2 * e.key.size() + (e.value.present() ? e.value.get().size() : 0) + 64;
+	}
+	void erase(std::map<KeyRef, std::list<Entry>::iterator>::iterator i);
+};
+
+#endif
@@ -325,6 +325,47 @@ struct TLogCommitReply {
 	}
 };
 
+// The messages of a TLogCommitRequest, which the sender may hold as pieces to be concatenated instead of as one
+// StringRef, see LogPushData::getMessagePieces(). They are serialized like, and received as, the one StringRef.
+struct TLogCommitMessages {
+	StringRef* messages;
+	const VectorRef<StringRef>* pieces;
+
+	// Flatbuffer implementation requires default constructor
+	TLogCommitMessages() : messages(nullptr), pieces(nullptr) {}
+	TLogCommitMessages(StringRef& messages, const VectorRef<StringRef>& pieces) : messages(&messages), pieces(&pieces) {}
+};
+
+template <>
+struct dynamic_size_traits<TLogCommitMessages> : std::true_type {
+	template <class Context>
+	static size_t size(const TLogCommitMessages& t, Context&) {
+		if (t.pieces->empty()) {
+			return t.messages->size();
+		}
+		size_t size = 0;
+		for (const auto& piece : *t.pieces) {
+			size += piece.size();
+		}
+		return size;
+	}
+
+	template <class Context>
+	static void save(uint8_t* out, const TLogCommitMessages& t, Context&) {
+		if (t.pieces->empty()) {
+			std::copy(t.messages->begin(), t.messages->end(), out);
+		}
+		for (const auto& piece : *t.pieces) {
+			out = std::copy(piece.begin(), piece.end(), out);
+		}
+	}
+
+	template <class Context>
+	static void load(const uint8_t* ptr, size_t sz, TLogCommitMessages& t, Context& context) {
+		dynamic_size_traits<StringRef>::load(ptr, sz, *t.messages, context);
+	}
+};
+
 struct TLogCommitRequest : TimedRequest {
 	constexpr static FileIdentifier file_identifier = 4022206;
 	SpanContext spanContext;
@@ -332,6 +373,7 @@ struct TLogCommitRequest : TimedRequest {
 	Version prevVersion, version, knownCommittedVersion, minKnownCommittedVersion, seqPrevVersion;
 
 	StringRef messages; // Each message prefixed by a 4-byte length
+	VectorRef<StringRef> messagePieces; // Sent as messages instead if not empty, see TLogCommitMessages
 
 	ReplyPromise<TLogCommitReply> reply;
 	uint16_t tLogCount;
@@ -356,12 +398,13 @@ struct TLogCommitRequest : TimedRequest {
 	    debugID(debugID) {}
 	template <class Ar>
 	void serialize(Ar& ar) {
+		auto wrappedMessages = TLogCommitMessages(messages, messagePieces);
 		serializer(ar,
 		           prevVersion,
 		           version,
 		           knownCommittedVersion,
 		           minKnownCommittedVersion,
-		           messages,
+		           wrappedMessages,
 		           reply,
 		           debugID,
 		           tLogCount,
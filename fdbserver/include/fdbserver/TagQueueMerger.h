@@ -0,0 +1,79 @@
+/*
+ * TagQueueMerger.h
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef FDBSERVER_TAGQUEUEMERGER_H
+#define FDBSERVER_TAGQUEUEMERGER_H
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+// Releases the requests of several FIFO queues, one per tag, in the order they arrived across all the queues. A Queue
+// has a member requests, a Deque whose elements have increasing sequenceNumbers shared by all queues.
+//
+// The queues are merged with a heap of the queues with requests, keyed by the sequence number of their first request.
+// While a queue holds the next requests in arrival order they are released without touching the heap, so releasing
+// a run of requests of one tag costs O(1) per request, and switching tags O(log tags). The heap's storage is reused
+// between calls.
+template <class Queue>
+class TagQueueMerger {
+public:
+	// Adds a queue to the next call to release()
+	void add(Queue& queue) {
+		if (!queue.requests.empty()) {
+			heap.push_back(&queue);
+		}
+	}
+
+	// Calls releaseFront(queue) for the queue added since the last call holding the first request in arrival order,
+	// until releaseFront() has returned false for every queue, or all of them are empty. releaseFront() either pops the
+	// front request of the queue and returns true, or returns false to stop releasing from the queue in this call.
+	template <class ReleaseFront>
+	void release(ReleaseFront releaseFront) {
+		std::make_heap(heap.begin(), heap.end(), later);
+		while (!heap.empty()) {
+			std::pop_heap(heap.begin(), heap.end(), later);
+			Queue* queue = heap.back();
+			heap.pop_back();
+			// The first request of the other queues, before which queue can release its requests
+			const uint64_t nextSequenceNumber =
+			    heap.empty() ? std::numeric_limits<uint64_t>::max() : heap.front()->requests.front().sequenceNumber;
+
+			while (releaseFront(*queue) && !queue->requests.empty()) {
+				if (queue->requests.front().sequenceNumber > nextSequenceNumber) {
+					heap.push_back(queue);
+					std::push_heap(heap.begin(), heap.end(), later);
+					break;
+				}
+			}
+		}
+	}
+
+private:
+	std::vector<Queue*> heap;
+
+	static bool later(const Queue* a, const Queue* b) {
+		return a->requests.front().sequenceNumber > b->requests.front().sequenceNumber;
+	}
+};
+
+#endif
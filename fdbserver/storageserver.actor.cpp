@@ -96,6 +96,8 @@
 #include "fdbserver/WorkerInterface.actor.h"
 #include "fdbserver/StorageCorruptionBug.h"
 #include "fdbserver/StorageServerUtils.h"
+#include "fdbserver/MutationCoalescer.h"
+#include "fdbserver/StorageValueCache.h"
 #include "flow/ActorCollection.h"
 #include "flow/Arena.h"
 #include "flow/Error.h"
@@ -403,6 +405,14 @@ struct AddingShard : NonCopyable {
 	Version transferredVersion;
 	Version fetchVersion;
 
+	// Progress of the Fetching phase. Keys before fetchedThrough have all been written to storage, and so have
+	// blocksAhead blocks past it, which were fetched out of order.
+	double fetchingStartTime = 0;
+	int64_t fetchedBytes = 0;
+	int64_t fetchedRows = 0;
+	Key fetchedThrough;
+	int blocksAhead = 0;
+
 	// To learn more details of the phase transitions, see function fetchKeys(). The phases below are sorted in
 	// chronological order and do not go back.
 	enum Phase {
@@ -431,7 +441,8 @@ struct AddingShard : NonCopyable {
 	AddingShard(AddingShard* prev, KeyRange const& keys)
 	  : keys(keys), fetchClient(prev->fetchClient), server(prev->server), transferredVersion(prev->transferredVersion),
 	    fetchVersion(prev->fetchVersion), phase(prev->phase), reason(prev->reason),
-	    ssBulkLoadMetadata(prev->ssBulkLoadMetadata) {}
+	    ssBulkLoadMetadata(prev->ssBulkLoadMetadata), fetchingStartTime(prev->fetchingStartTime),
+	    fetchedBytes(prev->fetchedBytes), fetchedRows(prev->fetchedRows), fetchedThrough(prev->fetchedThrough) {}
 	~AddingShard() {
 		if (!fetchComplete.isSet())
 			fetchComplete.send(Void());
@@ -604,7 +615,8 @@ public:
 };
 
 struct StorageServerDisk {
-	explicit StorageServerDisk(struct StorageServer* data, IKeyValueStore* storage) : data(data), storage(storage) {}
+	explicit StorageServerDisk(struct StorageServer* data, IKeyValueStore* storage)
+	  : valueCache(SERVER_KNOBS->STORAGE_VALUE_CACHE_BYTES), data(data), storage(storage) {}
 
 	IKeyValueStore* getKeyValueStore() const { return this->storage; }
 
@@ -629,14 +641,19 @@ struct StorageServerDisk {
 	void clearRange(KeyRangeRef keys);
 
 	Future<Void> addRange(KeyRangeRef range, std::string id) {
+		valueCache.invalidate(range);
 		return storage->addRange(range, id, !SERVER_KNOBS->SHARDED_ROCKSDB_DELAY_COMPACTION_FOR_DATA_MOVE);
 	}
 
-	std::vector<std::string> removeRange(KeyRangeRef range) { return storage->removeRange(range); }
+	std::vector<std::string> removeRange(KeyRangeRef range) {
+		valueCache.invalidate(range);
+		return storage->removeRange(range);
+	}
 
 	void markRangeAsActive(KeyRangeRef range) { storage->markRangeAsActive(range); }
 
 	Future<Void> replaceRange(KeyRange range, Standalone<VectorRef<KeyValueRef>> data) {
+		valueCache.invalidate(range);
 		return storage->replaceRange(range, data);
 	}
 
@@ -667,6 +684,11 @@ struct StorageServerDisk {
 		++(*kvGets);
 		return storage->readValue(key, options);
 	}
+	Future<std::vector<Optional<Value>>> readValues(Standalone<VectorRef<KeyRef>> keys,
+	                                                Optional<ReadOptions> options = Optional<ReadOptions>()) {
+		*kvGets += keys.size();
+		return storage->readValues(keys, options);
+	}
 	Future<Optional<Value>> readValuePrefix(KeyRef key,
 	                                        int maxLength,
 	                                        Optional<ReadOptions> options = Optional<ReadOptions>()) {
@@ -683,11 +705,17 @@ struct StorageServerDisk {
 
 	Future<CheckpointMetaData> checkpoint(const CheckpointRequest& request) { return storage->checkpoint(request); }
 
-	Future<Void> restore(const std::vector<CheckpointMetaData>& checkpoints) { return storage->restore(checkpoints); }
+	Future<Void> restore(const std::vector<CheckpointMetaData>& checkpoints) {
+		valueCache.clear();
+		return storage->restore(checkpoints);
+	}
 
 	Future<Void> restore(const std::string& shardId,
 	                     const std::vector<KeyRange>& ranges,
 	                     const std::vector<CheckpointMetaData>& checkpoints) {
+		for (const auto& range : ranges) {
+			valueCache.invalidate(range);
+		}
 		return storage->restore(shardId, ranges, checkpoints);
 	}
 
@@ -703,15 +731,25 @@ struct StorageServerDisk {
 	Counter* kvCommitLogicalBytes;
 	Counter* kvClearRanges;
 	Counter* kvClearSingleKey;
+	Counter* kvCoalescedMutations;
+	Counter* kvCoalescedBytes;
 	Counter* kvGets;
 	Counter* kvScans;
 	Counter* kvCommits;
 
+	// Values read from the engine, which the writes above invalidate
+	StorageValueCache valueCache;
+
 private:
 	struct StorageServer* data;
 	IKeyValueStore* storage;
 	void writeMutations(const VectorRef<MutationRef>& mutations, Version debugVersion, const char* debugContext);
 	void writeMutationsBuggy(const VectorRef<MutationRef>& mutations, Version debugVersion, const char* debugContext);
+	void writeCoalescedVersions(Version& prevStorageVersion,
+	                            Version newStorageVersion,
+	                            int64_t& bytesLeft,
+	                            UnlimitedCommitBytes unlimitedCommitBytes,
+	                            int64_t& clearRangesLeft);
 
 	ACTOR static Future<Key> readFirstKey(IKeyValueStore* storage, KeyRangeRef range, Optional<ReadOptions> options) {
 		RangeResult r = wait(storage->readRange(range, 1, 1 << 30, options));
@@ -881,6 +919,8 @@ private:
 
 	VersionedData versionedData;
 	std::map<Version, Standalone<VerUpdateRef>> mutationLog; // versions (durableVersion, version]
+	// Bytes of the PBTree nodes versionedData copied at each version, charged to bytesInput until the version is durable
+	std::map<Version, int64_t> versionedDataNodeBytes;
 
 	using WatchMapKey = Key;
 	using WatchMapKeyHasher = boost::hash<WatchMapKey>;
@@ -1102,6 +1142,27 @@ public:
 		return mLV.push_back_deep(mLV.arena(), m);
 	}
 
+	// Charges the nodes versionedData allocated since the last call to its latest version. Only a PBTree versioned map
+	// reports any, as mvccStorageBytes() already covers the nodes of a PTree.
+	void chargeVersionedDataNodeBytes() {
+		const int64_t bytes = versionedData.takeNodeBytesAllocated();
+		if (bytes > 0) {
+			counters.bytesInput += bytes;
+			versionedDataNodeBytes[versionedData.getLatestVersion()] += bytes;
+		}
+	}
+
+	// Returns the node bytes charged to the versions up to durableVersion, which are no longer charged
+	int64_t releaseVersionedDataNodeBytes(Version durableVersion) {
+		int64_t bytes = 0;
+		auto end = versionedDataNodeBytes.upper_bound(durableVersion);
+		for (auto v = versionedDataNodeBytes.begin(); v != end; ++v) {
+			bytes += v->second;
+		}
+		versionedDataNodeBytes.erase(versionedDataNodeBytes.begin(), end);
+		return bytes;
+	}
+
 	void setTssPair(UID pairId) {
 		tssPairID = Optional<UID>(pairId);
 
@@ -1292,6 +1353,9 @@ public:
 		Counter kvClearRanges;
 		// Count of all clearRange operations on a singlekeyRange(key delete) to the storage engine.
 		Counter kvClearSingleKey;
+		// Mutations, and their bytes, that were not written to the storage engine because a later mutation of the same
+		// versions overwrote or cleared them, or because they were clears merged into another one.
+		Counter kvCoalescedMutations, kvCoalescedBytes;
 		// ClearRange operations issued by FDB, instead of from users, e.g., ClearRange operations to remove a shard
 		// from a storage server, as in removeDataRange().
 		Counter kvSystemClearRanges;
@@ -1333,6 +1397,16 @@ public:
 		Counter kvCommits;
 		// The count of change feed reads that hit disk
 		Counter changeFeedDiskReads;
+		// The count of getValue reads served from and missing StorageServerDisk::valueCache, and of the keys evicted
+		// from it.
+		Counter valueCacheHits, valueCacheMisses, valueCacheEvictions;
+		// The count of GetValuesRequests, and of the keys they read.
+		Counter getValuesQueries, getValuesKeys;
+		// The count of rows filtered range reads examined, and of those that did not match their filter.
+		Counter filteredRowsScanned, filteredRowsDropped;
+		// The count of batched local reads issued for mapped point lookups, and of mapped lookups that were not issued
+		// because another row in their batch maps to the same key.
+		Counter quickGetValueBatches, mappedSubqueriesCoalesced;
 		// The count of ChangeServerKeys actions.
 		Counter changeServerKeysAssigned;
 		Counter changeServerKeysUnassigned;
@@ -1361,7 +1435,8 @@ public:
 		    watchQueries("WatchQueries", cc), emptyQueries("EmptyQueries", cc),
 		    logicalBytesInput("LogicalBytesInput", cc), logicalBytesMoveInOverhead("LogicalBytesMoveInOverhead", cc),
 		    kvCommitLogicalBytes("KVCommitLogicalBytes", cc), kvClearRanges("KVClearRanges", cc),
-		    kvClearSingleKey("KVClearSingleKey", cc), kvSystemClearRanges("KVSystemClearRanges", cc),
+		    kvClearSingleKey("KVClearSingleKey", cc), kvCoalescedMutations("KVCoalescedMutations", cc),
+		    kvCoalescedBytes("KVCoalescedBytes", cc), kvSystemClearRanges("KVSystemClearRanges", cc),
 		    bytesDurable("BytesDurable", cc), feedBytesFetched("FeedBytesFetched", cc),
 		    sampledBytesCleared("SampledBytesCleared", cc), atomicMutations("AtomicMutations", cc),
 		    changeFeedMutations("ChangeFeedMutations", cc),
@@ -1375,6 +1450,11 @@ public:
 		    quickGetKeyValuesMiss("QuickGetKeyValuesMiss", cc), kvScanBytes("KVScanBytes", cc),
 		    kvGetBytes("KVGetBytes", cc), eagerReadsKeys("EagerReadsKeys", cc), kvGets("KVGets", cc),
 		    kvScans("KVScans", cc), kvCommits("KVCommits", cc), changeFeedDiskReads("ChangeFeedDiskReads", cc),
+		    valueCacheHits("ValueCacheHits", cc), valueCacheMisses("ValueCacheMisses", cc),
+		    valueCacheEvictions("ValueCacheEvictions", cc), getValuesQueries("GetValuesQueries", cc),
+		    getValuesKeys("GetValuesKeys", cc), filteredRowsScanned("FilteredRowsScanned", cc),
+		    filteredRowsDropped("FilteredRowsDropped", cc), quickGetValueBatches("QuickGetValueBatches", cc),
+		    mappedSubqueriesCoalesced("MappedSubqueriesCoalesced", cc),
 		    getMappedRangeBytesQueried("GetMappedRangeBytesQueried", cc),
 		    finishedGetMappedRangeQueries("FinishedGetMappedRangeQueries", cc),
 		    finishedGetMappedRangeSecondaryQueries("FinishedGetMappedRangeSecondaryQueries", cc),
@@ -1424,6 +1504,7 @@ public:
 			specialCounter(cc, "KvstoreSizeTotal", [self]() { return std::get<0>(self->storage.getSize()); });
 			specialCounter(cc, "KvstoreNodeTotal", [self]() { return std::get<1>(self->storage.getSize()); });
 			specialCounter(cc, "KvstoreInlineKey", [self]() { return std::get<2>(self->storage.getSize()); });
+			specialCounter(cc, "ValueCacheBytes", [self]() { return self->storage.valueCache.getBytes(); });
 		}
 	} counters;
 
@@ -1439,7 +1520,7 @@ public:
 	StorageServer(IKeyValueStore* storage,
 	              Reference<AsyncVar<ServerDBInfo> const> const& db,
 	              StorageServerInterface const& ssi)
-	  : shardAware(false), locality(ssi.locality),
+	  : versionedData(SERVER_KNOBS->STORAGE_VERSIONED_MAP_BTREE), shardAware(false), locality(ssi.locality),
 	    tlogCursorReadsLatencyHistogram(Histogram::getHistogram(STORAGESERVER_HISTOGRAM_GROUP,
 	                                                            TLOG_CURSOR_READS_LATENCY_HISTOGRAM,
 	                                                            Histogram::Unit::milliseconds)),
@@ -1523,6 +1604,8 @@ public:
 		this->storage.kvCommitLogicalBytes = &counters.kvCommitLogicalBytes;
 		this->storage.kvClearRanges = &counters.kvClearRanges;
 		this->storage.kvClearSingleKey = &counters.kvClearSingleKey;
+		this->storage.kvCoalescedMutations = &counters.kvCoalescedMutations;
+		this->storage.kvCoalescedBytes = &counters.kvCoalescedBytes;
 		this->storage.kvGets = &counters.kvGets;
 		this->storage.kvScans = &counters.kvScans;
 		this->storage.kvCommits = &counters.kvCommits;
@@ -2221,21 +2304,32 @@ ACTOR Future<Void> getValueQ(StorageServer* data, GetValueRequest req) {
 		}
 
 		state int path = 0;
+		state bool useValueCache = data->storage.valueCache.enabled() &&
+		                           (!req.options.present() || req.options.get().cacheResult);
+		state uint64_t valueCacheEpoch = data->storage.valueCache.getEpoch();
 		auto i = data->data().at(version).lastLessOrEqual(req.key);
 		if (i && i->isValue() && i.key() == req.key) {
 			v = (Value)i->getValue();
 			path = 1;
 		} else if (!i || !i->isClearTo() || i->getEndKey() <= req.key) {
 			path = 2;
-			Optional<Value> vv = wait(data->storage.readValue(req.key, req.options));
-			data->counters.kvGetBytes += vv.expectedSize();
-			// Validate that while we were reading the data we didn't lose the version or shard
-			if (version < data->storageVersion()) {
-				CODE_PROBE(true, "transaction_too_old after readValue");
-				throw transaction_too_old();
+			if (useValueCache && data->storage.valueCache.get(req.key, v)) {
+				++data->counters.valueCacheHits;
+			} else {
+				Optional<Value> vv = wait(data->storage.readValue(req.key, req.options));
+				data->counters.kvGetBytes += vv.expectedSize();
+				// Validate that while we were reading the data we didn't lose the version or shard
+				if (version < data->storageVersion()) {
+					CODE_PROBE(true, "transaction_too_old after readValue");
+					throw transaction_too_old();
+				}
+				data->checkChangeCounter(changeCounter, req.key);
+				v = vv;
+				if (useValueCache) {
+					++data->counters.valueCacheMisses;
+					data->counters.valueCacheEvictions += data->storage.valueCache.add(req.key, v, valueCacheEpoch);
+				}
 			}
-			data->checkChangeCounter(changeCounter, req.key);
-			v = vv;
 		}
 
 		DEBUG_MUTATION("ShardGetValue",
@@ -2311,6 +2405,159 @@ ACTOR Future<Void> getValueQ(StorageServer* data, GetValueRequest req) {
 	return Void();
 }
 
+// Serves a batch of point reads at one version with a single wait for the version, a single read lock and a single
+// batched read of the keys that have to come from the storage engine.
+ACTOR Future<Void> getValuesQ(StorageServer* data, GetValuesRequest req) {
+	state int64_t resultSize = 0;
+	state int64_t keysSize = 0;
+	Span span("SS:getValues"_loc, req.spanContext);
+
+	try {
+		++data->counters.getValuesQueries;
+		data->counters.getValuesKeys += req.keys.size();
+		++data->counters.allQueries;
+		data->maxQueryQueue = std::max<int>(
+		    data->maxQueryQueue, data->counters.allQueries.getValue() - data->counters.finishedQueries.getValue());
+
+		// Active load balancing runs at a very high priority (to obtain accurate queue lengths)
+		// so we need to downgrade here
+		wait(data->getQueryDelay());
+		state PriorityMultiLock::Lock readLock = wait(data->getReadLock(req.options));
+
+		// Track time from requestTime through now as read queueing wait time
+		state double queueWaitEnd = g_network->timer();
+		data->counters.readLatencySamples.sample(
+		    queueWaitEnd - req.requestTime(), ReadLatencySamples::READ_QUEUE_WAIT, trackedReadType(req));
+
+		if (req.options.present() && req.options.get().debugID.present())
+			g_traceBatch.addEvent("GetValuesDebug", req.options.get().debugID.get().first(), "getValuesQ.DoRead");
+
+		Version commitVersion = getLatestCommitVersion(req.ssLatestCommitVersions, data->tag);
+		state Version version = wait(waitForVersion(data, commitVersion, req.version, req.spanContext));
+		data->counters.readLatencySamples.sample(
+		    g_network->timer() - queueWaitEnd, ReadLatencySamples::READ_VERSION_WAIT, trackedReadType(req));
+
+		state uint64_t changeCounter = data->shardChangeCounter;
+
+		for (const auto& key : req.keys) {
+			if (!data->shards[key]->isReadable()) {
+				throw wrong_shard_server();
+			}
+		}
+
+		// Look the keys up in key order, so that the storage engine gets them sorted
+		std::vector<std::pair<KeyRef, int>> sortedKeys;
+		sortedKeys.reserve(req.keys.size());
+		for (int i = 0; i < req.keys.size(); i++) {
+			sortedKeys.emplace_back(req.keys[i], i);
+		}
+		std::sort(sortedKeys.begin(), sortedKeys.end());
+
+		state std::vector<Optional<Value>> values(req.keys.size());
+		// The keys which the versioned data has nothing for at version, and the indexes of their values
+		state Standalone<VectorRef<KeyRef>> diskKeys;
+		state std::vector<int> diskIndexes;
+		state bool useValueCache =
+		    data->storage.valueCache.enabled() && (!req.options.present() || req.options.get().cacheResult);
+		state uint64_t valueCacheEpoch = data->storage.valueCache.getEpoch();
+		diskKeys.arena().dependsOn(req.arena);
+
+		StorageServer::VersionedData::ViewAtVersion view = data->data().at(version);
+		for (const auto& [key, index] : sortedKeys) {
+			auto i = view.lastLessOrEqual(key);
+			if (i && i->isValue() && i.key() == key) {
+				values[index] = (Value)i->getValue();
+			} else if (!i || !i->isClearTo() || i->getEndKey() <= key) {
+				if (useValueCache && data->storage.valueCache.get(key, values[index])) {
+					++data->counters.valueCacheHits;
+				} else {
+					diskKeys.push_back(diskKeys.arena(), key);
+					diskIndexes.push_back(index);
+				}
+			}
+		}
+
+		if (!diskKeys.empty()) {
+			std::vector<Optional<Value>> diskValues = wait(data->storage.readValues(diskKeys, req.options));
+			// Validate that while we were reading the data we didn't lose the version or shard
+			if (version < data->storageVersion()) {
+				CODE_PROBE(true, "transaction_too_old after readValues");
+				throw transaction_too_old();
+			}
+			for (const auto& key : diskKeys) {
+				data->checkChangeCounter(changeCounter, key);
+			}
+			for (int i = 0; i < diskKeys.size(); i++) {
+				data->counters.kvGetBytes += diskValues[i].expectedSize();
+				values[diskIndexes[i]] = diskValues[i];
+				if (useValueCache) {
+					++data->counters.valueCacheMisses;
+					data->counters.valueCacheEvictions +=
+					    data->storage.valueCache.add(diskKeys[i], diskValues[i], valueCacheEpoch);
+				}
+			}
+		}
+
+		bool cached = false;
+		for (int i = 0; i < req.keys.size(); i++) {
+			const KeyRef key = req.keys[i];
+			const Optional<Value>& v = values[i];
+			DEBUG_MUTATION("ShardGetValue",
+			               version,
+			               MutationRef(MutationRef::DebugKey, key, v.present() ? v.get() : "<null>"_sr),
+			               data->thisServerID);
+
+			keysSize += key.size();
+			if (v.present()) {
+				++data->counters.rowsQueried;
+				resultSize += v.get().size();
+				data->counters.bytesQueried += v.get().size();
+			} else {
+				++data->counters.emptyQueries;
+			}
+
+			if (SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+				// If the read yields no value, randomly sample the empty read.
+				int64_t bytesReadPerKSecond =
+				    v.present() ? std::max((int64_t)(key.size() + v.get().size()), SERVER_KNOBS->EMPTY_READ_PENALTY)
+				                : SERVER_KNOBS->EMPTY_READ_PENALTY;
+				data->metrics.notifyBytesReadPerKSecond(key, bytesReadPerKSecond);
+			}
+
+			// Check if the desired key might be cached
+			cached = cached || data->cachedRangeMap[key];
+		}
+
+		if (req.options.present() && req.options.get().debugID.present())
+			g_traceBatch.addEvent("GetValuesDebug", req.options.get().debugID.get().first(), "getValuesQ.AfterRead");
+
+		GetValuesReply reply(std::move(values), cached);
+		reply.penalty = data->getPenalty();
+		req.reply.send(reply);
+	} catch (Error& e) {
+		if (!canReplyWith(e))
+			throw;
+		data->sendErrorWithPenalty(req.reply, e, data->getPenalty());
+	}
+
+	// Key size is not included in "BytesQueried", but still contributes to cost,
+	// so it must be accounted for here.
+	data->transactionTagCounter.addRequest(req.tags, keysSize + resultSize);
+
+	++data->counters.finishedQueries;
+
+	double duration = g_network->timer() - req.requestTime();
+	data->counters.readLatencySamples.sample(duration, ReadLatencySamples::READ, trackedReadType(req));
+	data->counters.readLatencySamples.sample(duration, ReadLatencySamples::READ_VALUE, trackedReadType(req));
+	if (data->latencyBandConfig.present()) {
+		int maxReadBytes =
+		    data->latencyBandConfig.get().readConfig.maxReadBytes.orDefault(std::numeric_limits<int>::max());
+		data->counters.readLatencyBands.addMeasurement(duration, 1, Filtered(resultSize > maxReadBytes));
+	}
+
+	return Void();
+}
+
 // Pessimistic estimate the number of overhead bytes used by each
 // watch. Watch key references are stored in an AsyncMap<Key,bool>, and actors
 // must be kept alive until the watch is finished.
@@ -2833,6 +3080,25 @@ void merge(Arena& arena,
 	}
 }
 
+// Removes the rows of output from index begin on that do not match filter, and empties the values of the rest if the
+// filter only asks for keys. Returns the number of rows removed.
+int applyRangeReadFilter(Arena& arena,
+                         VectorRef<KeyValueRef, VecSerStrategy::String>& output,
+                         int begin,
+                         RangeReadFilterRef const& filter) {
+	// Rows are popped and pushed back rather than overwritten so that output keeps its serialized size up to date
+	std::vector<KeyValueRef> examined(output.begin() + begin, output.end());
+	while (output.size() > begin) {
+		output.pop_back();
+	}
+	for (const auto& kv : examined) {
+		if (filter.matches(kv)) {
+			output.push_back(arena, filter.keysOnly ? KeyValueRef(kv.key, ValueRef()) : kv);
+		}
+	}
+	return (int)examined.size() - (output.size() - begin);
+}
+
 static inline void copyOptionalValue(Arena* a,
                                      GetValueReqAndResultRef& getValue,
                                      const Optional<Value>& optionalValue) {
@@ -2896,6 +3162,7 @@ ACTOR Future<GetValueReqAndResultRef> quickGetValue(StorageServer* data,
 }
 
 // If limit>=0, it returns the first rows in the range (sorted ascending), otherwise the last rows (sorted descending).
+// If a filter is given, rows that do not match it are dropped from the result after they count against the limits.
 // readRange has O(|result|) + O(log |data|) cost
 ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
                                           Version version,
@@ -2903,7 +3170,8 @@ ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
                                           int limit,
                                           int* pLimitBytes,
                                           SpanContext parentSpan,
-                                          Optional<ReadOptions> options) {
+                                          Optional<ReadOptions> options,
+                                          Optional<RangeReadFilterRef> filter = Optional<RangeReadFilterRef>()) {
 	state GetKeyValuesReply result;
 	state StorageServer::VersionedData::ViewAtVersion view = data->data().at(version);
 	state StorageServer::VersionedData::iterator vCurrent = view.end();
@@ -2914,6 +3182,8 @@ ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
 	state Span span("SS:readRange"_loc, parentSpan);
 	state int resultLogicalSize = 0;
 	state int logicalSize = 0;
+	// the last row merged into the result, which is not necessarily the last row of the result if there is a filter
+	state Optional<KeyRef> lastScannedKey;
 
 	// for caching the storage queue results during the first PTree traversal
 	state VectorRef<KeyValueRef> resultCache;
@@ -3016,6 +3286,15 @@ ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
 				*pLimitBytes -= sizeof(KeyValueRef) + i->expectedSize();
 			}
 
+			if (result.data.size() > prevSize) {
+				lastScannedKey = result.data.end()[-1].key;
+				if (filter.present()) {
+					data->counters.filteredRowsScanned += result.data.size() - prevSize;
+					data->counters.filteredRowsDropped +=
+					    applyRangeReadFilter(result.arena, result.data, prevSize, filter.get());
+				}
+			}
+
 			if (limit <= 0 || *pLimitBytes <= 0) {
 				break;
 			}
@@ -3025,8 +3304,8 @@ ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
 
 			// if there might be more data, begin reading right after what we already found to find out
 			if (atStorageVersion.more) {
-				ASSERT(atStorageVersion.end()[-1].key.size() == result.data.end()[-1].key.size() &&
-				       atStorageVersion.end()[-1].key.endsWith(result.data.end()[-1].key));
+				ASSERT(atStorageVersion.end()[-1].key.size() == lastScannedKey.get().size() &&
+				       atStorageVersion.end()[-1].key.endsWith(lastScannedKey.get()));
 
 				readBegin = readBeginTemp = keyAfter(atStorageVersion.end()[-1].key);
 			}
@@ -3112,13 +3391,22 @@ ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
 				*pLimitBytes -= sizeof(KeyValueRef) + i->expectedSize();
 			}
 
+			if (result.data.size() > prevSize) {
+				lastScannedKey = result.data.end()[-1].key;
+				if (filter.present()) {
+					data->counters.filteredRowsScanned += result.data.size() - prevSize;
+					data->counters.filteredRowsDropped +=
+					    applyRangeReadFilter(result.arena, result.data, prevSize, filter.get());
+				}
+			}
+
 			if (limit >= 0 || *pLimitBytes <= 0) {
 				break;
 			}
 
 			if (atStorageVersion.more) {
-				ASSERT(atStorageVersion.end()[-1].key.size() == result.data.end()[-1].key.size() &&
-				       atStorageVersion.end()[-1].key.endsWith(result.data.end()[-1].key));
+				ASSERT(atStorageVersion.end()[-1].key.size() == lastScannedKey.get().size() &&
+				       atStorageVersion.end()[-1].key.endsWith(lastScannedKey.get()));
 
 				readEnd = atStorageVersion.end()[-1].key;
 			} else if (vCurrent && vCurrent->isClearTo()) {
@@ -3135,8 +3423,12 @@ ACTOR Future<GetKeyValuesReply> readRange(StorageServer* data,
 	data->readRangeKVPairsReturnedHistogram->sample(result.data.size());
 
 	// all but the last item are less than *pLimitBytes
-	ASSERT(result.data.size() == 0 || *pLimitBytes + result.data.end()[-1].expectedSize() + sizeof(KeyValueRef) > 0);
+	ASSERT(result.data.size() == 0 || filter.present() ||
+	       *pLimitBytes + result.data.end()[-1].expectedSize() + sizeof(KeyValueRef) > 0);
 	result.more = limit == 0 || *pLimitBytes <= 0; // FIXME: Does this have to be exact?
+	if (filter.present() && result.more) {
+		result.lastScannedKey = lastScannedKey;
+	}
 	result.version = version;
 	return result;
 }
@@ -3476,8 +3768,14 @@ ACTOR Future<Void> getKeyValuesQ(StorageServer* data, GetKeyValuesRequest req)
 			state int remainingLimitBytes = req.limitBytes;
 
 			state double kvReadRange = g_network->timer();
-			GetKeyValuesReply _r = wait(readRange(
-			    data, version, KeyRangeRef(begin, end), req.limit, &remainingLimitBytes, span.context, req.options));
+			GetKeyValuesReply _r = wait(readRange(data,
+			                                      version,
+			                                      KeyRangeRef(begin, end),
+			                                      req.limit,
+			                                      &remainingLimitBytes,
+			                                      span.context,
+			                                      req.options,
+			                                      req.filter));
 			const double duration = g_network->timer() - kvReadRange;
 			data->counters.readLatencySamples.sample(duration, ReadLatencySamples::KV_READ_RANGE, trackedReadType(req));
 			GetKeyValuesReply r = _r;
@@ -3509,7 +3807,24 @@ ACTOR Future<Void> getKeyValuesQ(StorageServer* data, GetKeyValuesRequest req)
 				data->counters.kvFetchBytesServed += (totalByteSize + (8 - (int)sizeof(KeyValueRef)) * r.data.size());
 			}
 
-			if (totalByteSize > 0 && SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+			if (req.filter.present()) {
+				// A filtered read costs every row it scanned, not just the rows it returned, so bill the scanned bytes
+				// to the ends of the scanned part of the range
+				const int64_t scannedByteSize = req.limitBytes - remainingLimitBytes;
+				if (scannedByteSize > 0 && SERVER_KNOBS->READ_SAMPLING_ENABLED) {
+					KeyRef scannedBegin = begin;
+					KeyRef scannedLast = r.data.empty() ? begin : r.data[r.data.size() - 1].key;
+					if (req.limit < 0) {
+						scannedBegin = r.lastScannedKey.present() ? r.lastScannedKey.get() : begin;
+						scannedLast = r.data.empty() ? scannedBegin : r.data[0].key;
+					} else if (r.lastScannedKey.present()) {
+						scannedLast = r.lastScannedKey.get();
+					}
+					int64_t bytesReadPerKSecond = std::max(scannedByteSize, SERVER_KNOBS->EMPTY_READ_PENALTY) / 2;
+					data->metrics.notifyBytesReadPerKSecond(scannedBegin, bytesReadPerKSecond);
+					data->metrics.notifyBytesReadPerKSecond(scannedLast, bytesReadPerKSecond);
+				}
+			} else if (totalByteSize > 0 && SERVER_KNOBS->READ_SAMPLING_ENABLED) {
 				int64_t bytesReadPerKSecond = std::max(totalByteSize, SERVER_KNOBS->EMPTY_READ_PENALTY) / 2;
 				data->metrics.notifyBytesReadPerKSecond(r.data[0].key, bytesReadPerKSecond);
 				data->metrics.notifyBytesReadPerKSecond(r.data[r.data.size() - 1].key, bytesReadPerKSecond);
@@ -5465,6 +5780,105 @@ ACTOR Future<Void> mapSubquery(StorageServer* data,
 	return Void();
 }
 
+// Issues the secondary queries of a batch of index rows and fills their results into "kvms". Rows that map to the same
+// key share one subquery. If QUICK_GET_VALUE_BATCH_LOCAL is set, the point reads of keys in readable shards are served
+// by one local GetValuesRequest, and only the other keys, or all of them if that request fails, go through
+// quickGetValue.
+ACTOR Future<Void> mapSubqueries(StorageServer* data,
+                                 Version version,
+                                 GetMappedKeyValuesRequest* pOriginalReq,
+                                 Arena* pArena,
+                                 bool isRangeQuery,
+                                 KeyValueRef* rows,
+                                 std::vector<MappedKeyValueRef>* kvms,
+                                 std::vector<Key> mappedKeys) {
+	state int n = mappedKeys.size();
+	// The row whose subquery serves each row
+	state std::vector<int> leaders(n);
+	state std::vector<Future<Void>> subqueries;
+	state Standalone<VectorRef<KeyRef>> localKeys;
+	state std::vector<int> localLeaders;
+	state double localStart = g_network->timer();
+	state bool servedLocally = false;
+
+	std::vector<std::pair<KeyRef, int>> sortedKeys;
+	sortedKeys.reserve(n);
+	for (int i = 0; i < n; i++) {
+		sortedKeys.emplace_back(mappedKeys[i], i);
+	}
+	std::sort(sortedKeys.begin(), sortedKeys.end());
+	for (int j = 0; j < n; j++) {
+		const int i = sortedKeys[j].second;
+		if (j > 0 && sortedKeys[j].first == sortedKeys[j - 1].first) {
+			leaders[i] = leaders[sortedKeys[j - 1].second];
+			++data->counters.mappedSubqueriesCoalesced;
+			continue;
+		}
+		leaders[i] = i;
+		if (!isRangeQuery && SERVER_KNOBS->QUICK_GET_VALUE_BATCH_LOCAL && data->shards[mappedKeys[i]]->isReadable()) {
+			localKeys.arena().dependsOn(mappedKeys[i].arena());
+			localKeys.push_back(localKeys.arena(), mappedKeys[i]);
+			localLeaders.push_back(i);
+		} else {
+			subqueries.push_back(
+			    mapSubquery(data, version, pOriginalReq, pArena, isRangeQuery, &rows[i], &(*kvms)[i], mappedKeys[i]));
+		}
+	}
+
+	if (!localKeys.empty()) {
+		++data->counters.quickGetValueBatches;
+		try {
+			// Like quickGetValue, this does not use readGuard: throttling is enforced on the original request.
+			GetValuesRequest req(pOriginalReq->spanContext,
+			                     localKeys,
+			                     version,
+			                     pOriginalReq->tags,
+			                     pOriginalReq->options,
+			                     VersionVector());
+			data->actors.add(getValuesQ(data, req));
+			GetValuesReply reply = wait(req.reply.getFuture());
+			if (!reply.error.present()) {
+				const double duration = g_network->timer() - localStart;
+				for (int j = 0; j < localLeaders.size(); j++) {
+					GetValueReqAndResultRef getValue;
+					getValue.key = localKeys[j];
+					copyOptionalValue(pArena, getValue, reply.values[j]);
+					(*kvms)[localLeaders[j]].reqAndResult = getValue;
+					++data->counters.quickGetValueHit;
+					data->counters.readLatencySamples.sample(
+					    duration, ReadLatencySamples::MAPPED_RANGE_LOCAL, trackedReadType(*pOriginalReq));
+				}
+				servedLocally = true;
+			}
+			// Otherwise fallback.
+		} catch (Error& e) {
+			if (e.code() == error_code_actor_cancelled) {
+				throw;
+			}
+			// Fallback.
+		}
+		if (!servedLocally) {
+			for (int i : localLeaders) {
+				subqueries.push_back(mapSubquery(
+				    data, version, pOriginalReq, pArena, isRangeQuery, &rows[i], &(*kvms)[i], mappedKeys[i]));
+			}
+		}
+	}
+
+	wait(waitForAll(subqueries));
+	for (int i = 0; i < n; i++) {
+		if (leaders[i] != i) {
+			MappedKeyValueRef& kvm = (*kvms)[i];
+			kvm.reqAndResult = (*kvms)[leaders[i]].reqAndResult;
+			if (isRangeQuery) {
+				kvm.key = rows[i].key;
+				kvm.value = rows[i].value;
+			}
+		}
+	}
+	return Void();
+}
+
 int getMappedKeyValueSize(MappedKeyValueRef mappedKeyValue) {
 	auto& reqAndResult = mappedKeyValue.reqAndResult;
 	int bytes = 0;
@@ -5510,7 +5924,6 @@ ACTOR Future<GetMappedKeyValuesReply> mapKeyValues(StorageServer* data,
 	state int sz = input.data.size();
 	const int k = std::min(sz, SERVER_KNOBS->MAX_PARALLEL_QUICK_GET_VALUE);
 	state std::vector<MappedKeyValueRef> kvms(k);
-	state std::vector<Future<Void>> subqueries;
 	state int offset = 0;
 	if (pOriginalReq->options.present() && pOriginalReq->options.get().debugID.present())
 		g_traceBatch.addEvent("TransactionDebug",
@@ -5519,6 +5932,7 @@ ACTOR Future<GetMappedKeyValuesReply> mapKeyValues(StorageServer* data,
 
 	for (; (offset < sz) && (*remainingLimitBytes > 0); offset += SERVER_KNOBS->MAX_PARALLEL_QUICK_GET_VALUE) {
 		// Divide into batches of MAX_PARALLEL_QUICK_GET_VALUE subqueries
+		std::vector<Key> mappedKeys;
 		for (int i = 0; i + offset < sz && i < SERVER_KNOBS->MAX_PARALLEL_QUICK_GET_VALUE; i++) {
 			KeyValueRef* it = &input.data[i + offset];
 			MappedKeyValueRef* kvm = &kvms[i];
@@ -5532,15 +5946,20 @@ ACTOR Future<GetMappedKeyValuesReply> mapKeyValues(StorageServer* data,
 			// std::cout << "key:" << printable(kvm->key) << ", value:" << printable(kvm->value)
 			//          << ", mappedKey:" << printable(mappedKey) << std::endl;
 
-			subqueries.push_back(
-			    mapSubquery(data, input.version, pOriginalReq, &result.arena, isRangeQuery, it, kvm, mappedKey));
+			mappedKeys.push_back(mappedKey);
 		}
-		wait(waitForAll(subqueries));
+		wait(mapSubqueries(data,
+		                   input.version,
+		                   pOriginalReq,
+		                   &result.arena,
+		                   isRangeQuery,
+		                   &input.data[offset],
+		                   &kvms,
+		                   std::move(mappedKeys)));
 		if (pOriginalReq->options.present() && pOriginalReq->options.get().debugID.present())
 			g_traceBatch.addEvent("TransactionDebug",
 			                      pOriginalReq->options.get().debugID.get().first(),
 			                      "storageserver.mapKeyValues.AfterBatch");
-		subqueries.clear();
 		for (int i = 0; i + offset < sz && i < SERVER_KNOBS->MAX_PARALLEL_QUICK_GET_VALUE; i++) {
 			// since we always read the index, so always consider the index size
 			int indexSize = sizeof(KeyValueRef) + input.data[i + offset].expectedSize();
@@ -6147,6 +6566,9 @@ bool changeDurableVersion(StorageServer* data, Version desiredDurableVersion) {
 				}
 			}
 		}
+		// The erases above copy nodes at the next version, which is charged here and released when it is durable
+		data->chargeVersionedDataNodeBytes();
+		bytesDurable += data->releaseVersionedDataNodeBytes(nextDurableVersion);
 		data->counters.bytesDurable += bytesDurable;
 	}
 
@@ -6388,6 +6810,7 @@ void removeDataRange(StorageServer* ss,
 	}
 
 	data.erase(range.begin, range.end);
+	ss->chargeVersionedDataNodeBytes();
 }
 
 void setAvailableStatus(StorageServer* self, KeyRangeRef keys, bool available);
@@ -6470,11 +6893,17 @@ ACTOR Future<Void> logFetchKeysWarning(AddingShard* shard) {
 
 		const auto traceEventLevel =
 		    waitSeconds > SERVER_KNOBS->FETCH_KEYS_TOO_LONG_TIME_CRITERIA ? SevWarnAlways : SevInfo;
+		const double fetchingDuration = shard->fetchingStartTime > 0 ? now() - shard->fetchingStartTime : 0;
 		TraceEvent(traceEventLevel, "FetchKeysTooLong")
 		    .detail("Duration", now() - startTime)
 		    .detail("Phase", shard->phase)
 		    .detail("Begin", shard->keys.begin)
-		    .detail("End", shard->keys.end);
+		    .detail("End", shard->keys.end)
+		    .detail("FetchedBytes", shard->fetchedBytes)
+		    .detail("FetchedRows", shard->fetchedRows)
+		    .detail("Rate", fetchingDuration > 0 ? shard->fetchedBytes / fetchingDuration : 0)
+		    .detail("FetchedThrough", shard->fetchedThrough)
+		    .detail("BlocksAhead", shard->blocksAhead);
 	}
 }
 
@@ -6556,6 +6985,126 @@ ACTOR Future<Void> tryGetRange(PromiseStream<RangeResult> results, Transaction*
 	}
 }
 
+// A block of rows fetched for an AddingShard. Writing it replaces the data in range, after which all keys before
+// readThrough, back to the beginning of the range the block was read from, have been fetched.
+struct FetchedBlock {
+	KeyRange range;
+	Key readThrough;
+	RangeResult data;
+};
+
+// Forwards the blocks of a read of keys, which arrive in key order, to blocks along with the part of keys each one
+// replaces. Returns when results ends.
+ACTOR Future<Void> forwardFetchedBlocks(FutureStream<RangeResult> results,
+                                        KeyRange keys,
+                                        PromiseStream<FetchedBlock> blocks) {
+	state Key blockBegin = keys.begin;
+	loop {
+		state RangeResult block;
+		try {
+			RangeResult b = waitNext(results);
+			block = b;
+		} catch (Error& e) {
+			if (e.code() == error_code_end_of_stream) {
+				return Void();
+			}
+			throw;
+		}
+
+		FetchedBlock fetched;
+		fetched.range = KeyRangeRef(blockBegin, block.size() > 0 && block.more ? keyAfter(block.back().key) : keys.end);
+		if (block.more) {
+			fetched.readThrough = block.getReadThrough();
+		} else {
+			ASSERT(!block.readThrough.present());
+			fetched.readThrough = keys.end;
+		}
+		fetched.data = block;
+		blockBegin = fetched.readThrough;
+		blocks.send(fetched);
+	}
+}
+
+// Forwards all the blocks of results, which reader produces from a read of keys, then ends blocks.
+ACTOR Future<Void> forwardAllFetchedBlocks(Future<Void> reader,
+                                           PromiseStream<RangeResult> results,
+                                           KeyRange keys,
+                                           PromiseStream<FetchedBlock> blocks) {
+	try {
+		wait(forwardFetchedBlocks(results.getFuture(), keys, blocks));
+		blocks.sendError(end_of_stream());
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) {
+			throw;
+		}
+		blocks.sendError(e);
+		throw;
+	}
+	return Void();
+}
+
+// Reads the ranges after *next one at a time, sending their blocks to blocks.
+ACTOR Future<Void> fetchRanges(PromiseStream<FetchedBlock> blocks,
+                               Transaction* tr,
+                               std::vector<KeyRange>* ranges,
+                               int* next) {
+	loop {
+		if (*next >= ranges->size()) {
+			return Void();
+		}
+		state KeyRange range = (*ranges)[(*next)++];
+		state PromiseStream<RangeResult> results;
+		state Future<Void> hold = tryGetRange(results, tr, range);
+		wait(forwardFetchedBlocks(results.getFuture(), range, blocks));
+	}
+}
+
+// Reads keys through tr, sending its blocks to blocks. If FETCH_KEYS_PARALLEL_RANGES is more than one, keys is split
+// at getRangeSplitPoints and that many of the sub-ranges are read at once, which load balancing spreads over the source
+// replicas. Blocks of a sub-range arrive in key order, but blocks of different sub-ranges do not.
+ACTOR Future<Void> fetchRangeBlocks(PromiseStream<FetchedBlock> blocks, Transaction* tr, KeyRange keys) {
+	state std::vector<KeyRange> ranges;
+	state std::vector<Future<Void>> fetchers;
+	state int next = 0;
+	try {
+		if (SERVER_KNOBS->FETCH_KEYS_PARALLEL_RANGES > 1) {
+			try {
+				Standalone<VectorRef<KeyRef>> splitPoints =
+				    wait(tr->getRangeSplitPoints(keys, SERVER_KNOBS->FETCH_KEYS_PARALLEL_RANGE_BYTES));
+				if (splitPoints.size() >= 2 && splitPoints.front() == keys.begin && splitPoints.back() == keys.end) {
+					for (int i = 0; i + 1 < splitPoints.size(); i++) {
+						if (splitPoints[i] < splitPoints[i + 1]) {
+							ranges.push_back(KeyRangeRef(splitPoints[i], splitPoints[i + 1]));
+						}
+					}
+				}
+			} catch (Error& e) {
+				if (e.code() == error_code_actor_cancelled) {
+					throw;
+				}
+				// Read keys as a single range
+				ranges.clear();
+			}
+		}
+		if (ranges.empty()) {
+			ranges.push_back(keys);
+		}
+
+		for (int i = 0; i < std::min<int>(ranges.size(), SERVER_KNOBS->FETCH_KEYS_PARALLEL_RANGES); i++) {
+			fetchers.push_back(fetchRanges(blocks, tr, &ranges, &next));
+		}
+		wait(waitForAll(fetchers));
+		blocks.sendError(end_of_stream());
+	} catch (Error& e) {
+		if (e.code() == error_code_actor_cancelled) {
+			throw;
+		}
+		blocks.sendError(e);
+		throw;
+	}
+	return Void();
+}
+
 bool fetchKeyCanRetry(const Error& e) {
 	switch (e.code()) {
 	case error_code_end_of_stream:
@@ -7054,8 +7603,8 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 			tr.setVersion(fetchVersion);
 
 			state PromiseStream<RangeResult> results;
+			state PromiseStream<FetchedBlock> blocks;
 			state Future<Void> hold;
-			state KeyRef rangeEnd;
 			if (conductBulkLoad) {
 				ASSERT(dataMoveIdIsValidForBulkLoad(dataMoveId)); // TODO(BulkLoad): remove dangerous assert
 				// Get the bulkload task metadata from the data move metadata. Note that a SS can receive a data move
@@ -7115,6 +7664,7 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 					    .detail("FKID", fetchKeysID);
 					// Clear the key range before ingestion. This mirrors the replaceRange done in the case were
 					// we do not ingest SST files.
+					data->storage.valueCache.invalidate(keys);
 					data->storage.getKeyValueStore()->clear(keys);
 
 					// Now wait on the durableVersion to be updated so clear has been committed.
@@ -7127,6 +7677,7 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 					// Measure duration at this level so we capture the inter-thread handoff time.
 					state double ingestStartTime = g_network->timer(); // Record start time
 					wait(data->storage.getKeyValueStore()->ingestSSTFiles(localBulkLoadFileSets));
+					data->storage.valueCache.invalidate(keys);
 					const double ingestDuration = g_network->timer() - ingestStartTime;
 					data->counters.ingestDurationLatencySample->addMeasurement(ingestDuration);
 
@@ -7153,15 +7704,22 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 						    .detail("AllFilesContained", allFilesContained)
 						    .detail("FKID", fetchKeysID);
 					}
-					hold = tryGetRangeForBulkLoad(results, keys, localBulkLoadFileSets);
-					rangeEnd = keys.end;
+					hold = forwardAllFetchedBlocks(
+					    tryGetRangeForBulkLoad(results, keys, localBulkLoadFileSets), results, keys, blocks);
 				}
 			} else {
-				hold = tryGetRange(results, &tr, keys);
-				rangeEnd = keys.end;
+				hold = fetchRangeBlocks(blocks, &tr, keys);
 			}
 
+			// Keys before blockBegin have all been written to storage. blocksAhead holds the ranges, from their begin
+			// keys to the keys they were read through, of the blocks written past it.
 			state Key blockBegin = keys.begin;
+			state std::map<Key, Key> blocksAhead;
+			if (shard->fetchingStartTime == 0) {
+				shard->fetchingStartTime = now();
+			}
+			shard->fetchedThrough = blockBegin;
+			shard->blocksAhead = 0;
 
 			try {
 				loop {
@@ -7174,7 +7732,8 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 						delays.push_back(data->fetchKeysBudgetUsed.onChange());
 						wait(waitForAll(delays));
 					}
-					state RangeResult this_block = waitNext(results.getFuture());
+					state FetchedBlock fetched = waitNext(blocks.getFuture());
+					state RangeResult this_block = fetched.data;
 
 					state int expectedBlockSize =
 					    (int)this_block.expectedSize() + (8 - (int)sizeof(KeyValueRef)) * this_block.size();
@@ -7185,6 +7744,7 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 					    .detail("BlockBytes", expectedBlockSize)
 					    .detail("KeyBegin", keys.begin)
 					    .detail("KeyEnd", keys.end)
+					    .detail("BlockBegin", fetched.range.begin)
 					    .detail("Last", this_block.size() ? this_block.end()[-1].key : std::string())
 					    .detail("Version", fetchVersion)
 					    .detail("More", this_block.more)
@@ -7220,9 +7780,7 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 
 					// Write this_block to storage
 					state Standalone<VectorRef<KeyValueRef>> blockData(this_block, this_block.arena());
-					state Key blockEnd =
-					    this_block.size() > 0 && this_block.more ? keyAfter(this_block.back().key) : keys.end;
-					state KeyRange blockRange(KeyRangeRef(blockBegin, blockEnd));
+					state KeyRange blockRange = fetched.range;
 					wait(data->storage.replaceRange(blockRange, blockData));
 
 					if (conductBulkLoad) {
@@ -7241,13 +7799,23 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 						data->byteSampleApplySet(*kvItr, invalidVersion);
 					}
 
-					if (this_block.more) {
-						blockBegin = this_block.getReadThrough();
+					if (fetched.range.begin == blockBegin) {
+						blockBegin = fetched.readThrough;
+						for (auto ahead = blocksAhead.find(blockBegin); ahead != blocksAhead.end();
+						     ahead = blocksAhead.find(blockBegin)) {
+							blockBegin = ahead->second;
+							blocksAhead.erase(ahead);
+						}
 					} else {
-						ASSERT(!this_block.readThrough.present());
-						blockBegin = rangeEnd;
+						ASSERT(fetched.range.begin > blockBegin);
+						blocksAhead[fetched.range.begin] = fetched.readThrough;
 					}
+					shard->fetchedBytes += expectedBlockSize;
+					shard->fetchedRows += this_block.size();
+					shard->fetchedThrough = blockBegin;
+					shard->blocksAhead = blocksAhead.size();
 					this_block = RangeResult();
+					fetched = FetchedBlock();
 
 					++data->counters.kvClearRangesInFetchKeys;
 					data->fetchKeysTotalCommitBytes += expectedBlockSize;
@@ -7262,6 +7830,16 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 					data->counters.fetchKeyErrors += 1;
 				}
 				lastError = e;
+				if (!blocksAhead.empty()) {
+					// Blocks past blockBegin were written before the blocks in front of them. Clear them, so that
+					// whichever fetchKeys reads the keys after blockBegin again starts from empty storage.
+					CODE_PROBE(true, "fetchKeys clears blocks fetched out of order");
+					KeyRange ahead = KeyRangeRef(blockBegin, keys.end);
+					data->storage.clearRange(ahead);
+					++data->counters.kvSystemClearRanges;
+					data->byteSampleApplyClear(ahead, invalidVersion);
+					blocksAhead.clear();
+				}
 				if (lastError.code() == error_code_storage_replica_comparison_error) {
 					// The inconsistency could be because of the inclusion of a rolled back
 					// transaction(s)/version(s) in the returned results. Retry.
@@ -7360,6 +7938,7 @@ ACTOR Future<Void> fetchKeys(StorageServer* data, AddingShard* shard) {
 		const double duration = now() - startTime;
 		TraceEvent(SevInfo, "FetchKeysStats", data->thisServerID)
 		    .detail("TotalBytes", totalBytes)
+		    .detail("FetchedRows", shard->fetchedRows)
 		    .detail("Duration", duration)
 		    .detail("Rate", static_cast<double>(totalBytes) / duration)
 		    .detail("FKID", fetchKeysID);
@@ -9210,6 +9789,7 @@ void StorageServer::addMutation(Version version,
 	    .detail("ShardEnd", shard.end);
 
 	applyMutation(this, expanded, mLog.arena(), mutableData(), version);
+	chargeVersionedDataNodeBytes();
 }
 
 struct OrderByVersion {
@@ -10750,6 +11330,7 @@ void setRangeBasedBulkLoadStatus(StorageServer* self, KeyRangeRef keys, const SS
 }
 
 void StorageServerDisk::clearRange(KeyRangeRef keys) {
+	valueCache.invalidate(keys);
 	storage->clear(keys);
 	++(*kvClearRanges);
 	if (keys.singleKeyRange()) {
@@ -10758,15 +11339,18 @@ void StorageServerDisk::clearRange(KeyRangeRef keys) {
 }
 
 void StorageServerDisk::writeKeyValue(KeyValueRef kv) {
+	valueCache.invalidate(kv.key);
 	storage->set(kv);
 	*kvCommitLogicalBytes += kv.expectedSize();
 }
 
 void StorageServerDisk::writeMutation(MutationRef mutation) {
 	if (mutation.type == MutationRef::SetValue) {
+		valueCache.invalidate(mutation.param1);
 		storage->set(KeyValueRef(mutation.param1, mutation.param2));
 		*kvCommitLogicalBytes += mutation.expectedSize();
 	} else if (mutation.type == MutationRef::ClearRange) {
+		valueCache.invalidate(KeyRangeRef(mutation.param1, mutation.param2));
 		storage->clear(KeyRangeRef(mutation.param1, mutation.param2));
 		++(*kvClearRanges);
 		if (KeyRangeRef(mutation.param1, mutation.param2).singleKeyRange()) {
@@ -10806,9 +11390,11 @@ void StorageServerDisk::writeMutations(const VectorRef<MutationRef>& mutations,
 		DEBUG_MUTATION(debugContext, debugVersion, m, data->thisServerID);
 		ASSERT(m.validateChecksum());
 		if (m.type == MutationRef::SetValue) {
+			valueCache.invalidate(m.param1);
 			storage->set(KeyValueRef(m.param1, m.param2));
 			*kvCommitLogicalBytes += m.expectedSize();
 		} else if (m.type == MutationRef::ClearRange) {
+			valueCache.invalidate(KeyRangeRef(m.param1, m.param2));
 			storage->clear(KeyRangeRef(m.param1, m.param2));
 			++(*kvClearRanges);
 			if (KeyRangeRef(m.param1, m.param2).singleKeyRange()) {
@@ -10818,6 +11404,48 @@ void StorageServerDisk::writeMutations(const VectorRef<MutationRef>& mutations,
 	}
 }
 
+// Writes the mutations of the versions after prevStorageVersion, up to newStorageVersion, until they add up to
+// STORAGE_COALESCE_WRITE_BYTES or use up the commit budget, as one coalesced set of writes. The budget is charged for
+// every mutation of those versions, as if they had been written one by one.
+void StorageServerDisk::writeCoalescedVersions(Version& prevStorageVersion,
+                                               Version newStorageVersion,
+                                               int64_t& bytesLeft,
+                                               UnlimitedCommitBytes unlimitedCommitBytes,
+                                               int64_t& clearRangesLeft) {
+	MutationCoalescer coalescer;
+	int64_t coalescedBytes = 0;
+	auto u = data->getMutationLog().upper_bound(prevStorageVersion);
+	for (; u != data->getMutationLog().end() && u->first <= newStorageVersion; ++u) {
+		VerUpdateRef const& v = u->second;
+		ASSERT(v.version > prevStorageVersion && v.version <= newStorageVersion);
+		for (const auto& m : v.mutations) {
+			DEBUG_MUTATION("makeVersionDurable", v.version, m, data->thisServerID);
+			ASSERT(m.validateChecksum());
+			if (m.type == MutationRef::SetValue || m.type == MutationRef::ClearRange) {
+				coalescer.add(m);
+			}
+			bytesLeft -= mvccStorageBytes(m);
+			coalescedBytes += mvccStorageBytes(m);
+			if (m.type == MutationRef::ClearRange)
+				--clearRangesLeft;
+		}
+		prevStorageVersion = v.version;
+		if (coalescedBytes >= SERVER_KNOBS->STORAGE_COALESCE_WRITE_BYTES ||
+		    (!unlimitedCommitBytes && (bytesLeft <= 0 || clearRangesLeft <= 0))) {
+			break;
+		}
+	}
+
+	int64_t bytesWritten = 0;
+	const std::vector<MutationRef> mutations = coalescer.getMutations();
+	for (const auto& m : mutations) {
+		writeMutation(m);
+		bytesWritten += m.expectedSize();
+	}
+	*kvCoalescedMutations += coalescer.getMutationsAdded() - (int)mutations.size();
+	*kvCoalescedBytes += coalescer.getBytesAdded() - bytesWritten;
+}
+
 bool StorageServerDisk::makeVersionMutationsDurable(Version& prevStorageVersion,
                                                     Version newStorageVersion,
                                                     int64_t& bytesLeft,
@@ -10844,6 +11472,10 @@ bool StorageServerDisk::makeVersionMutationsDurable(Version& prevStorageVersion,
 		ASSERT(v.version > prevStorageVersion && v.version <= newStorageVersion);
 		// TODO(alexmiller): Update to version tracking.
 		// DEBUG_KEY_RANGE("makeVersionMutationsDurable", v.version, KeyRangeRef());
+		if (SERVER_KNOBS->STORAGE_COALESCE_WRITE_BYTES > 0 && !SimBugInjector().isEnabled()) {
+			writeCoalescedVersions(prevStorageVersion, newStorageVersion, bytesLeft, unlimitedCommitBytes, clearRangesLeft);
+			return false;
+		}
 		if (!SimBugInjector().isEnabled()) {
 			writeMutations(v.mutations, v.version, "makeVersionDurable");
 		} else {
@@ -11713,6 +12345,16 @@ ACTOR Future<Void> serveGetValueRequests(StorageServer* self, FutureStream<GetVa
 	}
 }
 
+ACTOR Future<Void> serveGetValuesRequests(StorageServer* self, FutureStream<GetValuesRequest> getValues) {
+	getCurrentLineage()->modify(&TransactionLineage::operation) = TransactionLineage::Operation::GetValue;
+	loop {
+		GetValuesRequest req = waitNext(getValues);
+		// Warning: This code is executed at extremely high priority (TaskPriority::LoadBalancedEndpoint), so
+		// downgrade before doing real work
+		self->actors.add(self->readGuard(req, getValuesQ));
+	}
+}
+
 ACTOR Future<Void> serveGetKeyValuesRequests(StorageServer* self, FutureStream<GetKeyValuesRequest> getKeyValues) {
 	getCurrentLineage()->modify(&TransactionLineage::operation) = TransactionLineage::Operation::GetKeyValues;
 	loop {
@@ -12044,6 +12686,7 @@ ACTOR Future<Void> storageServerCore(StorageServer* self, StorageServerInterface
 	self->actors.add(logLongByteSampleRecovery(self->byteSampleRecovery));
 	self->actors.add(checkBehind(self));
 	self->actors.add(serveGetValueRequests(self, ssi.getValue.getFuture()));
+	self->actors.add(serveGetValuesRequests(self, ssi.getValues.getFuture()));
 	self->actors.add(serveGetKeyValuesRequests(self, ssi.getKeyValues.getFuture()));
 	self->actors.add(serveGetMappedKeyValuesRequests(self, ssi.getMappedKeyValues.getFuture()));
 	self->actors.add(serveGetKeyValuesStreamRequests(self, ssi.getKeyValuesStream.getFuture()));
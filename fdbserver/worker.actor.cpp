@@ -1753,6 +1753,7 @@ ACTOR Future<Void> storageServerRollbackRebooter(std::set<std::pair<UID, KeyValu
 		recruited.initEndpoints();
 
 		DUMPTOKEN(recruited.getValue);
+		DUMPTOKEN(recruited.getValues);
 		DUMPTOKEN(recruited.getKey);
 		DUMPTOKEN(recruited.getKeyValues);
 		DUMPTOKEN(recruited.getMappedKeyValues);
@@ -2339,6 +2340,7 @@ ACTOR Future<Void> workerServer(Reference<IClusterConnectionRecord> connRecord,
 				startRole(ssRole, recruited.id(), interf.id(), details, "Restored");
 
 				DUMPTOKEN(recruited.getValue);
+				DUMPTOKEN(recruited.getValues);
 				DUMPTOKEN(recruited.getKey);
 				DUMPTOKEN(recruited.getKeyValues);
 				DUMPTOKEN(recruited.getMappedKeyValues);
@@ -2837,6 +2839,7 @@ ACTOR Future<Void> workerServer(Reference<IClusterConnectionRecord> connRecord,
 					    .detail("WorkerID", interf.id());
 
 					DUMPTOKEN(recruited.getValue);
+					DUMPTOKEN(recruited.getValues);
 					DUMPTOKEN(recruited.getKey);
 					DUMPTOKEN(recruited.getKeyValues);
 					DUMPTOKEN(recruited.getMappedKeyValues);
@@ -0,0 +1,278 @@
+/*
+ * RangeReadFilter.actor.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "fdbclient/KeyRangeMap.h"
+#include "fdbclient/NativeAPI.actor.h"
+#include "fdbclient/RangeReadFilter.h"
+#include "fdbclient/StorageServerInterface.h"
+#include "fdbclient/SystemData.h"
+#include "fdbclient/Tuple.h"
+#include "fdbserver/Knobs.h"
+#include "fdbserver/workloads/workloads.actor.h"
+#include "flow/Error.h"
+#include "flow/IRandom.h"
+#include "flow/actorcompiler.h" // This must be the last #include.
+
+// Sends filtered GetKeyValuesRequests straight to the storage servers of each shard, resuming every read from
+// GetKeyValuesReply::lastScannedKey, and checks the rows against the filter applied to the data on the client.
+// Small limits make the storage servers stop reading before they find a matching row, so replies with no rows and
+// more set are exercised, forward and reverse.
+struct RangeReadFilterWorkload : TestWorkload {
+	static constexpr auto NAME = "RangeReadFilter";
+	int nodeCount;
+	int iterations;
+	int emptyContinuations = 0;
+	int mismatches = 0;
+
+	RangeReadFilterWorkload(WorkloadContext const& wcx) : TestWorkload(wcx) {
+		nodeCount = getOption(options, "nodeCount"_sr, 2000);
+		iterations = getOption(options, "iterations"_sr, 50);
+	}
+
+	Key keyForIndex(int i) const { return Tuple::makeTuple("RangeReadFilter"_sr, (int64_t)i).pack(); }
+	Value valueForIndex(int i) const {
+		return Tuple::makeTuple((int64_t)(i % 10), StringRef(std::string(i % 50, 'x'))).pack();
+	}
+
+	Future<Void> setup(Database const& cx) override { return clientId == 0 ? _setup(cx, this) : Void(); }
+
+	Future<Void> start(Database const& cx) override { return clientId == 0 ? _start(cx, this) : Void(); }
+
+	Future<bool> check(Database const& cx) override {
+		if (clientId != 0) {
+			return true;
+		}
+		if (emptyContinuations == 0) {
+			TraceEvent(SevError, "RangeReadFilterNoEmptyContinuations");
+		}
+		return emptyContinuations > 0 && mismatches == 0;
+	}
+
+	void getMetrics(std::vector<PerfMetric>& m) override {
+		m.emplace_back("Empty continuations", emptyContinuations, Averaged::False);
+	}
+
+	ACTOR static Future<Void> _setup(Database cx, RangeReadFilterWorkload* self) {
+		state int i = 0;
+		for (i = 0; i < self->nodeCount; i += 100) {
+			state Transaction tr(cx);
+			loop {
+				try {
+					for (int j = i; j < std::min(i + 100, self->nodeCount); j++) {
+						tr.set(self->keyForIndex(j), self->valueForIndex(j));
+					}
+					wait(tr.commit());
+					break;
+				} catch (Error& e) {
+					wait(tr.onError(e));
+				}
+			}
+		}
+		return Void();
+	}
+
+	TupleElementPredicateRef randomPredicate(Arena& arena, bool onValue) const {
+		auto op = (TupleElementPredicateRef::Op)deterministicRandom()->randomInt(0, 6);
+		int64_t operand = deterministicRandom()->randomInt(0, onValue ? 10 : nodeCount);
+		return TupleElementPredicateRef(arena, onValue, onValue ? 0 : 1, op, Tuple::makeTuple(operand).pack());
+	}
+
+	// The first iterations look for one row in ten three rows at a time, so most replies are empty with more set
+	Standalone<RangeReadFilterRef> filterForIteration(int iteration) const {
+		Standalone<RangeReadFilterRef> filter;
+		Arena& arena = filter.arena();
+		VectorRef<TupleElementPredicateRef> predicates;
+		if (iteration < 2) {
+			predicates.push_back(arena,
+			                     TupleElementPredicateRef(
+			                         arena, true, 0, TupleElementPredicateRef::EQ, Tuple::makeTuple((int64_t)9).pack()));
+			filter.tuplePredicates = predicates;
+			return filter;
+		}
+		if (deterministicRandom()->coinflip()) {
+			filter.keyPattern = StringRef(arena, Tuple::makeTuple("RangeReadFilter"_sr).pack());
+		}
+		if (deterministicRandom()->coinflip()) {
+			predicates.push_back(arena, randomPredicate(arena, false));
+		}
+		if (deterministicRandom()->coinflip()) {
+			predicates.push_back(arena, randomPredicate(arena, true));
+		}
+		filter.tuplePredicates = predicates;
+		if (deterministicRandom()->coinflip()) {
+			filter.minValueLength = deterministicRandom()->randomInt(0, 40);
+			filter.maxValueLength = filter.minValueLength + deterministicRandom()->randomInt(0, 40);
+		}
+		filter.keysOnly = deterministicRandom()->coinflip();
+		return filter;
+	}
+
+	// Reads [begin, end) from the storage servers with filter, one shard at a time. Rows come back in descending key
+	// order when limit is negative.
+	ACTOR static Future<Standalone<VectorRef<KeyValueRef>>> readFiltered(Database cx,
+	                                                                     RangeReadFilterWorkload* self,
+	                                                                     Key begin,
+	                                                                     Key end,
+	                                                                     Standalone<RangeReadFilterRef> filter,
+	                                                                     int limit,
+	                                                                     int limitBytes) {
+		state int retryCount = 0;
+		loop {
+			state Transaction tr(cx);
+			tr.setOption(FDBTransactionOptions::PRIORITY_SYSTEM_IMMEDIATE);
+			tr.setOption(FDBTransactionOptions::ACCESS_SYSTEM_KEYS);
+			state Standalone<VectorRef<KeyValueRef>> rows;
+			try {
+				state Version version = wait(tr.getReadVersion());
+				state RangeResult shards = wait(krmGetRanges(
+				    &tr, keyServersPrefix, KeyRangeRef(begin, end), CLIENT_KNOBS->TOO_MANY, CLIENT_KNOBS->TOO_MANY));
+				ASSERT(!shards.empty() && !shards.more);
+				state RangeResult UIDtoTagMap = wait(tr.getRange(serverTagKeys, CLIENT_KNOBS->TOO_MANY));
+				ASSERT(!UIDtoTagMap.more && UIDtoTagMap.size() < CLIENT_KNOBS->TOO_MANY);
+
+				state int s = 0;
+				for (s = 0; s < shards.size() - 1; s++) {
+					state int shard = limit > 0 ? s : shards.size() - 2 - s;
+					std::vector<UID> src;
+					std::vector<UID> dest;
+					UID srcId, destId;
+					decodeKeyServersValue(UIDtoTagMap, shards[shard].value, src, dest, srcId, destId);
+					Optional<Value> serverListValue =
+					    wait(tr.get(serverListKeyFor(deterministicRandom()->randomChoice(src))));
+					ASSERT(serverListValue.present());
+					state StorageServerInterface ssi = decodeServerListValue(serverListValue.get());
+
+					state Key readBegin = std::max<Key>(begin, shards[shard].key);
+					state Key readEnd = std::min<Key>(end, shards[shard + 1].key);
+					loop {
+						state GetKeyValuesRequest req;
+						req.begin = firstGreaterOrEqual(readBegin);
+						req.end = firstGreaterOrEqual(readEnd);
+						req.limit = limit;
+						req.limitBytes = limitBytes;
+						req.version = version;
+						req.tags = TagSet();
+						req.filter = RangeReadFilterRef(req.arena, filter);
+						if (SERVER_KNOBS->ENABLE_VERSION_VECTOR) {
+							cx->getLatestCommitVersion(ssi, req.version, req.ssLatestCommitVersions);
+						}
+						ErrorOr<GetKeyValuesReply> rep = wait(ssi.getKeyValues.getReplyUnlessFailedFor(req, 2, 0));
+						if (rep.isError()) {
+							throw rep.getError();
+						}
+						GetKeyValuesReply reply = rep.get();
+						if (reply.error.present()) {
+							throw reply.error.get();
+						}
+						rows.append(rows.arena(), reply.data.begin(), reply.data.size());
+						rows.arena().dependsOn(reply.arena);
+						if (!reply.more) {
+							break;
+						}
+						if (!reply.lastScannedKey.present()) {
+							TraceEvent(SevError, "RangeReadFilterNoLastScannedKey")
+							    .detail("Begin", readBegin)
+							    .detail("End", readEnd)
+							    .detail("Limit", limit);
+							self->mismatches++;
+							break;
+						}
+						if (reply.data.empty()) {
+							self->emptyContinuations++;
+						}
+						if (limit > 0) {
+							readBegin = keyAfter(reply.lastScannedKey.get());
+						} else {
+							readEnd = reply.lastScannedKey.get();
+						}
+					}
+				}
+				return rows;
+			} catch (Error& e) {
+				if (e.code() == error_code_actor_cancelled || ++retryCount > 20) {
+					throw;
+				}
+				TraceEvent(SevDebug, "RangeReadFilterRetry").errorUnsuppressed(e).detail("RetryCount", retryCount);
+				wait(delay(0.5));
+			}
+		}
+	}
+
+	ACTOR static Future<Void> _start(Database cx, RangeReadFilterWorkload* self) {
+		state int iteration = 0;
+		for (iteration = 0; iteration < self->iterations; iteration++) {
+			state Standalone<RangeReadFilterRef> filter = self->filterForIteration(iteration);
+			state int from = 0;
+			state int to = self->nodeCount;
+			state bool reverse = iteration == 1;
+			state int limit = 3;
+			state int limitBytes = CLIENT_KNOBS->REPLY_BYTE_LIMIT;
+			if (iteration >= 2) {
+				from = deterministicRandom()->randomInt(0, self->nodeCount);
+				to = deterministicRandom()->randomInt(from + 1, self->nodeCount + 1);
+				reverse = deterministicRandom()->coinflip();
+				limit = deterministicRandom()->randomInt(1, 51);
+				limitBytes = deterministicRandom()->randomInt(100, 5001);
+			}
+
+			state Standalone<VectorRef<KeyValueRef>> actual = wait(readFiltered(cx,
+			                                                                    self,
+			                                                                    self->keyForIndex(from),
+			                                                                    self->keyForIndex(to),
+			                                                                    filter,
+			                                                                    reverse ? -limit : limit,
+			                                                                    limitBytes));
+
+			Standalone<VectorRef<KeyValueRef>> expected;
+			for (int i = from; i < to; i++) {
+				const int n = reverse ? to - 1 - (i - from) : i;
+				const Key key = self->keyForIndex(n);
+				const Value value = self->valueForIndex(n);
+				if (filter.matches(KeyValueRef(key, value))) {
+					expected.push_back_deep(expected.arena(), KeyValueRef(key, filter.keysOnly ? ValueRef() : value));
+				}
+			}
+
+			bool same = actual.size() == expected.size();
+			for (int i = 0; same && i < actual.size(); i++) {
+				same = actual[i].key == expected[i].key && actual[i].value == expected[i].value;
+			}
+			if (!same) {
+				TraceEvent(SevError, "RangeReadFilterMismatch")
+				    .detail("Iteration", iteration)
+				    .detail("From", from)
+				    .detail("To", to)
+				    .detail("Reverse", reverse)
+				    .detail("Limit", limit)
+				    .detail("LimitBytes", limitBytes)
+				    .detail("KeysOnly", filter.keysOnly)
+				    .detail("Expected", expected.size())
+				    .detail("Actual", actual.size());
+				self->mismatches++;
+			}
+		}
+		TraceEvent("RangeReadFilterDone")
+		    .detail("Iterations", self->iterations)
+		    .detail("EmptyContinuations", self->emptyContinuations);
+		return Void();
+	}
+};
+
+WorkloadFactory<RangeReadFilterWorkload> RangeReadFilterWorkloadFactory;
@@ -78,6 +78,9 @@ public:
 	virtual Future<Void> zeroRange(int64_t offset, int64_t length);
 	virtual Future<Void> truncate(int64_t size) = 0;
 	virtual Future<Void> sync() = 0;
+	// Returns true if sync() also makes durable the writes which were issued but not yet completed when it was called,
+	// otherwise only the writes completed before the call are
+	virtual bool syncCoversPendingWrites() const { return false; }
 	virtual Future<Void> flush() {
 		return Void();
 	} // Sends previous writes to the OS if they have been buffered in memory, but does not make them power safe
@@ -173,6 +173,7 @@ public:
 		enGrpcState = 21,
 		enProxy = 22,
 		enS3FaultInjector = 23,
+		enLogRouterCache = 24,
 		COUNT // Add new fields before this enumerator
 	};
 
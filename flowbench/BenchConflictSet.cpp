@@ -19,6 +19,8 @@
  */
 
 #include "benchmark/benchmark.h"
+#include "fdbclient/CommitTransaction.h"
+#include "fdbserver/ConflictSet.h"
 #include "flow/IRandom.h"
 #include "flow/Error.h"
 #include <vector>
@@ -338,6 +340,75 @@ static void bench_ConflictDetection_Realistic(benchmark::State& state) {
 	state.SetItemsProcessed(state.iterations() * (writeRanges.size() + readRanges.size()));
 }
 
+// ============================================================================
+// Benchmarks - ConflictSet version history engines (SkipList vs BTree)
+// ============================================================================
+
+// Batches of transactions, each reading two random keys and writing one. Every key starts with the same
+// PrefixLength bytes, like tuple encoded keys of a single tenant or table do.
+struct ConflictSetWorkload {
+	Arena arena;
+	std::vector<std::vector<CommitTransactionRef>> batches;
+};
+
+template <int PrefixLength>
+static ConflictSetWorkload& getConflictSetWorkload() {
+	static ConflictSetWorkload workload = []() {
+		setThreadLocalDeterministicRandomSeed(PrefixLength + 1);
+		ConflictSetWorkload workload;
+		const std::string prefix(PrefixLength, 'p');
+		auto randomRange = [&]() {
+			std::string key = prefix + format("%08d", deterministicRandom()->randomInt(0, 1000000));
+			KeyRef begin = StringRef(workload.arena, key);
+			return KeyRangeRef(begin, keyAfter(begin, workload.arena));
+		};
+
+		workload.batches.resize(64);
+		for (auto& batch : workload.batches) {
+			batch.resize(500);
+			for (auto& tr : batch) {
+				tr.read_conflict_ranges.push_back(workload.arena, randomRange());
+				tr.read_conflict_ranges.push_back(workload.arena, randomRange());
+				tr.write_conflict_ranges.push_back(workload.arena, randomRange());
+			}
+		}
+		return workload;
+	}();
+	return workload;
+}
+
+template <ConflictSetType Type, int PrefixLength>
+static void bench_ConflictSet_detectConflicts(benchmark::State& state) {
+	auto& batches = getConflictSetWorkload<PrefixLength>().batches;
+	// Roughly a 5 second MVCC window of 100 batches/sec
+	const Version window = 500;
+
+	ConflictSet* cs = newConflictSet(Type);
+	Version version = 0;
+	int64_t transactions = 0;
+	for (auto _ : state) {
+		auto& batch = batches[version % batches.size()];
+		const Version newOldestVersion = std::max<Version>(0, version - window);
+		for (auto& tr : batch) {
+			tr.read_snapshot = std::max(newOldestVersion, version - 1);
+		}
+
+		ConflictBatch conflictBatch(cs);
+		for (const auto& tr : batch) {
+			conflictBatch.addTransaction(tr, newOldestVersion);
+		}
+		std::vector<int> nonConflicting;
+		conflictBatch.detectConflicts(version + 1, newOldestVersion, nonConflicting);
+		benchmark::DoNotOptimize(nonConflicting);
+
+		transactions += batch.size();
+		version++;
+	}
+	destroyConflictSet(cs);
+
+	state.SetItemsProcessed(transactions);
+}
+
 // ============================================================================
 // Benchmark registration - use BENCHMARK_TEMPLATE for templated functions
 // ============================================================================
@@ -375,4 +446,14 @@ BENCHMARK_TEMPLATE(bench_WordBitsetConflictSet_query, 10000, 100, 50)->Name("Wor
 
 // Realistic FoundationDB workload comparison
 BENCHMARK_TEMPLATE(bench_ConflictDetection_Realistic, 0)->Name("ConflictDetection/MiniConflictSet/realistic");
-BENCHMARK_TEMPLATE(bench_ConflictDetection_Realistic, 1)->Name("ConflictDetection/WordBitsetConflictSet/realistic");
\ No newline at end of file
+BENCHMARK_TEMPLATE(bench_ConflictDetection_Realistic, 1)->Name("ConflictDetection/WordBitsetConflictSet/realistic");
+
+// Conflict set engines, with short and long shared key prefixes
+BENCHMARK_TEMPLATE(bench_ConflictSet_detectConflicts, ConflictSetType::SkipList, 0)
+    ->Name("ConflictSet/SkipList/detectConflicts/short_prefix");
+BENCHMARK_TEMPLATE(bench_ConflictSet_detectConflicts, ConflictSetType::BTree, 0)
+    ->Name("ConflictSet/BTree/detectConflicts/short_prefix");
+BENCHMARK_TEMPLATE(bench_ConflictSet_detectConflicts, ConflictSetType::SkipList, 24)
+    ->Name("ConflictSet/SkipList/detectConflicts/long_prefix");
+BENCHMARK_TEMPLATE(bench_ConflictSet_detectConflicts, ConflictSetType::BTree, 24)
+    ->Name("ConflictSet/BTree/detectConflicts/long_prefix");
@@ -0,0 +1,146 @@
+/*
+ * BenchPeekCursorMerge.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/CommitTransaction.h"
+#include "fdbclient/FDBTypes.h"
+#include "fdbserver/PeekCursorReplicas.h"
+#include "flow/Arena.h"
+#include "flow/IRandom.h"
+
+#include <memory>
+#include <vector>
+
+namespace {
+
+// Reads the messages of a peek reply like a ServerPeekCursor: each version starts with a VERSION_HEADER, and each
+// message has its length first. Advancing to a later version skips the messages in between by their lengths.
+class ReplicaCursor {
+public:
+	explicit ReplicaCursor(StringRef data) : data(data), position(0), hasMsg(true) { nextMessage(); }
+	virtual ~ReplicaCursor() = default;
+
+	virtual bool hasMessage() const { return hasMsg; }
+	virtual const LogMessageVersion& version() const { return messageVersion; }
+	virtual StringRef getMessage() const { return message; }
+
+	virtual void nextMessage() {
+		if (position == data.size()) {
+			messageVersion.reset(messageVersion.version + 1);
+			hasMsg = false;
+			return;
+		}
+		if (*(const int32_t*)(data.begin() + position) == VERSION_HEADER) {
+			messageVersion.reset(*(const Version*)(data.begin() + position + sizeof(int32_t)));
+			position += sizeof(int32_t) + sizeof(Version);
+		} else {
+			messageVersion.sub++;
+		}
+		const int32_t length = *(const int32_t*)(data.begin() + position);
+		message = data.substr(position + sizeof(int32_t), length);
+		position += sizeof(int32_t) + length;
+	}
+
+	virtual void advanceTo(LogMessageVersion n) {
+		if (hasMessage() && messageVersion.version < n.version) {
+			while (position < data.size()) {
+				const int32_t length = *(const int32_t*)(data.begin() + position);
+				if (length == VERSION_HEADER) {
+					if (*(const Version*)(data.begin() + position + sizeof(int32_t)) >= n.version) {
+						break;
+					}
+					position += sizeof(int32_t) + sizeof(Version);
+				} else {
+					position += sizeof(int32_t) + length;
+				}
+			}
+			nextMessage();
+		}
+		while (messageVersion < n && hasMessage()) {
+			nextMessage();
+		}
+		if (!hasMessage() && messageVersion < n) {
+			messageVersion = n;
+		}
+	}
+
+private:
+	StringRef data;
+	int position;
+	bool hasMsg;
+	LogMessageVersion messageVersion;
+	StringRef message;
+};
+
+Standalone<StringRef> makeReply(int versions, int messagesPerVersion) {
+	BinaryWriter wr(Unversioned());
+	for (Version v = 1; v <= versions; v++) {
+		wr << VERSION_HEADER << v;
+		for (int m = 0; m < messagesPerVersion; m++) {
+			const int length = deterministicRandom()->randomInt(16, 128);
+			wr << int32_t(length);
+			wr.serializeBytes(std::string(length, 'm'));
+		}
+	}
+	return wr.toValue();
+}
+
+} // namespace
+
+// Reads every message of a tag replicated on state.range(0) TLogs with state.range(1) messages per version through the
+// best server's cursor, keeping the other cursors at the message read (state.range(2) == 0) like MergedPeekCursor did,
+// or at its version (state.range(2) == 1) with advanceReplicaCursors().
+static void bench_peekCursorMerge(benchmark::State& state) {
+	const int servers = state.range(0);
+	const int messagesPerVersion = state.range(1);
+	const bool perVersion = state.range(2);
+	const Standalone<StringRef> reply = makeReply(100000 / messagesPerVersion, messagesPerVersion);
+	int64_t messages = 0;
+	for (auto _ : state) {
+		std::vector<std::unique_ptr<ReplicaCursor>> cursors;
+		for (int i = 0; i < servers; i++) {
+			cursors.push_back(std::make_unique<ReplicaCursor>(reply));
+		}
+		ReplicaCursor& best = *cursors[0];
+		LogMessageVersion messageVersion;
+		int64_t bytes = 0;
+		while (best.hasMessage()) {
+			const LogMessageVersion previousVersion = messageVersion;
+			messageVersion = best.version();
+			if (perVersion) {
+				advanceReplicaCursors(cursors, previousVersion, messageVersion);
+			} else {
+				for (auto& c : cursors) {
+					c->advanceTo(messageVersion);
+				}
+			}
+			bytes += best.getMessage().size();
+			best.nextMessage();
+			++messages;
+		}
+		benchmark::DoNotOptimize(bytes);
+	}
+	state.SetItemsProcessed(messages);
+}
+
+BENCHMARK(bench_peekCursorMerge)
+    ->ArgsProduct({ { 3, 12, 24 }, { 1, 20 }, { 0, 1 } })
+    ->ReportAggregatesOnly(true);
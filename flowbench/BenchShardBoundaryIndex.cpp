@@ -0,0 +1,113 @@
+/*
+ * BenchShardBoundaryIndex.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/KeyRangeMap.h"
+#include "fdbserver/ShardBoundaryIndex.h"
+#include "flow/IRandom.h"
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+// A key of a layered application: a directory prefix shared by many shards, then a record id and a field.
+// Shard boundaries are cut at record ids, mutations touch fields of records.
+static Key randomApplicationKey(bool field) {
+	std::string key = "\x15";
+	key.push_back(char(deterministicRandom()->randomInt(0, 20))); // directory
+	key += "\x02records\x00\x02"_sr.toString();
+	key += format("%016llx", deterministicRandom()->randomUInt64());
+	if (field) {
+		key += "\x00\x02"_sr.toString();
+		key += deterministicRandom()->randomAlphaNumeric(deterministicRandom()->randomInt(4, 12));
+	}
+	return Key(StringRef(key));
+}
+
+// Splits the key space into about shardCount shards like a large cluster's keyServers
+static void populateShards(KeyRangeMap<int>& map, int shardCount) {
+	std::vector<Key> boundaries;
+	boundaries.reserve(shardCount);
+	for (int i = 0; i < shardCount; i++) {
+		boundaries.push_back(randomApplicationKey(false));
+	}
+	std::sort(boundaries.begin(), boundaries.end());
+	std::vector<std::pair<MapPair<Key, int>, int>> pairs;
+	pairs.emplace_back(MapPair<Key, int>(Key(), 0), 1);
+	for (int i = 0; i < boundaries.size(); i++) {
+		pairs.emplace_back(MapPair<Key, int>(boundaries[i], i + 1), 1);
+	}
+	map.rawInsert(pairs);
+}
+
+static std::vector<Key> randomLookupKeys() {
+	std::vector<Key> keys;
+	for (int i = 0; i < 10000; i++) {
+		keys.push_back(randomApplicationKey(true));
+	}
+	return keys;
+}
+
+static void bench_keyRangeMap_rangeContaining(benchmark::State& state) {
+	KeyRangeMap<int> map;
+	populateShards(map, state.range(0));
+	const std::vector<Key> keys = randomLookupKeys();
+	for (auto _ : state) {
+		for (const auto& key : keys) {
+			benchmark::DoNotOptimize(map.rangeContaining(key));
+		}
+	}
+	state.SetItemsProcessed(keys.size() * static_cast<long>(state.iterations()));
+}
+
+static void bench_shardBoundaryIndex_rangeContaining(benchmark::State& state) {
+	KeyRangeMap<int> map;
+	populateShards(map, state.range(0));
+	ShardBoundaryIndex<int> index;
+	index.update(map);
+	const std::vector<Key> keys = randomLookupKeys();
+	for (auto _ : state) {
+		for (const auto& key : keys) {
+			benchmark::DoNotOptimize(index.rangeContaining(key));
+		}
+	}
+	state.SetItemsProcessed(keys.size() * static_cast<long>(state.iterations()));
+}
+
+// The cost of catching up with a shard split, as done by the first commit batch after a keyServers change
+static void bench_shardBoundaryIndex_update(benchmark::State& state) {
+	KeyRangeMap<int> map;
+	populateShards(map, state.range(0));
+	ShardBoundaryIndex<int> index;
+	index.update(map);
+	for (auto _ : state) {
+		KeyRange range = singleKeyRange(randomApplicationKey(false));
+		map.insert(range, 0);
+		index.invalidate(range);
+		index.update(map);
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()));
+}
+
+BENCHMARK(bench_keyRangeMap_rangeContaining)->Arg(1000)->Arg(100000)->ReportAggregatesOnly(true);
+BENCHMARK(bench_shardBoundaryIndex_rangeContaining)->Arg(1000)->Arg(100000)->ReportAggregatesOnly(true);
+BENCHMARK(bench_shardBoundaryIndex_update)->Arg(1000)->Arg(100000)->ReportAggregatesOnly(true);
@@ -0,0 +1,141 @@
+/*
+ * BenchTagQueueMerger.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbserver/TagQueueMerger.h"
+#include "flow/DeterministicRandom.h"
+#include "flow/flow.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace {
+
+// A GRV request arriving at a GRV proxy
+struct GrvArrival {
+	double time;
+	int tag;
+	int transactionCount;
+};
+
+// Loads the GRV arrivals to replay, ordered by time. With BM_GRV_TRACE set, they are read from that file, with one
+// "<seconds> <tag> <transactions>" line per GetReadVersionRequest, as can be extracted from the TransactionDebug or
+// client trace events of a cluster. Otherwise one second of 500k requests over 1000 tags with zipfian popularity is
+// generated.
+std::vector<GrvArrival> loadArrivals() {
+	std::vector<GrvArrival> arrivals;
+	char* traceFileName = std::getenv("BM_GRV_TRACE");
+	if (traceFileName) {
+		std::ifstream file(traceFileName);
+		std::unordered_map<std::string, int> tags;
+		GrvArrival arrival;
+		std::string tag;
+		while (file >> arrival.time >> tag >> arrival.transactionCount) {
+			arrival.tag = tags.emplace(tag, tags.size()).first->second;
+			arrivals.push_back(arrival);
+		}
+		std::printf("Load GRV trace %s: %zu requests, %zu tags\n", traceFileName, arrivals.size(), tags.size());
+		return arrivals;
+	}
+
+	DeterministicRandom random(0x1234567, true);
+	const int tagCount = 1000;
+	std::vector<double> popularity;
+	double total = 0;
+	for (int i = 0; i < tagCount; i++) {
+		total += 1.0 / (i + 1);
+		popularity.push_back(total);
+	}
+	double time = 0;
+	for (int i = 0; i < 500000; i++) {
+		time += -std::log(1.0 - random.random01()) / 500000;
+		const int tag =
+		    std::upper_bound(popularity.begin(), popularity.end(), random.random01() * total) - popularity.begin();
+		arrivals.push_back(GrvArrival{ time, std::min(tag, tagCount - 1), random.randomInt(1, 4) });
+	}
+	return arrivals;
+}
+
+const std::vector<GrvArrival>& arrivals() {
+	static std::vector<GrvArrival> arrivals = loadArrivals();
+	return arrivals;
+}
+
+struct QueuedRequest {
+	uint64_t sequenceNumber;
+	int transactionCount;
+};
+
+struct TagQueue {
+	Deque<QueuedRequest> requests;
+	double budget = 0;
+};
+
+} // namespace
+
+// Replays the GRV arrivals through per tag queues released once per GRV batch interval like the GrvProxyTagThrottler,
+// with every tag limited to state.range(0) transactions per second, or unlimited if 0.
+static void bench_tagQueueMerger_replay(benchmark::State& state) {
+	const double tagRate = state.range(0);
+	const double interval = 0.001;
+	const auto& trace = arrivals();
+	int64_t released = 0;
+	for (auto _ : state) {
+		std::vector<TagQueue> queues;
+		TagQueueMerger<TagQueue> merger;
+		uint64_t sequenceNumber = 0;
+		size_t next = 0;
+		for (double time = interval; next < trace.size(); time += interval) {
+			for (; next < trace.size() && trace[next].time < time; next++) {
+				if (trace[next].tag >= queues.size()) {
+					queues.resize(trace[next].tag + 1);
+				}
+				queues[trace[next].tag].requests.push_back(
+				    QueuedRequest{ ++sequenceNumber, trace[next].transactionCount });
+			}
+			for (auto& queue : queues) {
+				queue.budget = tagRate > 0 ? std::min(queue.budget + tagRate * interval, tagRate) : 0;
+				merger.add(queue);
+			}
+			merger.release([&](TagQueue& queue) {
+				const int count = queue.requests.front().transactionCount;
+				if (tagRate > 0) {
+					if (queue.budget < count) {
+						return false;
+					}
+					queue.budget -= count;
+				}
+				queue.requests.pop_front();
+				++released;
+				return true;
+			});
+		}
+	}
+	state.SetItemsProcessed(released);
+}
+
+BENCHMARK(bench_tagQueueMerger_replay)->Arg(0)->Arg(100)->Arg(10000)->ReportAggregatesOnly(true);
@@ -0,0 +1,179 @@
+/*
+ * BenchVersionedMap.cpp
+ *
+ * This source file is part of the FoundationDB open source project
+ *
+ * Copyright 2013-2026 Apple Inc. and the FoundationDB project authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "benchmark/benchmark.h"
+
+#include "fdbclient/FDBTypes.h"
+#include "fdbclient/VersionedMap.h"
+#include "flow/Arena.h"
+#include "flow/IRandom.h"
+
+#include <unordered_set>
+#include <vector>
+
+namespace {
+
+// The storage server's versioned data
+using VersionedData = VersionedMap<KeyRef, ValueOrClearToRef>;
+
+constexpr int mapKeys = 100000;
+// Versions kept, like the storage server keeps the versions it has not made durable
+constexpr int keptVersions = 100;
+
+Standalone<VectorRef<KeyRef>> makeKeys(int count) {
+	Standalone<VectorRef<KeyRef>> keys;
+	keys.reserve(keys.arena(), count);
+	for (int i = 0; i < count; i++) {
+		keys.push_back_deep(keys.arena(), StringRef(deterministicRandom()->randomAlphaNumeric(24)));
+	}
+	return keys;
+}
+
+// Inserts the keys, keysPerVersion of them at each version, and forgets the versions older than keptVersions
+void fill(VersionedData& map, VectorRef<KeyRef> keys, int keysPerVersion) {
+	const ValueOrClearToRef value = ValueOrClearToRef::value("value"_sr);
+	Version v = map.getLatestVersion();
+	for (int i = 0; i < keys.size(); i++) {
+		if (i % keysPerVersion == 0) {
+			map.createNewVersion(++v);
+			if (v > keptVersions) {
+				map.forgetVersionsBefore(v - keptVersions);
+			}
+		}
+		map.insert(keys[i], value);
+	}
+}
+
+// The bytes allocated for the nodes the versions in [begin, end] kept by map reference
+int64_t nodeBytes(VersionedData const& map, Version begin = 0, Version end = MAX_VERSION) {
+	std::unordered_set<void const*> seen;
+	int64_t bytes = 0;
+	for (auto const& root : map.roots) {
+		if (root.first < begin || root.first > end) {
+			continue;
+		}
+		std::vector<VersionedData::PTreeT const*> nodes{ root.second.getPtr() };
+		while (!nodes.empty()) {
+			VersionedData::PTreeT const* n = nodes.back();
+			nodes.pop_back();
+			if (n && seen.insert(n).second) {
+				bytes += std::max(64, nextFastAllocatedSize(sizeof(VersionedData::PTreeT)));
+				for (auto const& p : n->pointer) {
+					nodes.push_back(p.getPtr());
+				}
+			}
+		}
+	}
+	for (auto const& root : map.btreeRoots) {
+		if (root.first < begin || root.first > end) {
+			continue;
+		}
+		std::vector<VersionedData::PBTreeT const*> nodes{ root.second.getPtr() };
+		while (!nodes.empty()) {
+			VersionedData::PBTreeT const* n = nodes.back();
+			nodes.pop_back();
+			if (!n || !seen.insert(n).second) {
+				continue;
+			}
+			if (n->leaf) {
+				bytes += nextFastAllocatedSize(sizeof(*n->asLeaf()));
+			} else {
+				bytes += nextFastAllocatedSize(sizeof(*n->asInternal()));
+				for (int c = 0; c < n->count; c++) {
+					nodes.push_back(n->asInternal()->children[c].getPtr());
+				}
+			}
+		}
+	}
+	return bytes;
+}
+
+// The version of the oldest root map keeps
+Version oldestRoot(VersionedData const& map) {
+	return map.btreeRoots.empty() ? map.roots.front().first : map.btreeRoots.front().first;
+}
+
+} // namespace
+
+// Inserts mapKeys keys into a PTree (state.range(0) == 0) or PBTree (state.range(0) == 1) versioned map, with
+// state.range(1) keys per version. Reports the node bytes per key of the latest version, and the node bytes each
+// insert of the kept versions added on top of the oldest one, which is what the storage server pays per mutation
+// until it makes the version durable.
+static void bench_versionedMapInsert(benchmark::State& state) {
+	const bool btree = state.range(0);
+	const int keysPerVersion = state.range(1);
+	const Standalone<VectorRef<KeyRef>> keys = makeKeys(mapKeys);
+	int64_t bytes = 0;
+	int64_t writeBytes = 0;
+	int64_t writes = 0;
+	for (auto _ : state) {
+		VersionedData map(btree);
+		fill(map, keys, keysPerVersion);
+		state.PauseTiming();
+		const Version oldest = oldestRoot(map);
+		bytes = nodeBytes(map, map.getLatestVersion());
+		writeBytes = nodeBytes(map) - nodeBytes(map, 0, oldest);
+		writes = (map.getLatestVersion() - oldest) * keysPerVersion;
+		state.ResumeTiming();
+	}
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * mapKeys);
+	state.counters["BytesPerKey"] = double(bytes) / mapKeys;
+	state.counters["BytesPerWrite"] = double(writeBytes) / std::max<int64_t>(writes, 1);
+}
+
+// Looks up random keys, half of them present, at the latest version
+static void bench_versionedMapSeek(benchmark::State& state) {
+	const bool btree = state.range(0);
+	const Standalone<VectorRef<KeyRef>> keys = makeKeys(mapKeys);
+	const Standalone<VectorRef<KeyRef>> missing = makeKeys(mapKeys);
+	VersionedData map(btree);
+	fill(map, keys, state.range(1));
+	int64_t found = 0;
+	for (auto _ : state) {
+		const int i = deterministicRandom()->randomInt(0, mapKeys);
+		auto view = map.atLatest();
+		found += view.find(i % 2 ? keys[i] : missing[i]) != view.end();
+		benchmark::DoNotOptimize(view.lastLessOrEqual(missing[i]));
+	}
+	benchmark::DoNotOptimize(found);
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * 2);
+}
+
+// Reads 1000 entries from a random key at the latest version
+static void bench_versionedMapScan(benchmark::State& state) {
+	const bool btree = state.range(0);
+	const Standalone<VectorRef<KeyRef>> keys = makeKeys(mapKeys);
+	VersionedData map(btree);
+	fill(map, keys, state.range(1));
+	int64_t bytes = 0;
+	for (auto _ : state) {
+		auto view = map.atLatest();
+		auto it = view.lower_bound(keys[deterministicRandom()->randomInt(0, mapKeys)]);
+		for (int n = 0; n < 1000 && it != view.end(); n++, ++it) {
+			bytes += it.key().size() + it->getValue().size();
+		}
+	}
+	benchmark::DoNotOptimize(bytes);
+	state.SetItemsProcessed(static_cast<long>(state.iterations()) * 1000);
+}
+
+BENCHMARK(bench_versionedMapInsert)->ArgsProduct({ { 0, 1 }, { 1, 10, 1000 } })->ReportAggregatesOnly(true);
+BENCHMARK(bench_versionedMapSeek)->ArgsProduct({ { 0, 1 }, { 1000 } })->ReportAggregatesOnly(true);
+BENCHMARK(bench_versionedMapScan)->ArgsProduct({ { 0, 1 }, { 1000 } })->ReportAggregatesOnly(true);